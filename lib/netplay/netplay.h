@@ -29,6 +29,7 @@
 #include "lib/framework/crc.h"
 #include "nettypes.h"
 #include <physfs.h>
+#include <type_traits>
 
 // Lobby Connection errors
 
@@ -274,7 +275,7 @@ extern char iptoconnect[PATH_MAX]; // holds IP/hostname from command line
 // ////////////////////////////////////////////////////////////////////////
 // functions available to you.
 int NETinit(bool bFirstCall);
-WZ_DECL_NONNULL(2) bool NETsend(NETQUEUE queue, NetMessage const *message);   ///< send to player, or broadcast if player == NET_ALL_PLAYERS.
+bool NETsend(NETQUEUE queue, NetMessageRef message);   ///< send to player, or broadcast if player == NET_ALL_PLAYERS.
 WZ_DECL_NONNULL(1, 2) bool NETrecvNet(NETQUEUE *queue, uint8_t *type);        ///< recv a message from the net queues if possible.
 WZ_DECL_NONNULL(1, 2) bool NETrecvGame(NETQUEUE *queue, uint8_t *type);       ///< recv a message from the game queues which is sceduled to execute by time, if possible.
 void NETflush();                                                              ///< Flushes any data stuck in compression buffers.
@@ -335,15 +336,53 @@ bool NETcheckPlayerConnectionStatus(CONNECTION_STATUS status, unsigned player);
 const char *messageTypeToString(unsigned messageType);
 
 /// Sync debugging. Only prints anything, if different players would print different things.
-#define syncDebug(...) do { _syncDebug(__FUNCTION__, __VA_ARGS__); } while(0)
+/// If all the arguments are ints (or smaller), they are stored and CRCed without formatting, and only formatted if there is a desynch.
+/// The if (false) is just so that the compiler still checks the format string.
+#define syncDebug(...) do { if (false) { _syncDebug(__FUNCTION__, __VA_ARGS__); } _syncDebugArgs(__FUNCTION__, __VA_ARGS__); } while(0)
 #ifdef WZ_CC_MINGW
 void _syncDebug(const char *function, const char *str, ...) WZ_DECL_FORMAT(__MINGW_PRINTF_FORMAT, 2, 3);
 #else
 void _syncDebug(const char *function, const char *str, ...) WZ_DECL_FORMAT(printf, 2, 3);
 #endif
 
+/// Same as _syncDebug(function, str), for syncDebug calls with nothing to format, except for "%%".
+void _syncDebugNoArgs(const char *function, const char *str);
+
 /// Faster than syncDebug. Make sure that str is a format string that takes ints only.
 void _syncDebugIntList(const char *function, const char *str, int *ints, size_t numInts);
+/// Same as _syncDebugIntList, except that the function and str are included in the CRC too, like for syncDebug.
+void _syncDebugInts(const char *function, const char *str, int *ints, size_t numInts);
+
+#define SYNC_DEBUG_MAX_INTS 40  ///< Maximum number of ints in a _syncDebugIntList or _syncDebugInts call.
+
+template<typename... T> struct SyncDebugIntArgs;
+template<> struct SyncDebugIntArgs<>
+{
+	static const bool value = true;
+};
+template<typename T, typename... Rest> struct SyncDebugIntArgs<T, Rest...>
+{
+	static const bool value = (std::is_integral<T>::value || std::is_enum<T>::value) && sizeof(T) <= sizeof(int) && SyncDebugIntArgs<Rest...>::value;
+};
+
+template<typename... T>
+static inline typename std::enable_if<SyncDebugIntArgs<T...>::value && (sizeof...(T) > 0) && sizeof...(T) <= SYNC_DEBUG_MAX_INTS>::type _syncDebugArgs(const char *function, const char *str, T... args)
+{
+	int ints[] = {int(args)..., 0};  // Extra 0, since arrays can't have size 0.
+	_syncDebugInts(function, str, ints, sizeof...(T));
+}
+
+template<typename... T>
+static inline typename std::enable_if<!(SyncDebugIntArgs<T...>::value && sizeof...(T) <= SYNC_DEBUG_MAX_INTS) && (sizeof...(T) > 0)>::type _syncDebugArgs(const char *function, const char *str, T... args)
+{
+	_syncDebug(function, str, args...);
+}
+
+static inline void _syncDebugArgs(const char *function, const char *str)
+{
+	_syncDebugNoArgs(function, str);
+}
+
 #define syncDebugBacktrace() do { _syncDebugBacktrace(__FUNCTION__); } while(0)
 void _syncDebugBacktrace(const char *function);                  ///< Adds a backtrace to syncDebug, if the platform supports it. Can be a bit slow, don't call way too often, unless desperate.
 uint32_t syncDebugGetCrc();                                      ///< syncDebug() calls between uint32_t crc = syncDebugGetCrc(); and syncDebugSetCrc(crc); appear in synch debug logs, but without triggering a desynch if different.
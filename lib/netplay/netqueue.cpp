@@ -100,72 +100,79 @@ bool decode_uint32_t(uint8_t b, uint32_t &v, unsigned n)
 	return !isLastByte;
 }
 
-uint8_t *NetMessage::rawDataDup() const
+size_t NetMessage::rawLen() const
 {
-	unsigned encodedLengthOfSize = encodedlength_uint32_t(data.size());
-
-	uint8_t *ret = new uint8_t[1 + encodedLengthOfSize + data.size()];
-
-	ret[0] = type;
+	return 1 + encodedlength_uint32_t(data.size()) + data.size();
+}
 
-	uint32_t len = data.size();
-	for (unsigned n = 0; n < encodedLengthOfSize; ++n)
+/// Returns the length of the message at the start of data, including the type and the encoded length, or 0 if the encoded
+/// length isn't all there yet. The length of the type and the encoded length is returned in headerLen.
+static size_t rawMessageLength(const uint8_t *data, size_t size, unsigned &headerLen)
+{
+	uint32_t len = 0;
+	bool moreBytes = true;
+	unsigned n;
+	for (n = 0; moreBytes && size > 1 + n; ++n)
 	{
-		encode_uint32_t(ret[n + 1], len, n);
+		moreBytes = decode_uint32_t(data[1 + n], len, n);
+	}
+	if (moreBytes)
+	{
+		return 0;
 	}
 
-	std::copy(data.begin(), data.end(), ret + 1 + encodedLengthOfSize);
-	return ret;
-}
-
-size_t NetMessage::rawLen() const
-{
-	return 1 + encodedlength_uint32_t(data.size()) + data.size();
+	headerLen = 1 + n;
+	ASSERT(len < 40000000, "Trying to write a very large packet (%u bytes) to the queue.", len);
+	return headerLen + len;
 }
 
 NetQueue::NetQueue()
 	: canGetMessagesForNet(true)
 	, canGetMessages(true)
+	, dataPos(0)
+	, messagePos(0)
 {
-	dataPos = messages.end();
-	messagePos = messages.end();
+	spareChunk.capacity = 0;
+	spareChunk.used = 0;
 }
 
 void NetQueue::writeRawData(const uint8_t *netData, size_t netLen)
 {
 	size_t used = 0;
 	std::vector<uint8_t> &buffer = incompleteReceivedMessageData;  // Short alias.
+	unsigned headerLen;
 
-	// Insert the data.
-	buffer.insert(buffer.end(), netData, netData + netLen);
-
-	// Extract the messages.
-	while (buffer.size() - used > 1)
+	// Finish the message which was incomplete in the last data from the network, if any.
+	while (!buffer.empty() && used < netLen)
 	{
-		uint8_t type = buffer[used];
-
-		uint32_t len = 0;
-		bool moreBytes = true;
-		unsigned n;
-		for (n = 0; moreBytes && buffer.size() - used > 1 + n; ++n)
+		size_t len = rawMessageLength(&buffer[0], buffer.size(), headerLen);
+		size_t missing = len != 0 ? len - buffer.size() : 1;  // If the length isn't known yet, get one more byte of it.
+		size_t have = std::min(missing, netLen - used);
+		buffer.insert(buffer.end(), netData + used, netData + used + have);
+		used += have;
+
+		len = rawMessageLength(&buffer[0], buffer.size(), headerLen);
+		if (len != 0 && len == buffer.size())
 		{
-			moreBytes = decode_uint32_t(buffer[used + 1 + n], len, n);
+			pushRawMessage(&buffer[0], len, headerLen);
+			buffer.clear();
 		}
-		unsigned headerLen = 1 + n;
+	}
 
-		ASSERT(len < 40000000, "Trying to write a very large packet (%u bytes) to the queue.", len);
-		if (buffer.size() - used - headerLen < len)
+	// Extract the messages, straight from the network data.
+	while (used < netLen)
+	{
+		size_t len = rawMessageLength(netData + used, netLen - used, headerLen);
+		if (len == 0 || len > netLen - used)
 		{
 			break;  // Don't have a whole message ready yet.
 		}
-
-		messages.push_front(NetMessage(type));
-		messages.front().data.assign(buffer.begin() + used + headerLen, buffer.begin() + used + headerLen + len);
-		used += headerLen + len;
+		pushRawMessage(netData + used, len, headerLen);
+		used += len;
 	}
 
-	// Recycle old data.
-	buffer.erase(buffer.begin(), buffer.begin() + used);
+	// Keep the start of the next message for later.
+	buffer.insert(buffer.end(), netData + used, netData + netLen);
 }
 
 void NetQueue::setWillNeverGetMessagesForNet()
@@ -175,36 +182,25 @@ void NetQueue::setWillNeverGetMessagesForNet()
 
 unsigned NetQueue::numMessagesForNet() const
 {
-	unsigned count = 0;
-	if (canGetMessagesForNet)
-	{
-		for (List::iterator i = dataPos; i != messages.begin(); --i)
-		{
-			++count;
-		}
-	}
-
-	return count;
+	return canGetMessagesForNet ? messages.size() - dataPos : 0;
 }
 
-const NetMessage &NetQueue::getMessageForNet() const
+NetMessageRef NetQueue::getMessageForNet() const
 {
 	ASSERT(canGetMessagesForNet, "Wrong NetQueue type for getMessageForNet.");
-	ASSERT(dataPos != messages.begin(), "No message to get!");
+	ASSERT(dataPos < messages.size(), "No message to get!");
 
 	// Return the message.
-	List::iterator i = dataPos;
-	--i;
-	return *i;
+	return messageRef(dataPos);
 }
 
 void NetQueue::popMessageForNet()
 {
 	ASSERT(canGetMessagesForNet, "Wrong NetQueue type for popMessageForNet.");
-	ASSERT(dataPos != messages.begin(), "No message to pop!");
+	ASSERT(dataPos < messages.size(), "No message to pop!");
 
 	// Pop the message.
-	--dataPos;
+	++dataPos;
 
 	// Recycle old data.
 	popOldMessages();
@@ -212,7 +208,62 @@ void NetQueue::popMessageForNet()
 
 void NetQueue::pushMessage(const NetMessage &message)
 {
-	messages.push_front(message);
+	unsigned encodedLengthOfSize = encodedlength_uint32_t(message.data.size());
+	size_t rawLen = 1 + encodedLengthOfSize + message.data.size();
+	uint8_t *raw = allocate(rawLen);
+
+	raw[0] = message.type;
+
+	uint32_t len = message.data.size();
+	for (unsigned n = 0; n < encodedLengthOfSize; ++n)
+	{
+		encode_uint32_t(raw[n + 1], len, n);
+	}
+
+	std::copy(message.data.begin(), message.data.end(), raw + 1 + encodedLengthOfSize);
+
+	Message stored = {raw, uint32_t(rawLen), uint8_t(1 + encodedLengthOfSize)};
+	messages.push_back(stored);
+}
+
+void NetQueue::pushRawMessage(const uint8_t *raw, size_t rawLen, unsigned headerLen)
+{
+	uint8_t *copy = allocate(rawLen);
+	std::copy(raw, raw + rawLen, copy);
+
+	Message stored = {copy, uint32_t(rawLen), uint8_t(headerLen)};
+	messages.push_back(stored);
+}
+
+uint8_t *NetQueue::allocate(size_t size)
+{
+	if (chunks.empty() || chunks.back().capacity - chunks.back().used < size)
+	{
+		if (spareChunk.capacity >= size)
+		{
+			chunks.push_back(std::move(spareChunk));
+			spareChunk.capacity = 0;
+		}
+		else
+		{
+			Chunk chunk;
+			chunk.capacity = std::max<size_t>(size, NETQUEUE_CHUNK_SIZE);
+			chunk.data.reset(new uint8_t[chunk.capacity]);
+			chunks.push_back(std::move(chunk));
+		}
+		chunks.back().used = 0;
+	}
+
+	Chunk &chunk = chunks.back();
+	uint8_t *ret = chunk.data.get() + chunk.used;
+	chunk.used += size;
+	return ret;
+}
+
+NetMessageRef NetQueue::messageRef(size_t index) const
+{
+	Message const &message = messages[index];
+	return NetMessageRef(message.raw[0], message.raw, message.rawLen, message.headerLen);
 }
 
 void NetQueue::setWillNeverGetMessages()
@@ -223,27 +274,25 @@ void NetQueue::setWillNeverGetMessages()
 bool NetQueue::haveMessage() const
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for haveMessage.");
-	return messagePos != messages.begin();
+	return messagePos < messages.size();
 }
 
-const NetMessage &NetQueue::getMessage() const
+NetMessageRef NetQueue::getMessage() const
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for getMessage.");
-	ASSERT(messagePos != messages.begin(), "No message to get!");
+	ASSERT(messagePos < messages.size(), "No message to get!");
 
 	// Return the message.
-	List::iterator i = messagePos;
-	--i;
-	return *i;
+	return messageRef(messagePos);
 }
 
 void NetQueue::popMessage()
 {
 	ASSERT(canGetMessages, "Wrong NetQueue type for popMessage.");
-	ASSERT(messagePos != messages.begin(), "No message to pop!");
+	ASSERT(messagePos < messages.size(), "No message to pop!");
 
 	// Pop the message.
-	--messagePos;
+	++messagePos;
 
 	// Recycle old data.
 	popOldMessages();
@@ -253,27 +302,35 @@ void NetQueue::popOldMessages()
 {
 	if (!canGetMessagesForNet)
 	{
-		dataPos = messages.begin();
+		dataPos = messages.size();
 	}
 	if (!canGetMessages)
 	{
-		messagePos = messages.begin();
+		messagePos = messages.size();
 	}
 
-	List::iterator i = messages.end();
-	while (i != dataPos && i != messagePos)
-	{
-		--i;
-	}
+	size_t numOld = std::min(dataPos, messagePos);
+	messages.erase(messages.begin(), messages.begin() + numOld);
+	dataPos -= numOld;
+	messagePos -= numOld;
 
-	if (i == dataPos)
-	{
-		dataPos = messages.end();  // Old iterator will become invalid.
-	}
-	if (i == messagePos)
+	// Recycle the chunks before the one holding the oldest message left. If there are no messages left, start the last chunk over.
+	while (!chunks.empty())
 	{
-		messagePos = messages.end();  // Old iterator will become invalid.
+		Chunk &chunk = chunks.front();
+		if (!messages.empty() && messages.front().raw >= chunk.data.get() && messages.front().raw < chunk.data.get() + chunk.capacity)
+		{
+			break;
+		}
+		if (messages.empty() && chunks.size() == 1)
+		{
+			chunk.used = 0;
+			break;
+		}
+		if (chunk.capacity == NETQUEUE_CHUNK_SIZE)
+		{
+			spareChunk = std::move(chunk);
+		}
+		chunks.pop_front();
 	}
-
-	messages.erase(i, messages.end());
 }
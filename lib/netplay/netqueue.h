@@ -26,8 +26,8 @@
 
 #include "lib/framework/frame.h"
 #include <vector>
-#include <list>
 #include <deque>
+#include <memory>
 
 // At game level:
 // There should be a NetQueue representing each client.
@@ -40,17 +40,49 @@
 // There should be a NetQueuePair per socket.
 
 
+/// Number of bytes a NetQueue allocates at a time for storing messages. Bigger messages get a chunk of their own.
+#define NETQUEUE_CHUNK_SIZE 65536
+
 /// A NetMessage consists of a type (uint8_t) and some data, the meaning of which depends on the type.
 class NetMessage
 {
 public:
 	NetMessage(uint8_t type_ = 0xFF) : type(type_) {}
-	uint8_t *rawDataDup() const;  ///< Returns data compatible with NetQueue::writeRawData(). Must be delete[]d.
-	size_t rawLen() const;        ///< Returns the length of the return value of rawDataDup().
+	size_t rawLen() const;        ///< Returns the length of the message, when sent over the network.
 	uint8_t type;
 	std::vector<uint8_t> data;
 };
 
+/// A message stored in a NetQueue, in the same format as sent over the network: the type, the encoded length of the data, then the data.
+/// Only valid until the message is popped from the NetQueue.
+class NetMessageRef
+{
+public:
+	NetMessageRef(uint8_t type_ = 0xFF, const uint8_t *raw_ = nullptr, size_t rawLen_ = 0, unsigned headerLen_ = 0) : type(type_), raw(raw_), rawSize(rawLen_), headerLen(headerLen_) {}
+	const uint8_t *rawData() const  ///< Returns data compatible with NetQueue::writeRawData().
+	{
+		return raw;
+	}
+	size_t rawLen() const           ///< Returns the length of the return value of rawData().
+	{
+		return rawSize;
+	}
+	const uint8_t *data() const
+	{
+		return raw + headerLen;
+	}
+	size_t dataLen() const
+	{
+		return rawSize - headerLen;
+	}
+	uint8_t type;
+
+private:
+	const uint8_t *raw;
+	size_t rawSize;
+	unsigned headerLen;
+};
+
 /// MessageWriter is used for serialising, using the same interface as MessageReader.
 class MessageWriter
 {
@@ -63,6 +95,10 @@ public:
 	{
 		message->data.push_back(v);
 	}
+	void bytes(const uint8_t *v, size_t size) const
+	{
+		message->data.insert(message->data.end(), v, v + size);
+	}
 	bool valid() const
 	{
 		return true;
@@ -75,22 +111,25 @@ class MessageReader
 public:
 	enum { Read, Write, Direction = Read };
 
-	MessageReader(const NetMessage *m = nullptr) : message(m), index(0) {}
-	MessageReader(const NetMessage &m) : message(&m), index(0) {}
+	MessageReader() : data(nullptr), size(0), index(0) {}
+	MessageReader(const NetMessage &m) : data(m.data.empty() ? nullptr : &m.data[0]), size(m.data.size()), index(0) {}
+	MessageReader(NetMessageRef m) : data(m.data()), size(m.dataLen()), index(0) {}
 	void byte(uint8_t &v) const
 	{
-		v = index >= message->data.size() ? 0x00 : message->data[index];
+		v = index >= size ? 0x00 : data[index];
 		++index;
 	}
 	bool valid() const
 	{
-		return index <= message->data.size();
+		return index <= size;
 	}
-	const NetMessage *message;
+	const uint8_t *data;
+	size_t size;
 	mutable size_t index;
 };
 
 /// A NetQueue is a queue of NetMessages. A NetQueue can convert the messages into a stream of bytes, which can be sent over the network, and converted back into a queue of NetMessages by the NetQueue at the other end.
+/// The messages are stored back to back in chunks of NETQUEUE_CHUNK_SIZE bytes, already in the format sent over the network, so storing a message doesn't allocate memory, and sending it doesn't copy it.
 class NetQueue
 {
 public:
@@ -101,7 +140,7 @@ public:
 	// Network related, sending
 	void setWillNeverGetMessagesForNet();                              ///< Marks that we will not be sending this data over the network.
 	unsigned numMessagesForNet() const;                                ///< Checks that we didn't mark that we will not be sending this data over the network (returns 0), and returns the number of messages to be sent.
-	const NetMessage &getMessageForNet() const;                        ///< Extracts data from the NetQueue to send over the network.
+	NetMessageRef getMessageForNet() const;                            ///< Extracts data from the NetQueue to send over the network.
 	void popMessageForNet();                                           ///< Pops the extracted data, so that future getMessageForNet calls do not return that data.
 
 	// All game clients should check game messages from all queues, including their own, and only the net messages sent to them.
@@ -110,10 +149,26 @@ public:
 	// Message related, extracting.
 	void setWillNeverGetMessages();                                    ///< Marks that we will not be reading any of the messages (only sending over the network).
 	bool haveMessage() const;                                          ///< Return true if we have a message ready to return.
-	const NetMessage &getMessage() const;                              ///< Returns a message.
+	NetMessageRef getMessage() const;                                  ///< Returns a message.
 	void popMessage();                                                 ///< Pops the last returned message.
 
 private:
+	struct Chunk
+	{
+		std::unique_ptr<uint8_t[]> data;
+		size_t capacity;
+		size_t used;
+	};
+	struct Message
+	{
+		uint8_t *raw;                                                  ///< Type, encoded length and data, as sent over the network.
+		uint32_t rawLen;
+		uint8_t headerLen;                                             ///< Length of the type and encoded length.
+	};
+
+	void pushRawMessage(const uint8_t *raw, size_t rawLen, unsigned headerLen);  ///< Adds a message to the queue, in the format sent over the network.
+	uint8_t *allocate(size_t size);                                    ///< Returns space for size bytes of messages, in the last chunk.
+	NetMessageRef messageRef(size_t index) const;                      ///< Returns the message at the given index in messages.
 	void popOldMessages();                                             ///< Pops any messages that are no longer needed.
 
 	// Disable copy constructor and assignment operator.
@@ -123,10 +178,11 @@ private:
 	bool canGetMessagesForNet;                                         ///< True if we will send the messages over the network, false if we don't.
 	bool canGetMessages;                                               ///< True if we will get the messages, false if we don't use them ourselves.
 
-	typedef std::list<NetMessage> List;
-	List::iterator                dataPos;                             ///< Last message which was sent over the network.
-	List::iterator                messagePos;                          ///< Last message which was popped.
-	List                          messages;                            ///< List of messages. Messages are added to the front and read from the back.
+	size_t                        dataPos;                             ///< Number of messages at the front of messages which were sent over the network.
+	size_t                        messagePos;                          ///< Number of messages at the front of messages which were popped.
+	std::deque<Message>           messages;                            ///< Messages, oldest first. Messages are added to the back and read from the front.
+	std::deque<Chunk>             chunks;                              ///< Memory the messages are stored in, oldest first.
+	Chunk                         spareChunk;                          ///< An empty chunk which is no longer used, kept for reusing.
 	std::vector<uint8_t>          incompleteReceivedMessageData;       ///< Data from network which has not yet formed an entire message.
 };
 
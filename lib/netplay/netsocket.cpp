@@ -81,12 +81,92 @@ struct SocketSet
 };
 
 
+/// Data waiting to be written to a socket. A ring buffer, so that removing the written data from the front is cheap.
+class SocketWriteQueue
+{
+public:
+	SocketWriteQueue() : first(0), used(0) {}
+
+	bool empty() const
+	{
+		return used == 0;
+	}
+
+	/// Adds size bytes from data to the end of the queue.
+	void append(const uint8_t *data, size_t size)
+	{
+		if (size == 0)
+		{
+			return;
+		}
+		if (used + size > buf.size())
+		{
+			// Grow to the next power of 2 which fits, and move the data to the start of the buffer.
+			size_t capacity = std::max<size_t>(buf.size(), 4096);
+			while (capacity < used + size)
+			{
+				capacity *= 2;
+			}
+			std::vector<uint8_t> newBuf(capacity);
+			const uint8_t *piece[2];
+			size_t pieceSize[2];
+			unsigned numPieces = pieces(piece, pieceSize);
+			size_t newUsed = 0;
+			for (unsigned i = 0; i < numPieces; ++i)
+			{
+				memcpy(&newBuf[newUsed], piece[i], pieceSize[i]);
+				newUsed += pieceSize[i];
+			}
+			buf.swap(newBuf);
+			first = 0;
+		}
+		size_t end = (first + used) & (buf.size() - 1);
+		size_t endSize = std::min(size, buf.size() - end);
+		memcpy(&buf[end], data, endSize);
+		memcpy(&buf[0], data + endSize, size - endSize);
+		used += size;
+	}
+
+	/// Gets the queued data as at most 2 contiguous pieces, and returns the number of pieces.
+	unsigned pieces(const uint8_t *piece[2], size_t pieceSize[2]) const
+	{
+		if (used == 0)
+		{
+			return 0;
+		}
+		piece[0] = &buf[first];
+		pieceSize[0] = std::min(used, buf.size() - first);
+		piece[1] = &buf[0];
+		pieceSize[1] = used - pieceSize[0];
+		return pieceSize[1] != 0 ? 2 : 1;
+	}
+
+	/// Removes size bytes from the start of the queue.
+	void consume(size_t size)
+	{
+		ASSERT_OR_RETURN(, size <= used, "Consuming more than queued.");
+		first = (first + size) & (buf.size() - 1);
+		used -= size;
+	}
+
+private:
+	std::vector<uint8_t> buf;  ///< Size is always 0 or a power of 2.
+	size_t first;              ///< Index of the first queued byte in buf.
+	size_t used;               ///< Number of queued bytes.
+};
+
 static WZ_MUTEX *socketThreadMutex;
 static WZ_SEMAPHORE *socketThreadSemaphore;
 static WZ_THREAD *socketThread = nullptr;
 static bool socketThreadQuit;
-typedef std::map<Socket *, std::vector<uint8_t>> SocketThreadWriteMap;
+typedef std::map<Socket *, SocketWriteQueue> SocketThreadWriteMap;
 static SocketThreadWriteMap socketThreadWrites;
+#if   defined(WZ_OS_UNIX)
+static int socketThreadWakeupFd[2] = {-1, -1};  ///< Pipe, written to for waking up the socket thread when it is waiting in poll.
+#endif
+
+static z_stream broadcastDeflate;                ///< Compresses data for writeAllBroadcast once for all sockets, released by SOCKETshutdown.
+static bool broadcastDeflateInitialised = false;
 
 
 static void socketCloseNow(Socket *sock);
@@ -364,27 +444,177 @@ static bool connectionIsOpen(Socket *sock)
 	return true;
 }
 
+/// Wakes up the socket thread if waiting in poll, so it starts writing to sockets which just got data queued. Call with socketThreadMutex locked.
+static void socketThreadWakeup()
+{
+#if   defined(WZ_OS_UNIX)
+	if (socketThreadWakeupFd[1] != -1)
+	{
+		char byte = 0;
+		ssize_t ret = write(socketThreadWakeupFd[1], &byte, 1);
+		(void)ret;  // If the pipe is full, the thread will wake up anyway.
+	}
+#endif
+}
+
+/// Queues size bytes from data for the socket thread to write to sock. Call with socketThreadMutex locked.
+static void socketThreadWrite(Socket *sock, const uint8_t *data, size_t size)
+{
+	if (socketThreadWrites.empty())
+	{
+		wzSemaphorePost(socketThreadSemaphore);
+	}
+	SocketWriteQueue &writeQueue = socketThreadWrites[sock];
+	if (writeQueue.empty())
+	{
+		socketThreadWakeup();  // The socket thread isn't waiting for this socket yet.
+	}
+	writeQueue.append(data, size);
+}
+
+/// Writes as much of the queued data to the socket as possible without blocking, using one system call.
+static ssize_t socketThreadSend(Socket *sock, SocketWriteQueue const &writeQueue)
+{
+	const uint8_t *piece[2];
+	size_t pieceSize[2];
+	unsigned numPieces = writeQueue.pieces(piece, pieceSize);
+#if   defined(WZ_OS_UNIX)
+	struct iovec iov[2];
+	for (unsigned i = 0; i < numPieces; ++i)
+	{
+		iov[i].iov_base = const_cast<uint8_t *>(piece[i]);
+		iov[i].iov_len = pieceSize[i];
+	}
+	struct msghdr msg;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = numPieces;
+	return sendmsg(sock->fd[SOCK_CONNECTION], &msg, MSG_NOSIGNAL);
+#elif defined(WZ_OS_WIN)
+	(void)numPieces;
+	return send(sock->fd[SOCK_CONNECTION], reinterpret_cast<const char *>(piece[0]), pieceSize[0], MSG_NOSIGNAL);
+#endif
+}
+
+/// Writes to a socket which is ready for writing, and removes it from socketThreadWrites if done or broken. Call with socketThreadMutex locked.
+static void socketThreadWriteReady(SocketThreadWriteMap::iterator w)
+{
+	Socket *sock = w->first;
+	SocketWriteQueue &writeQueue = w->second;
+	ASSERT(!writeQueue.empty(), "writeQueue[sock] must not be empty.");
+
+	// Write data.
+	// FIXME SOMEHOW AAARGH This send() call can't block, but unless the socket is not set to blocking (setting the socket to nonblocking had better work, or else), does anyway (at least sometimes, when someone quits). Not reproducible except in public releases.
+	ssize_t ret = socketThreadSend(sock, writeQueue);
+	if (ret != SOCKET_ERROR)
+	{
+		// Remove as much data as written.
+		writeQueue.consume(ret);
+		if (writeQueue.empty())
+		{
+			socketThreadWrites.erase(w);  // Nothing left to write, delete from pending list.
+			if (sock->deleteLater)
+			{
+				socketCloseNow(sock);
+			}
+		}
+	}
+	else
+	{
+		switch (getSockErr())
+		{
+		case EAGAIN:
+#if defined(EWOULDBLOCK) && EAGAIN != EWOULDBLOCK
+		case EWOULDBLOCK:
+#endif
+			if (!connectionIsOpen(sock))
+			{
+				debug(LOG_NET, "Socket error");
+				sock->writeError = true;
+				socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
+				if (sock->deleteLater)
+				{
+					socketCloseNow(sock);
+				}
+				break;
+			}
+		case EINTR:
+			break;
+#if defined(EPIPE)
+		case EPIPE:
+#endif
+		default:
+			sock->writeError = true;
+			socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
+			if (sock->deleteLater)
+			{
+				socketCloseNow(sock);
+			}
+			break;
+		}
+	}
+}
+
 static int socketThreadFunction(void *)
 {
+#if   defined(WZ_OS_UNIX)
+	std::vector<struct pollfd> pollFds;
+	std::vector<Socket *> pollSockets;
+#endif
+
 	wzMutexLock(socketThreadMutex);
 	while (!socketThreadQuit)
 	{
 #if   defined(WZ_OS_UNIX)
-		SOCKET maxfd = INT_MIN;
+		// Wait for the wakeup pipe, and for all sockets with data to write.
+		pollFds.clear();
+		pollSockets.clear();
+		struct pollfd wakeupFd = {socketThreadWakeupFd[0], POLLIN, 0};
+		pollFds.push_back(wakeupFd);
+		pollSockets.push_back(nullptr);
+		for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); ++i)
+		{
+			struct pollfd fd = {i->first->fd[SOCK_CONNECTION], POLLOUT, 0};
+			pollFds.push_back(fd);
+			pollSockets.push_back(i->first);
+		}
+		int timeout = socketThreadWakeupFd[0] != -1 ? -1 : 50;  // Without a wakeup pipe, check for newly queued data every 50ms.
+
+		// Check if we can write to any sockets.
+		wzMutexUnlock(socketThreadMutex);
+		int ret = poll(&pollFds[0], pollFds.size(), timeout);
+		wzMutexLock(socketThreadMutex);
+
+		if (ret > 0)
+		{
+			if (pollFds[0].revents != 0)
+			{
+				// Woken up, since data was queued for more sockets. Empty the pipe, and wait for those sockets too.
+				char bytes[64];
+				while (read(socketThreadWakeupFd[0], bytes, sizeof(bytes)) > 0) {}
+			}
+
+			// We can write to some sockets. Sockets aren't closed while they have data queued, but they may have been
+			// removed from socketThreadWrites by SOCKETshutdown after unlocking the mutex.
+			for (size_t n = 1; n < pollFds.size(); ++n)
+			{
+				SocketThreadWriteMap::iterator w = socketThreadWrites.find(pollSockets[n]);
+				if (pollFds[n].revents != 0 && w != socketThreadWrites.end())
+				{
+					socketThreadWriteReady(w);
+				}
+			}
+		}
 #elif defined(WZ_OS_WIN)
 		SOCKET maxfd = 0;
-#endif
 		fd_set fds;
 		FD_ZERO(&fds);
 		for (SocketThreadWriteMap::iterator i = socketThreadWrites.begin(); i != socketThreadWrites.end(); ++i)
 		{
-			if (!i->second.empty())
-			{
-				SOCKET fd = i->first->fd[SOCK_CONNECTION];
-				maxfd = std::max(maxfd, fd);
-				ASSERT(!FD_ISSET(fd, &fds), "Duplicate file descriptor!");  // Shouldn't be possible, but blocking in send, after select says it won't block, shouldn't be possible either.
-				FD_SET(fd, &fds);
-			}
+			SOCKET fd = i->first->fd[SOCK_CONNECTION];
+			maxfd = std::max(maxfd, fd);
+			ASSERT(!FD_ISSET(fd, &fds), "Duplicate file descriptor!");  // Shouldn't be possible, but blocking in send, after select says it won't block, shouldn't be possible either.
+			FD_SET(fd, &fds);
 		}
 		struct timeval tv = {0, 50 * 1000};
 
@@ -401,67 +631,14 @@ static int socketThreadFunction(void *)
 				SocketThreadWriteMap::iterator w = i;
 				++i;
 
-				Socket *sock = w->first;
-				std::vector<uint8_t> &writeQueue = w->second;
-				ASSERT(!writeQueue.empty(), "writeQueue[sock] must not be empty.");
-
-				if (!FD_ISSET(sock->fd[SOCK_CONNECTION], &fds))
+				if (!FD_ISSET(w->first->fd[SOCK_CONNECTION], &fds))
 				{
 					continue;  // This socket is not ready for writing, or we don't have anything to write.
 				}
-
-				// Write data.
-				// FIXME SOMEHOW AAARGH This send() call can't block, but unless the socket is not set to blocking (setting the socket to nonblocking had better work, or else), does anyway (at least sometimes, when someone quits). Not reproducible except in public releases.
-				ssize_t ret = send(sock->fd[SOCK_CONNECTION], reinterpret_cast<char *>(&writeQueue[0]), writeQueue.size(), MSG_NOSIGNAL);
-				if (ret != SOCKET_ERROR)
-				{
-					// Erase as much data as written.
-					writeQueue.erase(writeQueue.begin(), writeQueue.begin() + ret);
-					if (writeQueue.empty())
-					{
-						socketThreadWrites.erase(w);  // Nothing left to write, delete from pending list.
-						if (sock->deleteLater)
-						{
-							socketCloseNow(sock);
-						}
-					}
-				}
-				else
-				{
-					switch (getSockErr())
-					{
-					case EAGAIN:
-#if defined(EWOULDBLOCK) && EAGAIN != EWOULDBLOCK
-					case EWOULDBLOCK:
-#endif
-						if (!connectionIsOpen(sock))
-						{
-							debug(LOG_NET, "Socket error");
-							sock->writeError = true;
-							socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-							if (sock->deleteLater)
-							{
-								socketCloseNow(sock);
-							}
-							break;
-						}
-					case EINTR:
-						break;
-#if defined(EPIPE)
-					case EPIPE:
-#endif
-					default:
-						sock->writeError = true;
-						socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-						if (sock->deleteLater)
-						{
-							socketCloseNow(sock);
-						}
-						break;
-					}
-				}
+				socketThreadWriteReady(w);
 			}
 		}
+#endif
 
 		if (socketThreadWrites.empty())
 		{
@@ -575,6 +752,62 @@ bool socketReadDisconnected(Socket *sock)
 	return sock->readDisconnected;
 }
 
+/// Compresses size bytes from buf with stream, appending to outBuf, using flush as the zlib flush mode.
+static void deflateAppend(z_stream *stream, std::vector<uint8_t> *outBuf, const void *buf, size_t size, int flush)
+{
+#if ZLIB_VERNUM < 0x1252
+	// zlib < 1.2.5.2 does not support `#define ZLIB_CONST`
+	// Unfortunately, some OSes (ex. OpenBSD) ship with zlib < 1.2.5.2
+	// Workaround: cast away the const of the input, and disable the resulting -Wcast-qual warning
+	#if defined(__clang__)
+	#  pragma clang diagnostic push
+	#  pragma clang diagnostic ignored "-Wcast-qual"
+	#elif defined(__GNUC__)
+	#  pragma GCC diagnostic push
+	#  pragma GCC diagnostic ignored "-Wcast-qual"
+	#endif
+
+	// cast away the const for earlier zlib versions
+	stream->next_in = (Bytef *)buf; // -Wcast-qual
+
+	#if defined(__clang__)
+	#  pragma clang diagnostic pop
+	#elif defined(__GNUC__)
+	#  pragma GCC diagnostic pop
+	#endif
+#else
+	// zlib >= 1.2.5.2 supports ZLIB_CONST
+	stream->next_in = (const Bytef *)buf;
+#endif
+
+	stream->avail_in = size;
+	size_t start = outBuf->size();
+	uLong startTotalOut = stream->total_out;
+	// Room for compressing size bytes, plus the 6 bytes of a flush marker, which deflateBound doesn't count. Usually enough to do everything in one go, even when flushing with size 0.
+	outBuf->resize(start + deflateBound(stream, size) + 6);
+	for (;;)
+	{
+		size_t alreadyHave = start + (uLong)(stream->total_out - startTotalOut);
+		stream->next_out = (Bytef *)&(*outBuf)[alreadyHave];
+		stream->avail_out = outBuf->size() - alreadyHave;
+
+		int ret = deflate(stream, flush);
+		ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
+
+		if (stream->avail_out != 0)
+		{
+			break;
+		}
+		// Input held back by earlier Z_NO_FLUSH calls can come out now too.
+		outBuf->resize(outBuf->size() * 2);
+	}
+
+	// Remove unused part of buffer.
+	outBuf->resize(start + (uLong)(stream->total_out - startTotalOut));
+
+	ASSERT(stream->avail_in == 0, "zlib didn't compress everything!");
+}
+
 /**
  * Similar to write(2) with the exception that this function will block until
  * <em>all</em> data has been written or an error occurs.
@@ -604,63 +837,54 @@ ssize_t writeAll(Socket *sock, const void *buf, size_t size, size_t *rawByteCoun
 		if (!sock->isCompressed)
 		{
 			wzMutexLock(socketThreadMutex);
-			if (socketThreadWrites.empty())
-			{
-				wzSemaphorePost(socketThreadSemaphore);
-			}
-			std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
-			writeQueue.insert(writeQueue.end(), static_cast<char const *>(buf), static_cast<char const *>(buf) + size);
+			socketThreadWrite(sock, static_cast<uint8_t const *>(buf), size);
 			wzMutexUnlock(socketThreadMutex);
 			rawBytes = size;
 		}
 		else
 		{
-		#if ZLIB_VERNUM < 0x1252
-			// zlib < 1.2.5.2 does not support `#define ZLIB_CONST`
-			// Unfortunately, some OSes (ex. OpenBSD) ship with zlib < 1.2.5.2
-			// Workaround: cast away the const of the input, and disable the resulting -Wcast-qual warning
-			#if defined(__clang__)
-			#  pragma clang diagnostic push
-			#  pragma clang diagnostic ignored "-Wcast-qual"
-			#elif defined(__GNUC__)
-			#  pragma GCC diagnostic push
-			#  pragma GCC diagnostic ignored "-Wcast-qual"
-			#endif
-
-			// cast away the const for earlier zlib versions
-			sock->zDeflate.next_in = (Bytef *)buf; // -Wcast-qual
-
-			#if defined(__clang__)
-			#  pragma clang diagnostic pop
-			#elif defined(__GNUC__)
-			#  pragma GCC diagnostic pop
-			#endif
-		#else
-			// zlib >= 1.2.5.2 supports ZLIB_CONST
-			sock->zDeflate.next_in = (const Bytef *)buf;
-		#endif
-
-			sock->zDeflate.avail_in = size;
-			sock->zDeflateInSize += sock->zDeflate.avail_in;
-			do
-			{
-				size_t alreadyHave = sock->zDeflateOutBuf.size();
-				sock->zDeflateOutBuf.resize(alreadyHave + size + 20);  // A bit more than size should be enough to always do everything in one go.
-				sock->zDeflate.next_out = (Bytef *)&sock->zDeflateOutBuf[alreadyHave];
-				sock->zDeflate.avail_out = sock->zDeflateOutBuf.size() - alreadyHave;
+			sock->zDeflateInSize += size;
+			deflateAppend(&sock->zDeflate, &sock->zDeflateOutBuf, buf, size, Z_NO_FLUSH);
+		}
+	}
 
-				int ret = deflate(&sock->zDeflate, Z_NO_FLUSH);
-				ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
+	return size;
+}
 
-				// Remove unused part of buffer.
-				sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
-			}
-			while (sock->zDeflate.avail_out == 0);
+ssize_t writeAllBroadcast(Socket *sock, const void *buf, size_t size, std::vector<uint8_t> *compressedOnce, size_t *rawByteCount)
+{
+	if (!sock->isCompressed || size < SOCKET_COMPRESS_ONCE_MIN_SIZE || sock->fd[SOCK_CONNECTION] == INVALID_SOCKET || sock->writeError)
+	{
+		return writeAll(sock, buf, size, rawByteCount);
+	}
+	if (rawByteCount != nullptr)
+	{
+		*rawByteCount = 0;
+	}
 
-			ASSERT(sock->zDeflate.avail_in == 0, "zlib didn't compress everything!");
+	if (compressedOnce->empty())
+	{
+		// Compress the data on its own, as a raw deflate stream which is byte aligned at the end and never refers back
+		// to anything before it, so that it fits in the middle of any socket's zlib stream.
+		if (!broadcastDeflateInitialised)
+		{
+			broadcastDeflate.zalloc = Z_NULL;
+			broadcastDeflate.zfree = Z_NULL;
+			broadcastDeflate.opaque = Z_NULL;
+			int ret = deflateInit2(&broadcastDeflate, 6, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY);
+			ASSERT_OR_RETURN(writeAll(sock, buf, size, rawByteCount), ret == Z_OK, "deflateInit2 failed!");
+			broadcastDeflateInitialised = true;
 		}
+		deflateReset(&broadcastDeflate);
+		deflateAppend(&broadcastDeflate, compressedOnce, buf, size, Z_SYNC_FLUSH);
 	}
 
+	// Make the socket's own stream byte aligned and stop it from referring back to anything before the shared data,
+	// since its history won't include the shared data.
+	deflateAppend(&sock->zDeflate, &sock->zDeflateOutBuf, nullptr, 0, Z_FULL_FLUSH);
+	sock->zDeflateOutBuf.insert(sock->zDeflateOutBuf.end(), compressedOnce->begin(), compressedOnce->end());
+	sock->zDeflateInSize += size;
+
 	return size;
 }
 
@@ -699,12 +923,7 @@ void socketFlush(Socket *sock, size_t *rawByteCount)
 	}
 
 	wzMutexLock(socketThreadMutex);
-	if (socketThreadWrites.empty())
-	{
-		wzSemaphorePost(socketThreadSemaphore);
-	}
-	std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
-	writeQueue.insert(writeQueue.end(), sock->zDeflateOutBuf.begin(), sock->zDeflateOutBuf.end());
+	socketThreadWrite(sock, &sock->zDeflateOutBuf[0], sock->zDeflateOutBuf.size());
 	wzMutexUnlock(socketThreadMutex);
 
 	// Primitive network logging, uncomment to use.
@@ -1487,6 +1706,18 @@ void SOCKETinit()
 		socketThreadQuit = false;
 		socketThreadMutex = wzMutexCreate();
 		socketThreadSemaphore = wzSemaphoreCreate(0);
+#if   defined(WZ_OS_UNIX)
+		if (pipe(socketThreadWakeupFd) == 0)
+		{
+			fcntl(socketThreadWakeupFd[0], F_SETFL, fcntl(socketThreadWakeupFd[0], F_GETFL) | O_NONBLOCK);
+			fcntl(socketThreadWakeupFd[1], F_SETFL, fcntl(socketThreadWakeupFd[1], F_GETFL) | O_NONBLOCK);
+		}
+		else
+		{
+			debug(LOG_ERROR, "Failed to create socket thread wakeup pipe: %s", strSockError(getSockErr()));
+			socketThreadWakeupFd[0] = socketThreadWakeupFd[1] = -1;
+		}
+#endif
 		socketThread = wzThreadCreate(socketThreadFunction, nullptr);
 		wzThreadStart(socketThread);
 	}
@@ -1499,14 +1730,29 @@ void SOCKETshutdown()
 		wzMutexLock(socketThreadMutex);
 		socketThreadQuit = true;
 		socketThreadWrites.clear();
+		socketThreadWakeup();
 		wzMutexUnlock(socketThreadMutex);
 		wzSemaphorePost(socketThreadSemaphore);  // Wake up the thread, so it can quit.
 		wzThreadJoin(socketThread);
+#if   defined(WZ_OS_UNIX)
+		if (socketThreadWakeupFd[0] != -1)
+		{
+			close(socketThreadWakeupFd[0]);
+			close(socketThreadWakeupFd[1]);
+			socketThreadWakeupFd[0] = socketThreadWakeupFd[1] = -1;
+		}
+#endif
 		wzMutexDestroy(socketThreadMutex);
 		wzSemaphoreDestroy(socketThreadSemaphore);
 		socketThread = nullptr;
 	}
 
+	if (broadcastDeflateInitialised)
+	{
+		deflateEnd(&broadcastDeflate);
+		broadcastDeflateInitialised = false;
+	}
+
 #if defined(WZ_OS_WIN)
 	WSACleanup();
 
@@ -23,16 +23,20 @@
 
 #include "lib/framework/types.h"
 
+#include <vector>
+
 #if   defined(WZ_OS_UNIX)
 # include <arpa/inet.h>
 # include <errno.h>
 # include <fcntl.h>
 # include <netdb.h>
 # include <netinet/in.h>
+# include <poll.h>
 # include <sys/ioctl.h>
 # include <sys/socket.h>
 # include <sys/types.h>
 # include <sys/select.h>
+# include <sys/uio.h>
 # include <unistd.h>
 typedef int SOCKET;
 static const SOCKET INVALID_SOCKET = -1;
@@ -111,9 +115,12 @@ WZ_DECL_NONNULL(1, 2)
 ssize_t writeAll(Socket *sock, const void *buf, size_t size, size_t *rawByteCount = nullptr);  ///< Nonblocking write of size bytes to the Socket. All bytes will be written asynchronously, by a separate thread. Raw count of bytes (after compression) returned in rawByteCount, which will often be 0 until the socket is flushed.
 
 // Sockets, compressed.
+#define SOCKET_COMPRESS_ONCE_MIN_SIZE 1024  ///< Smallest data writeAllBroadcast compresses once for all sockets. Smaller data compresses much better with the history of each socket.
 WZ_DECL_NONNULL(1) void socketBeginCompression(Socket *sock); ///< Makes future data sent compressed, and future data received expected to be compressed.
 WZ_DECL_NONNULL(1) bool socketReadDisconnected(Socket *sock);  ///< If readNoInt returned 0, returns true if this is the result of a disconnect, or false if the input compressed data just hasn't produced any output bytes.
 WZ_DECL_NONNULL(1) void socketFlush(Socket *sock, size_t *rawByteCount = nullptr); ///< Actually sends the data written with writeAll. Only useful on compressed sockets. Note that flushing too often makes compression less effective. Raw count of bytes (after compression) returned in rawByteCount.
+WZ_DECL_NONNULL(1, 2, 4)
+ssize_t writeAllBroadcast(Socket *sock, const void *buf, size_t size, std::vector<uint8_t> *compressedOnce, size_t *rawByteCount = nullptr);  ///< Same as writeAll, for writing the same data to many sockets. Data of at least SOCKET_COMPRESS_ONCE_MIN_SIZE bytes is compressed only once, into compressedOnce, which must be empty for the first socket and passed unchanged to the rest.
 
 // Socket sets.
 WZ_DECL_ALLOCATION SocketSet *allocSocketSet();                         ///< Constructs a SocketSet.
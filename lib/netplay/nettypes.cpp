@@ -76,6 +76,16 @@ PACKETDIR NETgetPacketDir()
 	return NetDir;
 }
 
+size_t NETbytesLeft()
+{
+	return reader.index < reader.size ? reader.size - reader.index : 0;
+}
+
+bool NETdecodeValid()
+{
+	return reader.valid();
+}
+
 // The queue(q, v) functions (de)serialise the object v to/from q, depending on whether q is a MessageWriter or MessageReader.
 
 template<class Q>
@@ -390,9 +400,9 @@ bool NETisMessageReady(NETQUEUE queue)
 	return receiveQueue(queue)->haveMessage();
 }
 
-NetMessage const *NETgetMessage(NETQUEUE queue)
+NetMessageRef NETgetMessage(NETQUEUE queue)
 {
-	return &receiveQueue(queue)->getMessage();
+	return receiveQueue(queue)->getMessage();
 }
 
 /*
@@ -454,7 +464,8 @@ void NETbeginEncode(NETQUEUE queue, uint8_t type)
 	NETsetPacketDir(PACKET_ENCODE);
 
 	queueInfo = queue;
-	message = type;
+	message.type = type;
+	message.data.clear();  // Keeps the memory, for the next message.
 	writer = MessageWriter(message);
 }
 
@@ -463,10 +474,10 @@ void NETbeginDecode(NETQUEUE queue, uint8_t type)
 	NETsetPacketDir(PACKET_DECODE);
 
 	queueInfo = queue;
-	message = receiveQueue(queueInfo)->getMessage();
-	reader = MessageReader(message);
+	NetMessageRef ref = receiveQueue(queueInfo)->getMessage();
+	reader = MessageReader(ref);  // Reads straight from the queue, the message stays there until NETpop.
 
-	assert(type == message.type);
+	assert(type == ref.type);
 }
 
 bool NETend()
@@ -494,7 +505,7 @@ bool NETend()
 
 		if (queueInfo.queueType == QUEUE_NET || queueInfo.queueType == QUEUE_BROADCAST || queueInfo.queueType == QUEUE_TMP)
 		{
-			NETsend(queueInfo, &queue->getMessageForNet());
+			NETsend(queueInfo, queue->getMessageForNet());
 			queue->popMessageForNet();
 			ASSERT(queue->numMessagesForNet() == 0, "Queue not empty.");
 		}
@@ -576,7 +587,7 @@ void NETflushGameQueues()
 		NETuint32_t(&num);
 		for (uint32_t n = 0; n < num; ++n)
 		{
-			queueAuto(const_cast<NetMessage &>(queue->getMessageForNet()));  // const_cast is safe since we are encoding, not decoding.
+			NETnetMessage(queue->getMessageForNet());
 			queue->popMessageForNet();
 		}
 		NETend();
@@ -789,3 +800,11 @@ void NETnetMessage(NetMessage const **message)
 		return;
 	}
 }
+
+void NETnetMessage(NetMessageRef message)
+{
+	ASSERT_OR_RETURN(, NETgetPacketDir() == PACKET_ENCODE, "Can only encode a message from a queue.");
+
+	// The message is stored as sent over the network, which is the same as queue(writer, NetMessage &) would write.
+	writer.bytes(message.rawData(), message.rawLen());
+}
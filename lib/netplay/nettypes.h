@@ -67,7 +67,7 @@ NETQUEUE NETbroadcastQueue(unsigned excludePlayer = NET_NO_EXCLUDE);  ///< The q
 void NETinsertRawData(NETQUEUE queue, uint8_t *data, size_t dataLen);  ///< Dump raw data from sockets and raw data sent via host here.
 void NETinsertMessageFromNet(NETQUEUE queue, NetMessage const *message);     ///< Dump whole NetMessages into the queue.
 bool NETisMessageReady(NETQUEUE queue);       ///< Returns true if there is a complete message ready to deserialise in this queue.
-NetMessage const *NETgetMessage(NETQUEUE queue);///< Returns the current message in the queue which is ready to be deserialised. Do not delete the message.
+NetMessageRef NETgetMessage(NETQUEUE queue);  ///< Returns the current message in the queue which is ready to be deserialised. Only valid until popped.
 
 void NETinitQueue(NETQUEUE queue);             ///< Allocates the queue. Deletes the old queue, if there was one. Avoids a crash on NULL pointer deference when trying to use the queue.
 void NETsetNoSendOverNetwork(NETQUEUE queue);  ///< Used to mark that a game queue should not be sent over the network (for example, if it is being sent to us, instead).
@@ -96,6 +96,8 @@ void NETbin(uint8_t *str, uint32_t len);
 void NETbytes(std::vector<uint8_t> *vec, unsigned maxLen = 10000);
 
 PACKETDIR NETgetPacketDir();
+size_t NETbytesLeft();                ///< Number of bytes not yet read from the message being deserialised.
+bool NETdecodeValid();                ///< Returns false if more bytes have been read than are in the message being deserialised.
 
 template <typename EnumT>
 static void NETenum(EnumT *enumPtr)
@@ -170,5 +172,6 @@ static inline void NETauto(Vector2i *vp)
 
 
 void NETnetMessage(NetMessage const **message);  ///< If decoding, must delete the NETMESSAGE.
+void NETnetMessage(NetMessageRef message);       ///< Encodes a message stored in a queue, the same way as NETnetMessage(NetMessage const **). Encoding only.
 
 #endif
@@ -0,0 +1,113 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Storing and formatting of syncDebug calls.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/crc.h"
+
+#include "netplay.h"
+#include "syncdebug.h"
+
+uint32_t syncDebugCrcInts(uint32_t crc, char const *function, char const *str, int const *ints, size_t numInts, bool crcStrings)
+{
+	uint8_t valueBytes[4 * SYNC_DEBUG_MAX_INTS];
+	numInts = std::min<size_t>(numInts, SYNC_DEBUG_MAX_INTS);
+	for (size_t n = 0; n < numInts; ++n)
+	{
+		uint32_t value = ints[n];
+		valueBytes[4 * n + 0] = value >> 24;
+		valueBytes[4 * n + 1] = value >> 16;
+		valueBytes[4 * n + 2] = value >> 8;
+		valueBytes[4 * n + 3] = value;
+	}
+	if (crcStrings)
+	{
+		crc = crcSum(crc, function, strlen(function) + 1);
+		crc = crcSum(crc, str,      strlen(str) + 1);
+	}
+	return crcSum(crc, valueBytes, 4 * numInts);
+}
+
+int syncDebugSnprintInts(char *buf, size_t bufSize, char const *str, int const *ints, size_t numInts)
+{
+	switch (numInts)
+	{
+	case  0: return snprintf(buf, bufSize, "%s", str);
+	case  1: return snprintf(buf, bufSize, str, ints[0]);
+	case  2: return snprintf(buf, bufSize, str, ints[0], ints[1]);
+	case  3: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2]);
+	case  4: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3]);
+	case  5: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4]);
+	case  6: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5]);
+	case  7: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6]);
+	case  8: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7]);
+	case  9: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8]);
+	case 10: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9]);
+	case 11: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10]);
+	case 12: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11]);
+	case 13: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12]);
+	case 14: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13]);
+	case 15: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14]);
+	case 16: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15]);
+	case 17: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16]);
+	case 18: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17]);
+	case 19: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18]);
+	case 20: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19]);
+	case 21: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20]);
+	case 22: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21]);
+	case 23: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22]);
+	case 24: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23]);
+	case 25: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24]);
+	case 26: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25]);
+	case 27: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26]);
+	case 28: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27]);
+	case 29: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28]);
+	case 30: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29]);
+	case 31: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30]);
+	case 32: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31]);
+	case 33: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32]);
+	case 34: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33]);
+	case 35: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34]);
+	case 36: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35]);
+	case 37: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36]);
+	case 38: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37]);
+	case 39: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37], ints[38]);
+	case 40: return snprintf(buf, bufSize, str, ints[0], ints[1], ints[2], ints[3], ints[4], ints[5], ints[6], ints[7], ints[8], ints[9], ints[10], ints[11], ints[12], ints[13], ints[14], ints[15], ints[16], ints[17], ints[18], ints[19], ints[20], ints[21], ints[22], ints[23], ints[24], ints[25], ints[26], ints[27], ints[28], ints[29], ints[30], ints[31], ints[32], ints[33], ints[34], ints[35], ints[36], ints[37], ints[38], ints[39]);
+	default: return snprintf(buf, bufSize, "Too many ints in intlist.");
+	}
+}
+
+void syncDebugUnescape(char *buf, size_t bufSize, char const *str)
+{
+	size_t index = 0;
+	for (char const *c = str; *c != '\0' && index + 1 < bufSize; ++c)
+	{
+		if (c[0] == '%' && c[1] == '%')
+		{
+			++c;
+		}
+		buf[index++] = *c;
+	}
+	if (bufSize > 0)
+	{
+		buf[index] = '\0';
+	}
+}
@@ -0,0 +1,38 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Storing and formatting of syncDebug calls, separate from the sync debug log so it can be tested on its own.
+ */
+
+#ifndef __INCLUDED_LIB_NETPLAY_SYNCDEBUG_H__
+#define __INCLUDED_LIB_NETPLAY_SYNCDEBUG_H__
+
+#include <stddef.h>
+#include <stdint.h>
+
+/// Adds the ints of an int-only syncDebug call to crc, and also function and str if crcStrings. Ints are summed big-endian, so the CRC is the same on all platforms.
+uint32_t syncDebugCrcInts(uint32_t crc, char const *function, char const *str, int const *ints, size_t numInts, bool crcStrings);
+
+/// Formats str with the numInts ints, the same as formatting the original syncDebug call would. Returns the same as snprintf.
+int syncDebugSnprintInts(char *buf, size_t bufSize, char const *str, int const *ints, size_t numInts);
+
+/// Copies str, a format string taking no arguments, to buf the way formatting it would, so "%%" becomes "%".
+void syncDebugUnescape(char *buf, size_t bufSize, char const *str);
+
+#endif // __INCLUDED_LIB_NETPLAY_SYNCDEBUG_H__
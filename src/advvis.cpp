@@ -49,22 +49,23 @@ void	avUpdateTiles()
 	/* Go through the tiles */
 	for (psTile = psMapTiles; i < len; i++)
 	{
-		maxLevel = psTile->illumination;
+		MAPTILE_LIGHT *psLight = mapTileLight(psTile);
+		maxLevel = psLight->illumination;
 
-		if (psTile->level > MIN_ILLUM || psTile->tileExploredBits & playermask)	// seen
+		if (psLight->level > MIN_ILLUM || psTile->tileExploredBits & playermask)	// seen
 		{
 			// If we are not omniscient, and we are not seeing the tile, and none of our allies see the tile...
 			if (!godMode && !(alliancebits[selectedPlayer] & (satuplinkbits | psTile->sensorBits)))
 			{
 				maxLevel /= 2;
 			}
-			if (psTile->level > maxLevel)
+			if (psLight->level > maxLevel)
 			{
-				psTile->level = MAX(psTile->level - increment, maxLevel);
+				psLight->level = MAX(psLight->level - increment, maxLevel);
 			}
-			else if (psTile->level < maxLevel)
+			else if (psLight->level < maxLevel)
 			{
-				psTile->level = MIN(psTile->level + increment, maxLevel);
+				psLight->level = MIN(psLight->level + increment, maxLevel);
 			}
 		}
 		psTile++;
@@ -107,11 +108,12 @@ void	preProcessVisibility()
 		for (int j = 0; j < mapHeight; j++)
 		{
 			MAPTILE *psTile = mapTile(i, j);
-			psTile->level = bRevealActive ? MIN(MIN_ILLUM, psTile->illumination / 4.0f) : 0;
+			MAPTILE_LIGHT *psLight = mapTileLight(psTile);
+			psLight->level = bRevealActive ? MIN(MIN_ILLUM, psLight->illumination / 4.0f) : 0;
 
 			if (TEST_TILE_VISIBLE(selectedPlayer, psTile))
 			{
-				psTile->level = psTile->illumination;
+				psLight->level = psLight->illumination;
 			}
 		}
 	}
@@ -37,6 +37,9 @@
 #include "objmem.h"
 #include "order.h"
 
+#include <unordered_map>
+#include <unordered_set>
+
 /* Weights used for target selection code,
  * target distance is used as 'common currency'
  */
@@ -80,6 +83,19 @@ PlayerMask alliancebits[MAX_PLAYER_SLOTS];
 /// A bitfield for the satellite uplink
 PlayerMask satuplinkbits;
 
+/// log2 of the size of the cells in which droids share target candidates.
+#define AI_TARGET_CELL_SHIFT 8
+
+struct AiTargetCell
+{
+	GridList objects;
+	std::vector<Vector2i> gridPositions;  ///< Where each object was at the last gridReset.
+};
+
+/// Objects near each cell, for each search range, found once per grid update.
+static std::unordered_map<uint64_t, AiTargetCell> aiTargetCells;
+static uint32_t aiTargetCellsGeneration = 0;
+
 static int aiDroidRange(DROID *psDroid, int weapon_slot)
 {
 	int32_t longRange;
@@ -101,8 +117,8 @@ static int aiDroidRange(DROID *psDroid, int weapon_slot)
 	return longRange;
 }
 
-// see if a structure has the range to fire on a target
-static bool aiStructHasRange(STRUCTURE *psStruct, BASE_OBJECT *psTarget, int weapon_slot)
+// see if a target is within the range of a structure's weapon, not considering line of fire
+static bool aiStructInRange(STRUCTURE *psStruct, BASE_OBJECT *psTarget, int weapon_slot)
 {
 	if (psStruct->numWeaps == 0 || psStruct->asWeaps[0].nStat == 0)
 	{
@@ -113,7 +129,13 @@ static bool aiStructHasRange(STRUCTURE *psStruct, BASE_OBJECT *psTarget, int wea
 	WEAPON_STATS *psWStats = psStruct->asWeaps[weapon_slot].nStat + asWeaponStats;
 
 	int longRange = proj_GetLongRange(psWStats, psStruct->player);
-	return objPosDiffSq(psStruct, psTarget) < longRange * longRange && lineOfFire(psStruct, psTarget, weapon_slot, true);
+	return objPosDiffSq(psStruct, psTarget) < longRange * longRange;
+}
+
+// see if a structure has the range to fire on a target
+static bool aiStructHasRange(STRUCTURE *psStruct, BASE_OBJECT *psTarget, int weapon_slot)
+{
+	return aiStructInRange(psStruct, psTarget, weapon_slot) && lineOfFire(psStruct, psTarget, weapon_slot, true);
 }
 
 static bool aiDroidHasRange(DROID *psDroid, BASE_OBJECT *psTarget, int weapon_slot)
@@ -524,6 +546,53 @@ static SDWORD targetAttackWeight(BASE_OBJECT *psTarget, BASE_OBJECT *psAttacker,
 }
 
 
+// Returns the same objects as gridStartIterate(pos.x, pos.y, range), but shares the grid query with all droids
+// searching with the same range from the same cell, which matters when large groups of droids look for targets.
+static GridList const &aiTargetCandidates(Vector2i pos, int range)
+{
+	if (aiTargetCellsGeneration != gridGeneration())
+	{
+		aiTargetCells.clear();
+		aiTargetCellsGeneration = gridGeneration();
+	}
+
+	const int32_t cellX = pos.x >> AI_TARGET_CELL_SHIFT;
+	const int32_t cellY = pos.y >> AI_TARGET_CELL_SHIFT;
+	const uint64_t key = (uint64_t)(uint16_t)cellX << 48 | (uint64_t)(uint16_t)cellY << 32 | (uint32_t)range;
+
+	auto cell = aiTargetCells.find(key);
+	if (cell == aiTargetCells.end())
+	{
+		const int32_t x1 = cellX * (1 << AI_TARGET_CELL_SHIFT) - range;
+		const int32_t y1 = cellY * (1 << AI_TARGET_CELL_SHIFT) - range;
+		const int32_t x2 = x1 + (1 << AI_TARGET_CELL_SHIFT) - 1 + 2 * range;
+		const int32_t y2 = y1 + (1 << AI_TARGET_CELL_SHIFT) - 1 + 2 * range;
+		cell = aiTargetCells.emplace(key, AiTargetCell()).first;
+		cell->second.objects = gridStartIterateArea(x1, y1, x2, y2, cell->second.gridPositions);
+	}
+
+	// The cell's objects are in the same order as gridStartIterate returns them, so only need to drop the ones it wouldn't return.
+	static GridList gridList;  // static to avoid allocations.
+	gridList.clear();
+	AiTargetCell const &candidates = cell->second;
+	for (size_t i = 0; i < candidates.objects.size(); ++i)
+	{
+		BASE_OBJECT *psObj = candidates.objects[i];
+		const Vector2i gridDiff = candidates.gridPositions[i] - pos;
+		const Vector2i diff = psObj->pos.xy() - pos;
+		if (abs(gridDiff.x) > range || abs(gridDiff.y) > range)
+		{
+			// Not in the square which gridStartIterate searches, around where the object was at the last gridReset
+			continue;
+		}
+		if ((uint32_t)(diff.x * diff.x + diff.y * diff.y) <= (uint32_t)range * range)
+		{
+			gridList.push_back(psObj);
+		}
+	}
+	return gridList;
+}
+
 // Find the best nearest target for a droid.
 // If extraRange is higher than zero, then this is the range it accepts for movement to target.
 // Returns integer representing target priority, -1 if failed
@@ -565,8 +634,10 @@ int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, i
 	// Range was previously 9*TILE_UNITS. Increasing this doesn't seem to help much, though. Not sure why.
 	int droidRange = std::min(aiDroidRange(psDroid, weapon_slot) + extraRange, objSensorRange(psDroid) + 6 * TILE_UNITS);
 
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psDroid->pos.x, psDroid->pos.y, droidRange);
+	static std::unordered_set<BASE_OBJECT *> consideredTargets;  // static to avoid allocations.
+	consideredTargets.clear();
+
+	GridList const &gridList = aiTargetCandidates(psDroid->pos.xy(), droidRange);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *friendlyObj = nullptr;
@@ -611,6 +682,15 @@ int aiBestNearestTarget(DROID *psDroid, BASE_OBJECT **ppsObj, int weapon_slot, i
 			}
 		}
 
+		if (targetInQuestion != nullptr)
+		{
+			/* Many friendlies often share a target, which would get the same weight each time */
+			if (!consideredTargets.insert(targetInQuestion).second)
+			{
+				continue;
+			}
+		}
+
 		if (targetInQuestion != nullptr
 		    && targetInQuestion != psDroid  // in case friendly unit had me as target
 		    && (targetInQuestion->type == OBJ_DROID || targetInQuestion->type == OBJ_STRUCTURE || targetInQuestion->type == OBJ_FEATURE)
@@ -908,6 +988,10 @@ bool aiChooseTarget(BASE_OBJECT *psObj, BASE_OBJECT **ppsTarget, int weapon_slot
 				srange = objSensorRange(psObj);
 			}
 
+			// Check the line of fire to all the targets in range at once.
+			static std::vector<BASE_OBJECT *> candidates;  // static to avoid allocations.
+			static std::vector<uint8_t> canFire;
+			candidates.clear();
 			static GridList gridList;  // static to avoid allocations.
 			gridList = gridStartIterate(psObj->pos.x, psObj->pos.y, srange);
 			for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
@@ -917,7 +1001,18 @@ bool aiChooseTarget(BASE_OBJECT *psObj, BASE_OBJECT **ppsTarget, int weapon_slot
 				if (psCurr->type != OBJ_FEATURE && !psCurr->died
 				    && !aiCheckAlliances(psCurr->player, psObj->player)
 				    && validTarget(psObj, psCurr, weapon_slot) && psCurr->visible[psObj->player] == UBYTE_MAX
-				    && aiStructHasRange((STRUCTURE *)psObj, psCurr, weapon_slot))
+				    && aiStructInRange((STRUCTURE *)psObj, psCurr, weapon_slot))
+				{
+					candidates.push_back(psCurr);
+				}
+			}
+			canFire.resize(candidates.size());
+			lineOfFireBatch(psObj, candidates.data(), candidates.size(), weapon_slot, true, canFire.data());
+
+			for (size_t i = 0; i < candidates.size(); ++i)
+			{
+				BASE_OBJECT *psCurr = candidates[i];
+				if (canFire[i])
 				{
 					int newTargetValue = targetAttackWeight(psCurr, psObj, weapon_slot);
 					// See if in sensor range and visible
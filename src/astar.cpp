@@ -35,15 +35,25 @@
  *    is continued until the new source is reached.  If the new source is  not reached,
  *    the droid is  on a  different island than the previous droid,  and pathfinding is
  *    restarted from the first step.
- *  Up to 30 pathfinding maps from A* are cached, in a LRU list. The PathNode heap con-
- *  tains the  priority-heap-sorted  nodes which are to be explored.  The path back  is
- *  stored in the PathExploredTile 2D array of tiles.
+ *  Up to 4 pathfinding maps from A* are cached per lane, in a LRU list. The PathNode
+ *  heap contains the priority-heap-sorted nodes which are to be explored. The path back
+ *  is stored in the PathExploredTile 2D array of tiles.
+ *  When many droids are sent to the same tile in the same tick, the later ones instead
+ *  share a PathFlowField, which is explored outwards from the destination only once, and
+ *  each droid just follows it downhill.
+ *  Routes between different sectors are also remembered across ticks,  until the block-
+ *  ing map changes. A later job between the same sectors reuses such a route,  if it can
+ *  walk in a straight line from its start onto the route, and from the route to its end.
+ *  Jobs are split into FPATH_LANES lanes by destination, and each lane has its own LRU
+ *  list. Since each lane processes its jobs in order, the resulting paths don't depend
+ *  on how many threads are used to process the lanes.
  */
 
 #ifndef WZ_TESTING
 #include "lib/framework/frame.h"
 
 #include "astar.h"
+#include "hpastar.h"
 #include "map.h"
 #endif
 
@@ -51,6 +61,7 @@
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <atomic>
 
 #include "lib/netplay/netplay.h"
 
@@ -127,8 +138,10 @@ struct PathBlockingMap
 	}
 
 	PathBlockingType type;
-	std::vector<bool> map;
-	std::vector<bool> dangerMap;	// using threatBits
+	PathBitMap map;
+	PathBitMap dangerMap;	// using threatBits
+	std::shared_ptr<PathClusterGraph const> clusterGraph;  ///< Abstraction of map, for planning long routes. May be null.
+	uint32_t generation;    ///< Only changes when the blocking map of this type is rebuilt or changes, not when the danger map changes.
 };
 
 struct PathNonblockingArea
@@ -165,22 +178,24 @@ struct PathfindContext
 			return false;  // The path is actually blocked here by a structure, but ignore it since it's where we want to go (or where we came from).
 		}
 		// Not sure whether the out-of-bounds check is needed, can only happen if pathfinding is started on a blocking tile (or off the map).
-		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map[x + y * mapWidth];
+		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map.get(x, y) ||
+		       (!corridor.empty() && !corridor[fpathClusterIndex(x, y, mapWidth)]);
 	}
 	bool isDangerous(int x, int y) const
 	{
-		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap[x + y * mapWidth];
+		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap.get(x, y);
 	}
-	bool matches(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_) const
+	bool matches(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_, std::vector<bool> const &corridor_) const
 	{
 		// Must check myGameTime == blockingMap_->type.gameTime, otherwise blockingMap could be a deleted pointer which coincidentally compares equal to the valid pointer blockingMap_.
-		return myGameTime == blockingMap_->type.gameTime && blockingMap == blockingMap_ && tileS == tileS_ && dstIgnore == dstIgnore_;
+		return myGameTime == blockingMap_->type.gameTime && blockingMap == blockingMap_ && tileS == tileS_ && dstIgnore == dstIgnore_ && corridor == corridor_;
 	}
-	void assign(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_)
+	void assign(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileS_, PathNonblockingArea dstIgnore_, std::vector<bool> const &corridor_)
 	{
 		blockingMap = blockingMap_;
 		tileS = tileS_;
 		dstIgnore = dstIgnore_;
+		corridor = corridor_;
 		myGameTime = blockingMap->type.gameTime;
 		nodes.clear();
 
@@ -208,15 +223,142 @@ struct PathfindContext
 	std::vector<PathExploredTile> map;  ///< Map, with paths leading back to tileS.
 	std::shared_ptr<PathBlockingMap> blockingMap; ///< Map of blocking tiles for the type of object which needs a path.
 	PathNonblockingArea dstIgnore;      ///< Area of structure at destination which should be considered nonblocking.
+	std::vector<bool> corridor;         ///< Clusters which may be entered, or empty if the whole map may be used.
 };
 
-/// Last recently used list of contexts.
-static std::list<PathfindContext> fpathContexts;
+/** Distances to a destination, shared by all droids going to the same place.
+ *
+ *  The field is explored outwards from the destination (Dijkstra, no heuristic) only as far as needed for the droids that
+ *  have used it so far. The distance of a tile never changes once the tile is settled, so the routes read from the field
+ *  do not depend on how far it was explored by earlier jobs.
+ */
+struct PathFlowField
+{
+	bool isBlocked(int x, int y) const
+	{
+		if (dstIgnore.isNonblocking(x, y))
+		{
+			return false;
+		}
+		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap->map.get(x, y);
+	}
+	bool isDangerous(int x, int y) const
+	{
+		return !blockingMap->dangerMap.empty() && blockingMap->dangerMap.get(x, y);
+	}
+	bool matches(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileF_, PathNonblockingArea dstIgnore_) const
+	{
+		// See PathfindContext::matches for why myGameTime must be checked.
+		return myGameTime == blockingMap_->type.gameTime && blockingMap == blockingMap_ && tileF == tileF_ && dstIgnore == dstIgnore_;
+	}
+	void assign(std::shared_ptr<PathBlockingMap> &blockingMap_, PathCoord tileF_, PathNonblockingArea dstIgnore_)
+	{
+		blockingMap = blockingMap_;
+		tileF = tileF_;
+		dstIgnore = dstIgnore_;
+		myGameTime = blockingMap->type.gameTime;
+		nodes.clear();
+
+		// Make the iteration not match any value of iteration in map, the same way as PathfindContext::assign.
+		if (++iteration == 0xFFFF)
+		{
+			map.clear();
+			iteration = 0;
+		}
+		map.resize(mapWidth * mapHeight);
+	}
+	/// Returns true if the tile has been taken from nodes, so its distance and way back are final.
+	bool isSettled(int x, int y) const
+	{
+		PathExploredTile const &expl = map[x + y * mapWidth];
+		return expl.iteration == iteration && expl.visited;
+	}
+
+	PathCoord       tileF;                ///< Destination tile.
+	uint32_t        myGameTime = 0;
+	uint16_t        iteration = 0;        ///< Counter to implement lazy deletion from map.
+
+	std::vector<PathExploredTile> map;    ///< Distance from each tile to tileF, and the way back towards tileF.
+	std::vector<PathNode> nodes;          ///< Edge of explored region of the map, with est == dist.
+	std::shared_ptr<PathBlockingMap> blockingMap;
+	PathNonblockingArea dstIgnore;
+};
+
+/// Width and height, in tiles, of the sectors used to look up cached routes.
+#define FPATH_CACHE_SECTOR_SIZE 8
+
+/// Route found by an earlier search, reused by jobs starting and ending in the same sectors while the blocking map is unchanged.
+struct PathCachedRoute
+{
+	bool matches(uint32_t generation_, bool avoidsDanger_, PathCoord sectorS_, PathCoord sectorF_, PathNonblockingArea dstIgnore_) const
+	{
+		return generation == generation_ && avoidsDanger == avoidsDanger_ && sectorS == sectorS_ && sectorF == sectorF_ && dstIgnore == dstIgnore_;
+	}
+
+	uint32_t generation;                  ///< Generation of the blocking map the route was found on.
+	bool avoidsDanger;                    ///< Whether the route was found avoiding a danger map.
+	PathCoord sectorS;                    ///< Sector containing the start of the route.
+	PathCoord sectorF;                    ///< Sector containing the destination of the route.
+	PathNonblockingArea dstIgnore;        ///< Area of structure at destination which should be considered moveable.
+	std::vector<Vector2i> path;           ///< Route in world coordinates, from start to destination.
+};
+
+/// Per-lane pathfinding state. Only one thread may use a given lane at a time.
+struct PathLane
+{
+	std::list<PathfindContext> contexts;  ///< Last recently used list of contexts.
+	std::list<PathFlowField> flowFields;  ///< Last recently used list of flow fields.
+	std::vector<Vector2i> path;           ///< Route being built, in reverse order. Kept here to save allocations.
+	std::list<PathCachedRoute> routes;    ///< Last recently used list of routes found by earlier searches.
+};
+
+/// Maximum number of routes cached per lane.
+#define FPATH_CACHE_ROUTES_PER_LANE 32
+
+/// Maximum number of flow fields cached per lane.
+#define FPATH_FLOWFIELDS_PER_LANE 2
+
+/// Maximum number of contexts cached per lane, giving up to 32 cached contexts in total.
+#define FPATH_CONTEXTS_PER_LANE 4
+
+static PathLane fpathLanes[FPATH_LANES];
 
 /// Lists of blocking maps from current tick.
 static std::vector<std::shared_ptr<PathBlockingMap>> fpathBlockingMaps;
+/// Things which, if changed, require rebuilding a blocking map from scratch.
+struct PathBlockingStamp
+{
+	bool operator ==(PathBlockingStamp const &z) const
+	{
+		return width == z.width && height == z.height &&
+		       scrollMinX == z.scrollMinX && scrollMinY == z.scrollMinY && scrollMaxX == z.scrollMaxX && scrollMaxY == z.scrollMaxY &&
+		       auxMapVersion == z.auxMapVersion;
+	}
+
+	int width, height;
+	int scrollMinX, scrollMinY, scrollMaxX, scrollMaxY;
+	uint32_t auxMapVersion;  ///< Changes when the maps are reallocated, or swapped to or from the mission map.
+};
+/// Blocking map which is kept up to date between ticks, only recalculating the tiles marked by fpathMarkBlockingChanged.
+struct PathBlockingCache
+{
+	PathBlockingType type;                ///< Type of map, gameTime is not used.
+	PathBlockingStamp stamp;
+	PathBitMap map;
+	PathBitMap changed;                   ///< Tiles which need recalculating.
+	bool anyChanged = false;
+	uint32_t generation = 0;              ///< Changed whenever map is rebuilt or changes.
+	std::shared_ptr<PathClusterGraph const> clusterGraph;  ///< Cluster graph of map, or null for air units.
+};
+/// Blocking maps for each type of blocking map which has been used so far.
+static std::vector<PathBlockingCache> fpathBlockingCaches;
 /// Game time for all blocking maps in fpathBlockingMaps.
 static uint32_t fpathCurrentGameTime;
+/// Last generation given to a blocking map.
+static uint32_t fpathBlockingGeneration;
+
+/// Number of jobs served from and not found in the route caches, since the game started.
+static std::atomic<unsigned> fpathCacheHits, fpathCacheMisses;
 
 // Convert a direction into an offset
 // dir 0 => x = 0, y = -1
@@ -234,8 +376,18 @@ static const Vector2i aDirOffset[] =
 
 void fpathHardTableReset()
 {
-	fpathContexts.clear();
+	for (auto &lane : fpathLanes)
+	{
+		lane.contexts.clear();
+		lane.flowFields.clear();
+		lane.path.clear();
+		lane.routes.clear();
+	}
 	fpathBlockingMaps.clear();
+	fpathBlockingCaches.clear();
+	fpathBlockingGeneration = 0;
+	fpathCacheHits = 0;
+	fpathCacheMisses = 0;
 }
 
 /** Get the nearest entry in the open list
@@ -268,33 +420,26 @@ static inline unsigned WZ_DECL_PURE fpathGoodEstimate(PathCoord s, PathCoord f)
 	return iHypot((s.x - f.x) * 140, (s.y - f.y) * 140);
 }
 
-/** Generate a new node
+/** Remembers the way back from node.p to prevPos, unless a shorter way is already known. Returns false if not shorter.
+ *  If canBlend, the way back is blended with the way already known, if any, so routes aren't limited to 8 directions. In
+ *  that case, node.dist and node.est are reduced by the same amount.
  */
-static inline void fpathNewNode(PathfindContext &context, PathCoord dest, PathCoord pos, unsigned prevDist, PathCoord prevPos)
+static inline bool fpathExploreTile(PathExploredTile &expl, uint16_t iteration, PathNode &node, PathCoord prevPos, unsigned costFactor, bool canBlend = true)
 {
-	ASSERT_OR_RETURN(, (unsigned)pos.x < (unsigned)mapWidth && (unsigned)pos.y < (unsigned)mapHeight, "X (%d) or Y (%d) coordinate for path finding node is out of range!", pos.x, pos.y);
-
-	// Create the node.
-	PathNode node;
-	unsigned costFactor = context.isDangerous(pos.x, pos.y) ? 5 : 1;
-	node.p = pos;
-	node.dist = prevDist + fpathEstimate(prevPos, pos) * costFactor;
-	node.est = node.dist + fpathGoodEstimate(pos, dest);
-
+	PathCoord pos = node.p;
 	Vector2i delta = Vector2i(pos.x - prevPos.x, pos.y - prevPos.y) * 64;
 	bool isDiagonal = delta.x && delta.y;
 
-	PathExploredTile &expl = context.map[pos.x + pos.y * mapWidth];
-	if (expl.iteration == context.iteration)
+	if (expl.iteration == iteration)
 	{
 		if (expl.visited)
 		{
-			return;  // Already visited this tile. Do nothing.
+			return false;  // Already visited this tile. Do nothing.
 		}
 		Vector2i deltaA = delta;
 		Vector2i deltaB = Vector2i(expl.dx, expl.dy);
 		Vector2i deltaDelta = deltaA - deltaB;  // Vector pointing from current considered source tile leading to pos, to the previously considered source tile leading to pos.
-		if (abs(deltaDelta.x) + abs(deltaDelta.y) == 64)
+		if (canBlend && abs(deltaDelta.x) + abs(deltaDelta.y) == 64)
 		{
 			// prevPos is tile A or B, and pos is tile P. We were previously called with prevPos being tile B or A, and pos tile P.
 			// We want to find the distance to tile P, taking into account that the actual shortest path involves coming from somewhere between tile A and tile B.
@@ -324,16 +469,36 @@ static inline void fpathNewNode(PathfindContext &context, PathCoord dest, PathCo
 		}
 		if (expl.dist <= node.dist)
 		{
-			return;  // A different path to this tile is shorter.
+			return false;  // A different path to this tile is shorter.
 		}
 	}
 
 	// Remember where we have been, and remember the way back.
-	expl.iteration = context.iteration;
+	expl.iteration = iteration;
 	expl.dx = delta.x;
 	expl.dy = delta.y;
 	expl.dist = node.dist;
 	expl.visited = false;
+	return true;
+}
+
+/** Generate a new node
+ */
+static inline void fpathNewNode(PathfindContext &context, PathCoord dest, PathCoord pos, unsigned prevDist, PathCoord prevPos)
+{
+	ASSERT_OR_RETURN(, (unsigned)pos.x < (unsigned)mapWidth && (unsigned)pos.y < (unsigned)mapHeight, "X (%d) or Y (%d) coordinate for path finding node is out of range!", pos.x, pos.y);
+
+	// Create the node.
+	PathNode node;
+	unsigned costFactor = context.isDangerous(pos.x, pos.y) ? 5 : 1;
+	node.p = pos;
+	node.dist = prevDist + fpathEstimate(prevPos, pos) * costFactor;
+	node.est = node.dist + fpathGoodEstimate(pos, dest);
+
+	if (!fpathExploreTile(context.map[pos.x + pos.y * mapWidth], context.iteration, node, prevPos, costFactor))
+	{
+		return;
+	}
 
 	// Add the node to the node heap.
 	context.nodes.push_back(node);                               // Add the new node to nodes.
@@ -432,18 +597,63 @@ static PathCoord fpathAStarExplore(PathfindContext &context, PathCoord tileF)
 	return nearestCoord;
 }
 
-static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileS, PathCoord tileRealS, PathCoord tileF, PathNonblockingArea dstIgnore)
+static void fpathInitContext(PathfindContext &context, std::shared_ptr<PathBlockingMap> &blockingMap, PathCoord tileS, PathCoord tileRealS, PathCoord tileF, PathNonblockingArea dstIgnore, std::vector<bool> const &corridor)
 {
-	context.assign(blockingMap, tileS, dstIgnore);
+	context.assign(blockingMap, tileS, dstIgnore, corridor);
 
 	// Add the start point to the open list
 	fpathNewNode(context, tileF, tileRealS, 0, tileRealS);
 	ASSERT(!context.nodes.empty(), "fpathNewNode failed to add node.");
 }
 
-ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
+unsigned fpathJobLane(PATHJOB const *psJob)
+{
+	// Jobs going to the same tile must use the same lane, so that they can share contexts.
+	unsigned tileX = map_coord(psJob->destX), tileY = map_coord(psJob->destY);
+	return (tileX * 7 + tileY * 13) % FPATH_LANES;
+}
+
+/// Follows the ways back remembered in context.map from tileStart towards tileS, giving a route of points in world coordinates.
+/// Returns false if the route leaves the map or gets in a loop.
+template<class Context>
+static bool fpathTraceRoute(Context const &context, PathCoord tileStart, PathCoord tileS, std::vector<Vector2i> &path)
+{
+	path.clear();
+
+	Vector2i newP(0, 0);
+	for (Vector2i p(world_coord(tileStart.x) + TILE_UNITS / 2, world_coord(tileStart.y) + TILE_UNITS / 2); true; p = newP)
+	{
+		ASSERT_OR_RETURN(false, worldOnMap(p.x, p.y), "Assigned XY coordinates (%d, %d) not on map!", (int)p.x, (int)p.y);
+		ASSERT_OR_RETURN(false, path.size() < (unsigned)mapWidth * mapHeight, "Pathfinding got in a loop.");
+
+		path.push_back(p);
+
+		PathExploredTile const &tile = context.map[map_coord(p.x) + map_coord(p.y) * mapWidth];
+		newP = p - Vector2i(tile.dx, tile.dy) * (TILE_UNITS / 64);
+		Vector2i mapP = map_coord(newP);
+		int xSide = newP.x - world_coord(mapP.x) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on right-hand side of the tile, or -1 if newP is on the left-hand side of the tile.
+		int ySide = newP.y - world_coord(mapP.y) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on bottom side of the tile, or -1 if newP is on the top side of the tile.
+		if (context.isBlocked(mapP.x + xSide, mapP.y))
+		{
+			newP.x = world_coord(mapP.x) + TILE_UNITS / 2; // Point too close to a blocking tile on left or right side, so move the point to the middle.
+		}
+		if (context.isBlocked(mapP.x, mapP.y + ySide))
+		{
+			newP.y = world_coord(mapP.y) + TILE_UNITS / 2; // Point too close to a blocking tile on rop or bottom side, so move the point to the middle.
+		}
+		if (map_coord(p) == Vector2i(tileS.x, tileS.y) || p == newP)
+		{
+			break;  // We stopped moving, because we reached the destination or the closest reachable tile to tileS. Give up now.
+		}
+	}
+	return true;
+}
+
+/// Finds a route, only entering the clusters in corridor if it is not empty.
+static ASR_RETVAL fpathAStarCorridorRoute(MOVE_CONTROL *psMove, PATHJOB *psJob, unsigned lane, std::vector<bool> const &corridor)
 {
 	ASR_RETVAL      retval = ASR_OK;
+	std::list<PathfindContext> &fpathContexts = fpathLanes[lane].contexts;
 
 	bool            mustReverse = true;
 
@@ -456,7 +666,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	std::list<PathfindContext>::iterator contextIterator = fpathContexts.begin();
 	for (contextIterator = fpathContexts.begin(); contextIterator != fpathContexts.end(); ++contextIterator)
 	{
-		if (!contextIterator->matches(psJob->blockingMap, tileDest, dstIgnore))
+		if (!contextIterator->matches(psJob->blockingMap, tileDest, dstIgnore, corridor))
 		{
 			// This context is not for the same droid type and same destination.
 			continue;
@@ -491,7 +701,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	{
 		// We did not find an appropriate context. Make one.
 
-		if (fpathContexts.size() < 30)
+		if (fpathContexts.size() < FPATH_CONTEXTS_PER_LANE)
 		{
 			fpathContexts.push_back(PathfindContext());
 		}
@@ -499,7 +709,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 
 		// Init a new context, overwriting the oldest one if we are caching too many.
 		// We will be searching from orig to dest, since we don't know where the nearest reachable tile to dest is.
-		fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore);
+		fpathInitContext(*contextIterator, psJob->blockingMap, tileOrig, tileOrig, tileDest, dstIgnore, corridor);
 		endCoord = fpathAStarExplore(*contextIterator, tileDest);
 		contextIterator->nearestCoord = endCoord;
 	}
@@ -513,34 +723,10 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	}
 
 	// Get route, in reverse order.
-	static std::vector<Vector2i> path;  // Declared static to save allocations.
-	path.clear();
-
-	Vector2i newP(0, 0);
-	for (Vector2i p(world_coord(endCoord.x) + TILE_UNITS / 2, world_coord(endCoord.y) + TILE_UNITS / 2); true; p = newP)
+	std::vector<Vector2i> &path = fpathLanes[lane].path;
+	if (!fpathTraceRoute(context, endCoord, context.tileS, path))
 	{
-		ASSERT_OR_RETURN(ASR_FAILED, worldOnMap(p.x, p.y), "Assigned XY coordinates (%d, %d) not on map!", (int)p.x, (int)p.y);
-		ASSERT_OR_RETURN(ASR_FAILED, path.size() < (unsigned)mapWidth * mapHeight, "Pathfinding got in a loop.");
-
-		path.push_back(p);
-
-		PathExploredTile &tile = context.map[map_coord(p.x) + map_coord(p.y) * mapWidth];
-		newP = p - Vector2i(tile.dx, tile.dy) * (TILE_UNITS / 64);
-		Vector2i mapP = map_coord(newP);
-		int xSide = newP.x - world_coord(mapP.x) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on right-hand side of the tile, or -1 if newP is on the left-hand side of the tile.
-		int ySide = newP.y - world_coord(mapP.y) > TILE_UNITS / 2 ? 1 : -1; // 1 if newP is on bottom side of the tile, or -1 if newP is on the top side of the tile.
-		if (context.isBlocked(mapP.x + xSide, mapP.y))
-		{
-			newP.x = world_coord(mapP.x) + TILE_UNITS / 2; // Point too close to a blocking tile on left or right side, so move the point to the middle.
-		}
-		if (context.isBlocked(mapP.x, mapP.y + ySide))
-		{
-			newP.y = world_coord(mapP.y) + TILE_UNITS / 2; // Point too close to a blocking tile on rop or bottom side, so move the point to the middle.
-		}
-		if (map_coord(p) == Vector2i(context.tileS.x, context.tileS.y) || p == newP)
-		{
-			break;  // We stopped moving, because we reached the destination or the closest reachable tile to context.tileS. Give up now.
-		}
+		return ASR_FAILED;
 	}
 	if (retval == ASR_OK)
 	{
@@ -578,7 +764,7 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 		if (!context.isBlocked(tileOrig.x, tileOrig.y))  // If blocked, searching from tileDest to tileOrig wouldn't find the tileOrig tile.
 		{
 			// Next time, search starting from nearest reachable tile to the destination.
-			fpathInitContext(context, psJob->blockingMap, tileDest, context.nearestCoord, tileOrig, dstIgnore);
+			fpathInitContext(context, psJob->blockingMap, tileDest, context.nearestCoord, tileOrig, dstIgnore, corridor);
 		}
 	}
 	else
@@ -598,6 +784,448 @@ ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob)
 	return retval;
 }
 
+/// Returns true if it is possible to step directly from tile (x, y) in direction dir, using the same rules as fpathAStarExplore. Stepping is symmetric.
+static inline bool fpathFlowFieldCanStep(PathFlowField const &field, int x, int y, unsigned dir)
+{
+	int nx = x + aDirOffset[dir].x;
+	int ny = y + aDirOffset[dir].y;
+	if (field.isBlocked(nx, ny))
+	{
+		return false;
+	}
+	if (dir % 2 != 0 && !field.dstIgnore.isNonblocking(x, y) && !field.dstIgnore.isNonblocking(nx, ny))
+	{
+		// We cannot cut corners
+		if (field.isBlocked(x + aDirOffset[(dir + 1) % 8].x, y + aDirOffset[(dir + 1) % 8].y) ||
+		    field.isBlocked(x + aDirOffset[(dir + 7) % 8].x, y + aDirOffset[(dir + 7) % 8].y))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Adds a node to the edge of the explored region of the field, like fpathNewNode but without estimating the rest of the way.
+static inline void fpathFlowFieldNewNode(PathFlowField &field, PathCoord pos, unsigned prevDist, PathCoord prevPos)
+{
+	// The field is explored from the destination, so droids move from pos to prevPos. Charge for entering prevPos, like fpathNewNode charges for the tile being entered.
+	bool dangerous = field.isDangerous(prevPos.x, prevPos.y);
+	PathNode node;
+	unsigned costFactor = dangerous ? 5 : 1;
+	node.p = pos;
+	node.dist = prevDist + fpathEstimate(prevPos, pos) * costFactor;
+	node.est = node.dist;
+
+	// Blending with the way back already known assumes both ways cost the same per step, which isn't so if only one of them enters a dangerous tile.
+	PathExploredTile &expl = field.map[pos.x + pos.y * mapWidth];
+	bool canBlend = true;
+	if (expl.iteration == field.iteration && !expl.visited && expl.dx % 64 == 0 && expl.dy % 64 == 0)
+	{
+		canBlend = field.isDangerous(pos.x - expl.dx / 64, pos.y - expl.dy / 64) == dangerous;
+	}
+
+	if (!fpathExploreTile(expl, field.iteration, node, prevPos, costFactor, canBlend))
+	{
+		return;
+	}
+	field.nodes.push_back(node);
+	std::push_heap(field.nodes.begin(), field.nodes.end());
+}
+
+/// Explores the field until tileS is settled. Returns false if tileS can't reach the destination.
+static bool fpathFlowFieldExplore(PathFlowField &field, PathCoord tileS)
+{
+	if ((unsigned)tileS.x >= (unsigned)mapWidth || (unsigned)tileS.y >= (unsigned)mapHeight)
+	{
+		return false;
+	}
+	while (!field.isSettled(tileS.x, tileS.y))
+	{
+		if (field.nodes.empty())
+		{
+			return false;  // Explored everything reachable from the destination.
+		}
+		PathNode node = fpathTakeNode(field.nodes);
+		if (field.isSettled(node.p.x, node.p.y))
+		{
+			continue;  // Already been here.
+		}
+		field.map[node.p.x + node.p.y * mapWidth].visited = true;
+
+		for (unsigned dir = 0; dir < ARRAY_SIZE(aDirOffset); ++dir)
+		{
+			if (fpathFlowFieldCanStep(field, node.p.x, node.p.y, dir))
+			{
+				fpathFlowFieldNewNode(field, PathCoord(node.p.x + aDirOffset[dir].x, node.p.y + aDirOffset[dir].y), node.dist, node.p);
+			}
+		}
+	}
+	return true;
+}
+
+/// Finds a route by following a shared flow field back to the destination. Returns false if the field can't be used, and a normal search is needed.
+static bool fpathFlowFieldRoute(MOVE_CONTROL *psMove, PATHJOB *psJob, unsigned lane)
+{
+	const PathCoord tileOrig(map_coord(psJob->origX), map_coord(psJob->origY));
+	const PathCoord tileDest(map_coord(psJob->destX), map_coord(psJob->destY));
+	const PathNonblockingArea dstIgnore(psJob->dstStructure);
+
+	std::list<PathFlowField> &flowFields = fpathLanes[lane].flowFields;
+	auto field = std::find_if(flowFields.begin(), flowFields.end(), [&](PathFlowField const &f) {
+		return f.matches(psJob->blockingMap, tileDest, dstIgnore);
+	});
+	if (field == flowFields.end())
+	{
+		if (flowFields.size() < FPATH_FLOWFIELDS_PER_LANE)
+		{
+			flowFields.push_back(PathFlowField());
+		}
+		--field;  // Overwrite the oldest one if we are caching too many.
+		field->assign(psJob->blockingMap, tileDest, dstIgnore);
+		fpathFlowFieldNewNode(*field, tileDest, 0, tileDest);
+	}
+	if (field != flowFields.begin())
+	{
+		flowFields.splice(flowFields.begin(), flowFields, field);
+	}
+
+	if (!fpathFlowFieldExplore(*field, tileOrig))
+	{
+		return false;  // Not reachable, let the A* find the nearest reachable tile.
+	}
+
+	// Follow the ways back towards the destination the same way as the A* does, so the route isn't limited to 8 directions.
+	// The ways back of settled tiles are final, so the route doesn't depend on how far the field was explored.
+	std::vector<Vector2i> &path = fpathLanes[lane].path;
+	if (!fpathTraceRoute(*field, tileOrig, tileDest, path))
+	{
+		return false;
+	}
+
+	// Found exact path, so use exact coordinates for last point, no reason to lose precision
+	path.back() = Vector2i(psJob->destX, psJob->destY);
+	psMove->asPath = path;
+	psMove->destination = path.back();
+	return true;
+}
+
+/// Returns true if a droid can move in a straight line between the centres of tiles a and b, without entering blocking or dangerous tiles.
+static bool fpathCacheCanWalk(PathBlockingMap const &blockingMap, PathNonblockingArea const &dstIgnore, PathCoord a, PathCoord b)
+{
+	auto isBlocked = [&](int x, int y) {
+		if (dstIgnore.isNonblocking(x, y))
+		{
+			return false;
+		}
+		return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight || blockingMap.map.get(x, y) ||
+		       (!blockingMap.dangerMap.empty() && blockingMap.dangerMap.get(x, y));
+	};
+
+	// Visit every tile the line touches, in order.
+	int nx = abs(b.x - a.x), ny = abs(b.y - a.y);
+	int sx = b.x > a.x ? 1 : -1, sy = b.y > a.y ? 1 : -1;
+	int x = a.x, y = a.y;
+	for (int ix = 0, iy = 0; ix < nx || iy < ny;)
+	{
+		int decision = (1 + 2 * ix) * ny - (1 + 2 * iy) * nx;
+		if (decision == 0)
+		{
+			// The line passes exactly through a corner, and we cannot cut corners.
+			if (isBlocked(x + sx, y) || isBlocked(x, y + sy))
+			{
+				return false;
+			}
+			x += sx;
+			y += sy;
+			++ix;
+			++iy;
+		}
+		else if (decision < 0)
+		{
+			x += sx;
+			++ix;
+		}
+		else
+		{
+			y += sy;
+			++iy;
+		}
+		if (isBlocked(x, y))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/// Distance in tiles, for deciding how far from the start or destination to look for a way to join a cached route.
+static inline int fpathCacheTileDistance(Vector2i p, PathCoord tile)
+{
+	Vector2i pTile = map_coord(p);
+	return std::max(abs(pTile.x - tile.x), abs(pTile.y - tile.y));
+}
+
+/// Finds a route by joining the start and destination to a cached route. Returns false if there is no suitable cached route.
+static bool fpathCacheRoute(MOVE_CONTROL *psMove, PATHJOB *psJob, unsigned lane, PathCoord sectorS, PathCoord sectorF)
+{
+	const PathCoord tileOrig(map_coord(psJob->origX), map_coord(psJob->origY));
+	const PathCoord tileDest(map_coord(psJob->destX), map_coord(psJob->destY));
+	const PathNonblockingArea dstIgnore(psJob->dstStructure);
+	PathBlockingMap const &blockingMap = *psJob->blockingMap;
+
+	std::list<PathCachedRoute> &routes = fpathLanes[lane].routes;
+	for (auto route = routes.begin(); route != routes.end(); ++route)
+	{
+		if (!route->matches(blockingMap.generation, !blockingMap.dangerMap.empty(), sectorS, sectorF, dstIgnore))
+		{
+			continue;
+		}
+		std::vector<Vector2i> const &path = route->path;
+
+		// Join the start to the last nearby point of the route which can be reached directly.
+		int first = -1;
+		for (int i = 0; i < (int)path.size() && fpathCacheTileDistance(path[i], tileOrig) <= 2 * FPATH_CACHE_SECTOR_SIZE; ++i)
+		{
+			Vector2i tile = map_coord(path[i]);
+			if (fpathCacheCanWalk(blockingMap, dstIgnore, tileOrig, PathCoord(tile.x, tile.y)))
+			{
+				first = i;
+			}
+		}
+		// Join the first nearby point of the route, from which the destination can be reached directly, to the destination.
+		int last = -1;
+		for (int i = (int)path.size() - 1; i >= std::max(first, 0) && fpathCacheTileDistance(path[i], tileDest) <= 2 * FPATH_CACHE_SECTOR_SIZE; --i)
+		{
+			Vector2i tile = map_coord(path[i]);
+			if (fpathCacheCanWalk(blockingMap, dstIgnore, PathCoord(tile.x, tile.y), tileDest))
+			{
+				last = i;
+			}
+		}
+		if (first < 0 || last < 0)
+		{
+			continue;
+		}
+
+		// The danger map may have changed since the route was found, so check the part of the route being used still avoids danger.
+		bool safe = true;
+		for (int i = first; i < last && safe && !blockingMap.dangerMap.empty(); ++i)
+		{
+			Vector2i a = map_coord(path[i]), b = map_coord(path[i + 1]);
+			safe = fpathCacheCanWalk(blockingMap, dstIgnore, PathCoord(a.x, a.y), PathCoord(b.x, b.y));
+		}
+		if (!safe)
+		{
+			continue;
+		}
+
+		psMove->asPath.assign(path.begin() + first, path.begin() + last + 1);
+		if (map_coord(psMove->asPath.back()) != Vector2i(tileDest.x, tileDest.y))
+		{
+			psMove->asPath.push_back(Vector2i(0, 0));
+		}
+		// Use exact coordinates for last point, no reason to lose precision
+		psMove->asPath.back() = Vector2i(psJob->destX, psJob->destY);
+		psMove->destination = psMove->asPath.back();
+
+		// Move route to beginning of last recently used list.
+		routes.splice(routes.begin(), routes, route);
+		return true;
+	}
+	return false;
+}
+
+/// Remembers a route found by a search, for fpathCacheRoute.
+static void fpathCacheStore(MOVE_CONTROL const *psMove, PATHJOB const *psJob, unsigned lane, PathCoord sectorS, PathCoord sectorF)
+{
+	const PathNonblockingArea dstIgnore(psJob->dstStructure);
+	uint32_t generation = psJob->blockingMap->generation;
+	bool avoidsDanger = !psJob->blockingMap->dangerMap.empty();
+
+	std::list<PathCachedRoute> &routes = fpathLanes[lane].routes;
+	auto route = std::find_if(routes.begin(), routes.end(), [&](PathCachedRoute const &r) {
+		return r.matches(generation, avoidsDanger, sectorS, sectorF, dstIgnore);
+	});
+	if (route == routes.end())
+	{
+		if (routes.size() < FPATH_CACHE_ROUTES_PER_LANE)
+		{
+			routes.push_back(PathCachedRoute());
+		}
+		route = std::prev(routes.end());  // Recycle the last recently used route.
+	}
+	route->generation = generation;
+	route->avoidsDanger = avoidsDanger;
+	route->sectorS = sectorS;
+	route->sectorF = sectorF;
+	route->dstIgnore = dstIgnore;
+	route->path = psMove->asPath;
+	routes.splice(routes.begin(), routes, route);
+}
+
+/// Finds a route by searching the tiles.
+static ASR_RETVAL fpathAStarSearchRoute(MOVE_CONTROL *psMove, PATHJOB *psJob, unsigned lane)
+{
+	const PathCoord tileOrig(map_coord(psJob->origX), map_coord(psJob->origY));
+	const PathCoord tileDest(map_coord(psJob->destX), map_coord(psJob->destY));
+
+	// Plan long routes on the cluster graph first, and then only search the tiles along the planned route.
+	// Danger maps aren't part of the cluster graph, so routes avoiding danger are always searched on the whole map.
+	PathBlockingMap const &blockingMap = *psJob->blockingMap;
+	std::vector<bool> corridor;
+	if (blockingMap.clusterGraph != nullptr && blockingMap.dangerMap.empty() && fpathEstimate(tileOrig, tileDest) >= PATH_CLUSTER_MIN_ROUTE
+	    && fpathClusterCorridor(*blockingMap.clusterGraph, Vector2i(tileOrig.x, tileOrig.y), Vector2i(tileDest.x, tileDest.y), corridor))
+	{
+		ASR_RETVAL retval = fpathAStarCorridorRoute(psMove, psJob, lane, corridor);
+		if (retval == ASR_OK)
+		{
+			return retval;
+		}
+		objTrace(psJob->droidID, "Route not found in corridor, searching whole map");
+		corridor.clear();
+	}
+
+	return fpathAStarCorridorRoute(psMove, psJob, lane, corridor);
+}
+
+ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob, unsigned lane)
+{
+	ASSERT_OR_RETURN(ASR_FAILED, lane < FPATH_LANES, "Bad path lane %u", lane);
+
+	const PathCoord tileOrig(map_coord(psJob->origX), map_coord(psJob->origY));
+	const PathCoord tileDest(map_coord(psJob->destX), map_coord(psJob->destY));
+
+	if (psJob->groupMove && fpathFlowFieldRoute(psMove, psJob, lane))
+	{
+		objTrace(psJob->droidID, "Got route of length %d from flow field", (int)psMove->asPath.size());
+		return ASR_OK;
+	}
+
+	// Routes within a sector are cheap to search, so only cache routes between sectors.
+	const PathCoord sectorS(tileOrig.x / FPATH_CACHE_SECTOR_SIZE, tileOrig.y / FPATH_CACHE_SECTOR_SIZE);
+	const PathCoord sectorF(tileDest.x / FPATH_CACHE_SECTOR_SIZE, tileDest.y / FPATH_CACHE_SECTOR_SIZE);
+	bool useCache = sectorS != sectorF;
+	if (useCache)
+	{
+		if (fpathCacheRoute(psMove, psJob, lane, sectorS, sectorF))
+		{
+			++fpathCacheHits;
+			objTrace(psJob->droidID, "Got route of length %d from route cache", (int)psMove->asPath.size());
+			return ASR_OK;
+		}
+		++fpathCacheMisses;
+	}
+
+	ASR_RETVAL retval = fpathAStarSearchRoute(psMove, psJob, lane);
+	if (useCache && retval == ASR_OK)
+	{
+		fpathCacheStore(psMove, psJob, lane, sectorS, sectorF);
+	}
+	return retval;
+}
+
+void fpathCacheStatistics(unsigned *hits, unsigned *misses)
+{
+	*hits = fpathCacheHits;
+	*misses = fpathCacheMisses;
+}
+
+void fpathMarkBlockingChanged(StructureBounds const &area)
+{
+	for (auto &cache : fpathBlockingCaches)
+	{
+		int x1 = std::max(area.map.x, 0), x2 = std::min(area.map.x + area.size.x, cache.changed.width);
+		int y1 = std::max(area.map.y, 0), y2 = std::min(area.map.y + area.size.y, cache.changed.height);
+		for (int y = y1; y < y2; ++y)
+			for (int x = x1; x < x2; ++x)
+			{
+				cache.changed.set(x, y, true);
+				cache.anyChanged = true;
+			}
+	}
+}
+
+/// Returns the up to date blocking map for the given type of map.
+static PathBlockingCache &fpathUpdateBlockingCache(PathBlockingType const &type)
+{
+	PathBlockingStamp stamp;
+	stamp.width = mapWidth;
+	stamp.height = mapHeight;
+	stamp.scrollMinX = scrollMinX;
+	stamp.scrollMinY = scrollMinY;
+	stamp.scrollMaxX = scrollMaxX;
+	stamp.scrollMaxY = scrollMaxY;
+	stamp.auxMapVersion = auxMapVersion;
+
+	auto cache = std::find_if(fpathBlockingCaches.begin(), fpathBlockingCaches.end(), [&](PathBlockingCache const &c) {
+		return fpathIsEquivalentBlocking(c.type.propulsion, c.type.owner, c.type.moveType,
+		                                 type.propulsion,   type.owner,   type.moveType);
+	});
+	bool rebuild = cache == fpathBlockingCaches.end() || !(cache->stamp == stamp);
+	if (cache == fpathBlockingCaches.end())
+	{
+		fpathBlockingCaches.emplace_back();
+		cache = fpathBlockingCaches.end() - 1;
+		cache->type = type;
+	}
+
+	bool modified = false;
+	if (rebuild)
+	{
+		cache->stamp = stamp;
+		cache->map.resize(mapWidth, mapHeight);
+		cache->changed.resize(mapWidth, mapHeight);
+		cache->anyChanged = false;
+		for (int y = 0; y < mapHeight; ++y)
+			for (int x = 0; x < mapWidth; ++x)
+			{
+				cache->map.set(x, y, fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType));
+			}
+		modified = true;
+	}
+	else if (cache->anyChanged)
+	{
+		// Only recalculate the tiles which were marked as changed, skipping 64 unchanged tiles at a time.
+		for (int y = 0; y < mapHeight; ++y)
+			for (int w = 0; w < cache->changed.wordsPerRow; ++w)
+			{
+				uint64_t &changedWord = cache->changed.words[w + y * cache->changed.wordsPerRow];
+				for (int bit = 0; changedWord != 0; ++bit, changedWord >>= 1)
+				{
+					if ((changedWord & 1) != 0)
+					{
+						int x = w * 64 + bit;
+						bool blocking = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
+						modified |= blocking != cache->map.get(x, y);
+						cache->map.set(x, y, blocking);
+					}
+				}
+			}
+		cache->anyChanged = false;
+	}
+
+	if (modified)
+	{
+		cache->generation = ++fpathBlockingGeneration;
+	}
+	if (modified && type.propulsion != PROPULSION_TYPE_LIFT)  // Air units are hardly ever blocked, so don't need a cluster graph.
+	{
+		cache->clusterGraph = fpathUpdateClusterGraph(cache->clusterGraph, cache->map, mapWidth, mapHeight);
+	}
+	return *cache;
+}
+
+/// Checksum for syncDebug.
+static uint32_t fpathChecksumBitMap(PathBitMap const &map)
+{
+	uint32_t checksum = 0, factor = 0;
+	for (uint64_t word : map.words)
+	{
+		checksum ^= (uint32_t)(word ^ word >> 32) * (factor = 3 * factor + 1);
+	}
+	return checksum;
+}
+
 void fpathSetBlockingMap(PATHJOB *psJob)
 {
 	if (fpathCurrentGameTime != gameTime)
@@ -624,28 +1252,24 @@ void fpathSetBlockingMap(PATHJOB *psJob)
 		PathBlockingMap *blockMap = new PathBlockingMap();
 		fpathBlockingMaps.emplace_back(blockMap);
 
-		// blockMap now points to an empty map with no data. Fill the map.
+		// blockMap now points to an empty map with no data. Fill the map, from the incrementally updated copy.
+		PathBlockingCache &cache = fpathUpdateBlockingCache(type);
 		blockMap->type = type;
-		std::vector<bool> &map = blockMap->map;
-		map.resize(mapWidth * mapHeight);
-		uint32_t checksumMap = 0, checksumDangerMap = 0, factor = 0;
-		for (int y = 0; y < mapHeight; ++y)
-			for (int x = 0; x < mapWidth; ++x)
-			{
-				map[x + y * mapWidth] = fpathBaseBlockingTile(x, y, type.propulsion, type.owner, type.moveType);
-				checksumMap ^= map[x + y * mapWidth] * (factor = 3 * factor + 1);
-			}
+		blockMap->map = cache.map;
+		blockMap->clusterGraph = cache.clusterGraph;
+		uint32_t checksumMap = fpathChecksumBitMap(blockMap->map), checksumDangerMap = 0;
 		if (!isHumanPlayer(type.owner) && type.moveType == FMT_MOVE)
 		{
-			std::vector<bool> &dangerMap = blockMap->dangerMap;
-			dangerMap.resize(mapWidth * mapHeight);
+			PathBitMap &dangerMap = blockMap->dangerMap;
+			dangerMap.resize(mapWidth, mapHeight);
 			for (int y = 0; y < mapHeight; ++y)
 				for (int x = 0; x < mapWidth; ++x)
 				{
-					dangerMap[x + y * mapWidth] = auxTile(x, y, type.owner) & AUXBITS_THREAT;
-					checksumDangerMap ^= dangerMap[x + y * mapWidth] * (factor = 3 * factor + 1);
+					dangerMap.set(x, y, auxTile(x, y, type.owner) & AUXBITS_THREAT);
 				}
+			checksumDangerMap = fpathChecksumBitMap(dangerMap);
 		}
+		blockMap->generation = cache.generation;
 		syncDebug("blockingMap(%d,%d,%d,%d) = %08X %08X", gameTime, psJob->propulsion, psJob->owner, psJob->moveType, checksumMap, checksumDangerMap);
 
 		psJob->blockingMap = fpathBlockingMaps.back();
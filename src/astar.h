@@ -23,6 +23,8 @@
 
 #include "fpath.h"
 
+#include <vector>
+
 /** return codes for astar
  *
  *  @ingroup pathfinding
@@ -34,11 +36,59 @@ enum ASR_RETVAL
 	ASR_NEAREST,    ///< found a partial route to a nearby position
 };
 
-/** Use the A* algorithm to find a path
+/** Bit-packed map of tiles, with 64 tiles per word, and each row starting on a new word.
  *
  *  @ingroup pathfinding
  */
-ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob);
+struct PathBitMap
+{
+	void resize(int width_, int height_)
+	{
+		width = width_;
+		height = height_;
+		wordsPerRow = (width + 63) / 64;
+		words.assign(wordsPerRow * height, 0);
+	}
+	bool empty() const
+	{
+		return words.empty();
+	}
+	bool get(int x, int y) const
+	{
+		return (words[x / 64 + y * wordsPerRow] >> (x % 64)) & 1;
+	}
+	void set(int x, int y, bool value)
+	{
+		uint64_t bit = (uint64_t)1 << (x % 64);
+		uint64_t &word = words[x / 64 + y * wordsPerRow];
+		word = value ? word | bit : word & ~bit;
+	}
+
+	int width = 0, height = 0;
+	int wordsPerRow = 0;
+	std::vector<uint64_t> words;
+};
+
+/** Number of independent path lanes.
+ *
+ *  Each lane has its own cache of A* contexts, and must process its jobs one at a time, in
+ *  the order they were queued. Different lanes may be processed in parallel by different threads.
+ *
+ *  @ingroup pathfinding
+ */
+#define FPATH_LANES 8
+
+/** Returns the lane which should process the given job. Jobs to the same destination always share a lane.
+ *
+ *  @ingroup pathfinding
+ */
+unsigned fpathJobLane(PATHJOB const *psJob);
+
+/** Use the A* algorithm to find a path, using and updating the cached contexts and routes of the given lane.
+ *
+ *  @ingroup pathfinding
+ */
+ASR_RETVAL fpathAStarRoute(MOVE_CONTROL *psMove, PATHJOB *psJob, unsigned lane);
 
 /// Call from main thread.
 /// Sets psJob->blockingMap for later use by pathfinding thread, generating the required map if not already generated.
@@ -52,4 +102,10 @@ void fpathSetBlockingMap(PATHJOB *psJob);
  */
 void fpathHardTableReset();
 
+/** Gets the number of path jobs which were and weren't served from the route caches, since the last fpathHardTableReset.
+ *
+ *  @ingroup pathfinding
+ */
+void fpathCacheStatistics(unsigned *hits, unsigned *misses);
+
 #endif // __INCLUDED_SRC_ASTART_H__
@@ -50,6 +50,27 @@ struct TILEPOS
 	UBYTE x, y, type;
 };
 
+/// What an object's watched tiles were calculated from. The tiles only need recalculating if any of this changes.
+struct WATCHEDFROM
+{
+	bool operator ==(WATCHEDFROM const &b) const
+	{
+		return map == b.map && heightVersion == b.heightVersion && x == b.x && y == b.y && z == b.z && radius == b.radius && player == b.player && allianceBits == b.allianceBits && jammer == b.jammer;
+	}
+	bool operator !=(WATCHEDFROM const &b) const
+	{
+		return !(*this == b);
+	}
+
+	const void *map = nullptr;       ///< Map the tiles are on, nullptr if the watched tiles are not valid
+	uint32_t heightVersion = 0;      ///< Value of mapHeightVersion
+	int x = 0, y = 0, z = 0;         ///< Tile coordinates of the object, and height of its sensor
+	unsigned radius = 0;             ///< Sensor range
+	unsigned player = 0;             ///< Owner of the object
+	uint32_t allianceBits = 0;       ///< Players the exploration was shared with
+	bool jammer = false;             ///< Whether the object jams the tiles
+};
+
 /*
  Coordinate system used for objects in Warzone 2100:
   x - "right"
@@ -125,6 +146,7 @@ struct BASE_OBJECT : public SIMPLE_OBJECT
 	UDWORD              periodicalDamageStart;                  ///< When the object entered the fire
 	UDWORD              periodicalDamage;                 ///< How much damage has been done since the object entered the fire
 	TILEPOS             *watchedTiles;              ///< Variable size array of watched tiles, NULL for features
+	WATCHEDFROM         watchedFrom;                ///< What watchedTiles were calculated from
 
 	UDWORD              timeAnimationStarted;       ///< Animation start time, zero for do not animate
 	UBYTE               animationEvent;             ///< If animation start time > 0, this points to which animation to run
@@ -0,0 +1,153 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file benchmark.cpp
+ *
+ * Simulation benchmark, timing the parts of gameStateUpdate.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "benchmark.h"
+#include "multiplay.h"
+#include "version.h"
+
+static unsigned benchmarkTicksWanted = 0;
+static unsigned benchmarkTicksRun = 0;
+static bool benchmarkIsRunning = false;
+static bool benchmarkHasFailed = false;
+static std::chrono::steady_clock::time_point benchmarkStartTime;
+static std::chrono::steady_clock::time_point benchmarkLastTickTime;
+static std::chrono::steady_clock::duration benchmarkTotalTime;
+static std::chrono::steady_clock::duration benchmarkSectionTime[BENCHMARK_SECTIONS];
+
+/// Names of the sections in the report, which scripts tracking regressions depend on.
+static const char *benchmarkSectionName[BENCHMARK_SECTIONS] =
+{
+	"scripts",
+	"visibility",
+	"grid",
+	"droids",
+	"structures",
+	"projectiles",
+	"pathfinding_wait",
+	"objmem",
+};
+
+void benchmarkSetTicks(unsigned ticks)
+{
+	benchmarkTicksWanted = ticks;
+}
+
+bool benchmarkEnabled()
+{
+	return benchmarkTicksWanted != 0;
+}
+
+bool benchmarkRunning()
+{
+	return benchmarkIsRunning;
+}
+
+void benchmarkStart()
+{
+	benchmarkTicksRun = 0;
+	std::fill(benchmarkSectionTime, benchmarkSectionTime + BENCHMARK_SECTIONS, std::chrono::steady_clock::duration::zero());
+	benchmarkIsRunning = true;
+	benchmarkHasFailed = false;
+	benchmarkStartTime = std::chrono::steady_clock::now();
+	benchmarkLastTickTime = benchmarkStartTime;
+}
+
+bool benchmarkTickDone()
+{
+	++benchmarkTicksRun;
+	benchmarkLastTickTime = std::chrono::steady_clock::now();
+	if (benchmarkTicksRun < benchmarkTicksWanted)
+	{
+		return true;
+	}
+	benchmarkTotalTime = benchmarkLastTickTime - benchmarkStartTime;
+	benchmarkIsRunning = false;
+	return false;
+}
+
+bool benchmarkTickWaiting()
+{
+	if (std::chrono::steady_clock::now() - benchmarkLastTickTime < std::chrono::seconds(BENCHMARK_STALL_TIMEOUT))
+	{
+		return true;
+	}
+	debug(LOG_ERROR, "Benchmark stalled, no game state update for %d seconds after %u of %u ticks.", BENCHMARK_STALL_TIMEOUT, benchmarkTicksRun, benchmarkTicksWanted);
+	benchmarkIsRunning = false;
+	benchmarkHasFailed = true;
+	return false;
+}
+
+bool benchmarkFailed()
+{
+	return benchmarkHasFailed;
+}
+
+void benchmarkAddTime(BENCHMARK_SECTION section, std::chrono::steady_clock::duration time)
+{
+	benchmarkSectionTime[section] += time;
+}
+
+static double benchmarkMilliseconds(std::chrono::steady_clock::duration time)
+{
+	return std::chrono::duration<double, std::milli>(time).count();
+}
+
+/// Prints str as a quoted JSON string.
+static void benchmarkPrintString(char const *str)
+{
+	putchar('"');
+	for (unsigned char const *c = (unsigned char const *)str; *c != '\0'; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+		{
+			printf("\\%c", *c);
+		}
+		else if (*c < 0x20)
+		{
+			printf("\\u%04x", *c);
+		}
+		else
+		{
+			putchar(*c);
+		}
+	}
+	putchar('"');
+}
+
+void benchmarkReport()
+{
+	printf("{\"version\": ");
+	benchmarkPrintString(version_getVersionString());
+	printf(", \"map\": ");
+	benchmarkPrintString(game.map);
+	printf(", \"ticks\": %u, \"total_ms\": %.3f, \"sections_ms\": {", benchmarkTicksRun, benchmarkMilliseconds(benchmarkTotalTime));
+	for (int section = 0; section < BENCHMARK_SECTIONS; ++section)
+	{
+		printf("%s\"%s\": %.3f", section == 0 ? "" : ", ", benchmarkSectionName[section], benchmarkMilliseconds(benchmarkSectionTime[section]));
+	}
+	printf("}}\n");
+	fflush(stdout);
+}
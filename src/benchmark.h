@@ -0,0 +1,103 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Measures how fast the game state updates, by running a loaded game without rendering and timing each part of the
+ *  update separately.
+ */
+
+#ifndef __INCLUDED_SRC_BENCHMARK_H__
+#define __INCLUDED_SRC_BENCHMARK_H__
+
+#include <chrono>
+
+/// How many times faster than real time the game may run while benchmarking. High enough that ticks never wait for the clock.
+#define BENCHMARK_GAME_SPEED 10000
+
+/// Seconds without a game state update before giving up, since a stalled or paused game would otherwise never finish.
+#define BENCHMARK_STALL_TIMEOUT 60
+
+/// Parts of gameStateUpdate which are timed separately.
+enum BENCHMARK_SECTION
+{
+	BENCHMARK_SCRIPTS,
+	BENCHMARK_VISIBILITY,
+	BENCHMARK_GRID,
+	BENCHMARK_DROIDS,
+	BENCHMARK_STRUCTURES,
+	BENCHMARK_PROJECTILES,
+	BENCHMARK_PATHFINDING_WAIT,  ///< Time spent waiting for the path threads, which is also part of BENCHMARK_DROIDS.
+	BENCHMARK_OBJMEM,
+	BENCHMARK_SECTIONS
+};
+
+/// Makes the next game loaded run for ticks game ticks as fast as possible, then report the timings and quit.
+void benchmarkSetTicks(unsigned ticks);
+
+/// Whether the game should be run as a benchmark, instead of played.
+bool benchmarkEnabled();
+
+/// Whether game state updates are being timed.
+bool benchmarkRunning();
+
+/// Starts timing the game state updates.
+void benchmarkStart();
+
+/// Records that a game state update finished. Returns false when all the ticks have been run.
+bool benchmarkTickDone();
+
+/// Records that no game state update was due. Returns false, and stops the benchmark as failed, if there hasn't been one for BENCHMARK_STALL_TIMEOUT seconds.
+bool benchmarkTickWaiting();
+
+/// Whether the benchmark was stopped because the game stalled.
+bool benchmarkFailed();
+
+/// Prints the timings to stdout, as a single line of JSON.
+void benchmarkReport();
+
+void benchmarkAddTime(BENCHMARK_SECTION section, std::chrono::steady_clock::duration time);
+
+/// Adds the time until it goes out of scope to section, if benchmarkRunning.
+class BenchmarkTimer
+{
+public:
+	BenchmarkTimer(BENCHMARK_SECTION section) : section(section), running(benchmarkRunning())
+	{
+		if (running)
+		{
+			start = std::chrono::steady_clock::now();
+		}
+	}
+	~BenchmarkTimer()
+	{
+		if (running)
+		{
+			benchmarkAddTime(section, std::chrono::steady_clock::now() - start);
+		}
+	}
+
+private:
+	BenchmarkTimer(BenchmarkTimer const &) = delete;
+	BenchmarkTimer &operator =(BenchmarkTimer const &) = delete;
+
+	BENCHMARK_SECTION section;
+	bool running;
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif // __INCLUDED_SRC_BENCHMARK_H__
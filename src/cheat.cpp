@@ -81,6 +81,8 @@ static CHEAT_ENTRY cheatCodes[] =
 	{"showorders", kf_ToggleOrders}, //displays unit order/action state.
 	{"pause", kf_TogglePauseMode}, // Pause the game.
 	{"power info", kf_PowerInfo},
+	{"path info", kf_PathInfo},	// show how many paths were found in the route cache
+	{"pool info", kf_PoolInfo},	// show how many objects were allocated from the object pools
 	{"reload me", kf_Reload},	// reload selected weapons immediately
 	{"desync me", kf_ForceDesync},
 	{"damage me", kf_DamageMe},
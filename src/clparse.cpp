@@ -30,6 +30,7 @@
 #include "lib/netplay/netplay.h"
 #include "lib/ivis_opengl/pieclip.h"
 
+#include "benchmark.h"
 #include "levels.h"
 #include "clparse.h"
 #include "display3d.h"
@@ -252,6 +253,7 @@ typedef enum
 	CLI_AUTOGAME,
 	CLI_SAVEANDQUIT,
 	CLI_SKIRMISH,
+	CLI_BENCHMARK,
 } CLI_OPTIONS;
 
 static const struct poptOption *getOptionsTable()
@@ -288,6 +290,7 @@ static const struct poptOption *getOptionsTable()
 		{ "autogame",   '\0', POPT_ARG_NONE,   nullptr, CLI_AUTOGAME,   N_("Run games automatically for testing"), nullptr, true },
 		{ "saveandquit", '\0', POPT_ARG_STRING, nullptr, CLI_SAVEANDQUIT, N_("Immediately save game and quit"), N_("save name"), true },
 		{ "skirmish",   '\0', POPT_ARG_STRING, nullptr, CLI_SKIRMISH,   N_("Start skirmish game with given settings file"), N_("test"), true },
+		{ "benchmark",  '\0', POPT_ARG_STRING, nullptr, CLI_BENCHMARK,  N_("Run the loaded game for the given number of ticks without rendering, print timings and quit"), N_("ticks"), true },
 		// Terminating entry
 		{ nullptr,         '\0', 0,               nullptr, 0,              nullptr,                                    nullptr, true },
 	};
@@ -656,6 +659,15 @@ bool ParseCommandLine(int argc, const char * const *argv)
 			}
 			wz_test = token;
 			break;
+
+		case CLI_BENCHMARK:
+			token = poptGetOptArg(poptCon);
+			if (token == nullptr || atoi(token) <= 0)
+			{
+				qFatal("Bad number of benchmark ticks");
+			}
+			benchmarkSetTicks(atoi(token));
+			break;
 		};
 	}
 
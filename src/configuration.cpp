@@ -125,6 +125,7 @@ bool loadConfig()
 	radarRotationArrow = ini.value("radarRotationArrow", true).toBool();
 	hostQuitConfirmation = ini.value("hostQuitConfirmation", true).toBool();
 	war_SetPauseOnFocusLoss(ini.value("PauseOnFocusLoss", false).toBool());
+	war_SetPathThreads(ini.value("pathThreads", 0).toInt());
 	NETsetMasterserverName(ini.value("masterserver_name", "lobby.wz2100.net").toString().toUtf8().constData());
 	iV_font(ini.value("fontname", "DejaVu Sans").toString().toUtf8().constData(),
 	        ini.value("fontface", "Book").toString().toUtf8().constData(),
@@ -269,6 +270,7 @@ bool saveConfig()
 	ini.setValue("radarRotationArrow", radarRotationArrow);
 	ini.setValue("hostQuitConfirmation", hostQuitConfirmation);
 	ini.setValue("PauseOnFocusLoss", war_GetPauseOnFocusLoss());
+	ini.setValue("pathThreads", war_GetPathThreads());
 	ini.setValue("masterserver_name", NETgetMasterserverName());
 	ini.setValue("masterserver_port", NETgetMasterserverPort());
 	ini.setValue("gameserver_port", NETgetGameserverPort());
@@ -1951,9 +1951,9 @@ void	dealWithLMB()
 			console("%s tile %d, %d [%d, %d] continent(l%d, h%d) level %g illum %d %s %s w=%d s=%d j=%d",
 			        tileIsExplored(psTile) ? "Explored" : "Unexplored",
 			        mouseTileX, mouseTileY, world_coord(mouseTileX), world_coord(mouseTileY),
-			        (int)psTile->limitedContinent, (int)psTile->hoverContinent, psTile->level, (int)psTile->illumination,
+			        (int)psTile->limitedContinent, (int)psTile->hoverContinent, mapTileLight(psTile)->level, (int)mapTileLight(psTile)->illumination,
 			        aux & AUXBITS_DANGER ? "danger" : "", aux & AUXBITS_THREAT ? "threat" : "",
-			        (int)psTile->watchers[selectedPlayer], (int)psTile->sensors[selectedPlayer], (int)psTile->jammers[selectedPlayer]);
+			        (int)mapTileVision(psTile)->watchers[selectedPlayer], (int)mapTileVision(psTile)->sensors[selectedPlayer], (int)mapTileVision(psTile)->jammers[selectedPlayer]);
 		}
 
 		return;
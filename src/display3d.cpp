@@ -1056,10 +1056,10 @@ static void drawTiles(iView *player)
 
 			if (tileOnMap(playerXTile + j, playerZTile + i))
 			{
-				MAPTILE *psTile = mapTile(playerXTile + j, playerZTile + i);
+				MAPTILE_LIGHT *psLight = mapTileLight(playerXTile + j, playerZTile + i);
 
 				pos.y = map_TileHeight(playerXTile + j, playerZTile + i);
-				setTileColour(playerXTile + j, playerZTile + i, pal_SetBrightness(psTile->level));
+				setTileColour(playerXTile + j, playerZTile + i, pal_SetBrightness(psLight->level));
 			}
 			tileScreenInfo[idx][jdx].z = pie_RotateProject(&pos, viewMatrix, &screen);
 			tileScreenInfo[idx][jdx].x = screen.x;
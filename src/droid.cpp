@@ -74,6 +74,7 @@
 #include "scriptfuncs.h"			//for ThreatInRange()
 #include "template.h"
 #include "qtscript.h"
+#include "objectpool.h"
 
 #define DEFAULT_RECOIL_TIME	(GAME_TICKS_PER_SEC/4)
 #define	DROID_DAMAGE_SPREAD	(16 - rand()%32)
@@ -360,6 +361,18 @@ DROID::DROID(uint32_t id, unsigned player)
 	lastFrustratedTime = 0;		// make sure we do not start the game frustrated
 }
 
+static ObjectPool droidPool("droids", sizeof(DROID));
+
+void *DROID::operator new(size_t size)
+{
+	return droidPool.allocate(size);
+}
+
+void DROID::operator delete(void *ptr)
+{
+	droidPool.release(ptr);
+}
+
 /* DROID::~DROID: release all resources associated with a droid -
  * should only be called by objmem - use vanishDroid preferably
  */
@@ -592,7 +605,7 @@ bool destroyDroid(DROID *psDel, unsigned impactTime)
 				psTile = mapTile(width, breadth);
 				if (TEST_TILE_VISIBLE(selectedPlayer, psTile))
 				{
-					psTile->illumination /= 2;
+					mapTileLight(psTile)->illumination /= 2;
 				}
 			}
 		}
@@ -0,0 +1,292 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Encoding of queued droid orders in GAME_DROIDINFO messages.
+ *
+ *  A message is the format version, the number of orders, and then each order followed by its droids. Each order is
+ *  sent as a reference to one of the recent orders in the templates, or in full. The droid IDs are sent as runs of IDs
+ *  2 apart, first the runs of odd IDs, then the runs of even IDs.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/netplay/netplay.h"
+
+#include "droidinfo.h"
+
+/// Does not read/write info->droidId!
+static void NETQueuedDroidInfo(QueuedDroidInfo *info)
+{
+	NETuint8_t(&info->player);
+	NETenum(&info->subType);
+	switch (info->subType)
+	{
+	case ObjOrder:
+	case LocOrder:
+		NETenum(&info->order);
+		if (info->subType == ObjOrder)
+		{
+			NETuint32_t(&info->destId);
+			NETenum(&info->destType);
+		}
+		else
+		{
+			NETauto(&info->pos);
+		}
+		if (info->order == DORDER_BUILD || info->order == DORDER_LINEBUILD)
+		{
+			NETuint32_t(&info->structRef);
+			NETuint16_t(&info->direction);
+		}
+		if (info->order == DORDER_LINEBUILD)
+		{
+			NETauto(&info->pos2);
+		}
+		if (info->order == DORDER_BUILDMODULE)
+		{
+			NETauto(&info->index);
+		}
+		NETbool(&info->add);
+		break;
+	case SecondaryOrder:
+		NETenum(&info->secOrder);
+		NETenum(&info->secState);
+		break;
+	}
+}
+
+/// Returns true if the orders are the same, except maybe for the target position of a LocOrder.
+static bool sameOrderExceptPos(QueuedDroidInfo const &a, QueuedDroidInfo b)
+{
+	if (a.subType != LocOrder || b.subType != LocOrder)
+	{
+		return false;
+	}
+	b.pos = a.pos;
+	return a.orderCompare(b) == 0;
+}
+
+/// Moves the order to the front of the templates, dropping the template at the given index, or the oldest template if index is out of range.
+static void useOrderTemplate(std::vector<QueuedDroidInfo> &templates, size_t index, QueuedDroidInfo const &order)
+{
+	if (index < templates.size())
+	{
+		templates.erase(templates.begin() + index);
+	}
+	else if (templates.size() >= DROIDINFO_TEMPLATES)
+	{
+		templates.pop_back();
+	}
+	templates.insert(templates.begin(), order);
+}
+
+/// Reads/writes an order, as a reference to one of the recent templates if possible.
+/// Written as 0 followed by the whole order, or as 1 + 2*index of the template, plus 1 if followed by a change of position.
+/// Returns false if decoding a reference to a template which doesn't exist.
+static bool NETQueuedDroidInfoTemplate(QueuedDroidInfo *info, std::vector<QueuedDroidInfo> &templates)
+{
+	uint32_t ref = 0;
+	if (NETgetPacketDir() == PACKET_ENCODE)
+	{
+		for (size_t i = 0; i < templates.size() && ref == 0; ++i)
+		{
+			if (templates[i].orderCompare(*info) == 0)
+			{
+				ref = 1 + 2 * i;
+			}
+		}
+		for (size_t i = 0; i < templates.size() && ref == 0; ++i)
+		{
+			if (sameOrderExceptPos(templates[i], *info))
+			{
+				ref = 1 + 2 * i + 1;
+			}
+		}
+	}
+	NETuint32_t(&ref);
+
+	size_t index = (ref - 1) / 2;
+	if (ref == 0)
+	{
+		NETQueuedDroidInfo(info);
+		index = templates.size();
+	}
+	else if (index < templates.size())
+	{
+		QueuedDroidInfo const &base = templates[index];
+		if (NETgetPacketDir() == PACKET_DECODE)
+		{
+			*info = base;
+		}
+		if ((ref - 1) % 2 != 0)
+		{
+			// Encode the change of position, since orders to move to places near the last order are common.
+			Vector2i delta = info->pos - base.pos;
+			NETauto(&delta);
+			info->pos = base.pos + delta;
+		}
+	}
+	else
+	{
+		debug(LOG_ERROR, "Bad droid order template %u.", ref);
+		return false;
+	}
+	info->droidId = 0;
+	useOrderTemplate(templates, index, *info);
+	return true;
+}
+
+void NETencodeDroidInfo(std::vector<QueuedDroidInfo> const &orders, std::vector<QueuedDroidInfo> &templates)
+{
+	uint8_t format = DROIDINFO_FORMAT;
+	NETuint8_t(&format);
+
+	uint32_t numOrders = !orders.empty();
+	for (size_t n = 1; n < orders.size(); ++n)
+	{
+		numOrders += orders[n].orderCompare(orders[n - 1]) != 0;
+	}
+	NETuint32_t(&numOrders);
+
+	std::vector<DroidIdRun> runs;
+	std::vector<QueuedDroidInfo>::const_iterator eqBegin, eqEnd;
+	for (eqBegin = orders.begin(); eqBegin != orders.end(); eqBegin = eqEnd)
+	{
+		// Find end of range of orders which differ only by the droid ID.
+		for (eqEnd = eqBegin + 1; eqEnd != orders.end() && eqEnd->orderCompare(*eqBegin) == 0; ++eqEnd)
+		{}
+
+		QueuedDroidInfo info = *eqBegin;
+		NETQueuedDroidInfoTemplate(&info, templates);
+
+		// Synchronised droids have odd IDs, so a box-selected group of droids built one after the other has IDs 2 apart.
+		for (uint32_t parity : {1, 0})
+		{
+			runs.clear();
+			for (std::vector<QueuedDroidInfo>::const_iterator i = eqBegin; i != eqEnd; ++i)
+			{
+				if ((i->droidId & 1) != parity)
+				{
+					continue;
+				}
+				if (!runs.empty() && i->droidId == runs.back().firstId + 2 * runs.back().count)
+				{
+					++runs.back().count;
+				}
+				else
+				{
+					runs.push_back(DroidIdRun{i->droidId, 1});
+				}
+			}
+			uint32_t numRuns = runs.size();
+			NETuint32_t(&numRuns);
+
+			// Each run is the (even) delta from the last droid ID of the previous run, plus 1 if followed by the number of further droids in the run.
+			// Deltas are smaller than the actual droid IDs, and will encode to less bytes on average.
+			uint32_t prevDroidId = parity;
+			for (DroidIdRun const &run : runs)
+			{
+				uint32_t runDelta = (run.firstId - prevDroidId) + (run.count > 1);
+				NETuint32_t(&runDelta);
+				if (run.count > 1)
+				{
+					uint32_t runLength = run.count - 1;
+					NETuint32_t(&runLength);
+				}
+				prevDroidId = run.firstId + 2 * (run.count - 1);
+			}
+		}
+	}
+}
+
+bool NETdecodeDroidInfo(std::vector<DroidInfoOrder> &orders, std::vector<QueuedDroidInfo> &templates)
+{
+	orders.clear();
+
+	uint8_t format = 0;
+	NETuint8_t(&format);
+	if (format != DROIDINFO_FORMAT)
+	{
+		debug(LOG_ERROR, "Droid orders in unknown format %d.", format);
+		return false;
+	}
+
+	// Only update the templates if the whole message is valid, since they must stay the same as the sender's templates.
+	std::vector<QueuedDroidInfo> newTemplates = templates;
+
+	// Each order takes at least 3 bytes, and each run at least 1 byte, so a message can't claim more than fit in it.
+	uint32_t numOrders = 0;
+	NETuint32_t(&numOrders);
+	if (numOrders > NETbytesLeft() / 3)
+	{
+		debug(LOG_ERROR, "Droid orders claim %u orders in %u bytes.", numOrders, (unsigned)NETbytesLeft());
+		return false;
+	}
+	// Count the droids in all the orders, since each one costs a lookup and an order on the game thread.
+	uint32_t numDroids = 0;
+	for (unsigned order = 0; order < numOrders; ++order)
+	{
+		orders.push_back(DroidInfoOrder());
+		DroidInfoOrder &decoded = orders.back();
+		if (!NETQueuedDroidInfoTemplate(&decoded.info, newTemplates))
+		{
+			return false;
+		}
+
+		for (uint32_t parity : {1, 0})
+		{
+			uint32_t numRuns = 0;
+			NETuint32_t(&numRuns);
+			if (numRuns > NETbytesLeft())
+			{
+				debug(LOG_ERROR, "Droid orders claim %u runs in %u bytes.", numRuns, (unsigned)NETbytesLeft());
+				return false;
+			}
+
+			uint32_t droidId = parity;
+			for (unsigned run = 0; run < numRuns; ++run)
+			{
+				// Get the next run of droid IDs which are being given this order.
+				uint32_t runDelta = 0;
+				NETuint32_t(&runDelta);
+				uint32_t runLength = 0;
+				if ((runDelta & 1) != 0)
+				{
+					NETuint32_t(&runLength);
+				}
+				if (runLength >= DROIDINFO_MAX_DROIDS - numDroids)
+				{
+					debug(LOG_ERROR, "Droid orders for too many droids.");
+					return false;
+				}
+				numDroids += runLength + 1;
+				droidId += runDelta & ~1;
+				decoded.runs.push_back(DroidIdRun{droidId, runLength + 1});
+				droidId += 2 * runLength;
+			}
+		}
+		if (!NETdecodeValid())
+		{
+			debug(LOG_ERROR, "Droid orders truncated.");
+			return false;
+		}
+	}
+
+	templates.swap(newTemplates);
+	return true;
+}
@@ -0,0 +1,191 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Encoding of queued droid orders in GAME_DROIDINFO messages.
+ */
+
+#ifndef __INCLUDED_SRC_DROIDINFO_H__
+#define __INCLUDED_SRC_DROIDINFO_H__
+
+#include "orderdef.h"
+
+#include <vector>
+
+/// Version of the GAME_DROIDINFO format, sent at the start of each message.
+#define DROIDINFO_FORMAT 1
+
+/// Number of recent orders remembered per game queue, which later orders can refer to instead of being sent in full.
+#define DROIDINFO_TEMPLATES 16
+
+/// Most droids accepted in one message, counted once for each order they are given, more than anyone could order at once.
+#define DROIDINFO_MAX_DROIDS 100000
+
+enum SubType
+{
+	ObjOrder, LocOrder, SecondaryOrder
+};
+
+struct QueuedDroidInfo
+{
+	/// Sorts by order, then finally by droid id, to group multiple droids with the same order.
+	bool operator <(QueuedDroidInfo const &z) const
+	{
+		int orComp = orderCompare(z);
+		if (orComp != 0)
+		{
+			return orComp < 0;
+		}
+		return droidId < z.droidId;
+	}
+	/// Returns 0 if order is the same, non-zero otherwise.
+	int orderCompare(QueuedDroidInfo const &z) const
+	{
+		if (player != z.player)
+		{
+			return player < z.player ? -1 : 1;
+		}
+		if (subType != z.subType)
+		{
+			return subType < z.subType ? -1 : 1;
+		}
+		switch (subType)
+		{
+		case ObjOrder:
+		case LocOrder:
+			if (order != z.order)
+			{
+				return order < z.order ? -1 : 1;
+			}
+			if (subType == ObjOrder)
+			{
+				if (destId != z.destId)
+				{
+					return destId < z.destId ? -1 : 1;
+				}
+				if (destType != z.destType)
+				{
+					return destType < z.destType ? -1 : 1;
+				}
+			}
+			else
+			{
+				if (pos.x != z.pos.x)
+				{
+					return pos.x < z.pos.x ? -1 : 1;
+				}
+				if (pos.y != z.pos.y)
+				{
+					return pos.y < z.pos.y ? -1 : 1;
+				}
+			}
+			if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
+			{
+				if (structRef != z.structRef)
+				{
+					return structRef < z.structRef ? -1 : 1;
+				}
+				if (direction != z.direction)
+				{
+					return direction < z.direction ? -1 : 1;
+				}
+			}
+			if (order == DORDER_LINEBUILD)
+			{
+				if (pos2.x != z.pos2.x)
+				{
+					return pos2.x < z.pos2.x ? -1 : 1;
+				}
+				if (pos2.y != z.pos2.y)
+				{
+					return pos2.y < z.pos2.y ? -1 : 1;
+				}
+			}
+			if (order == DORDER_BUILDMODULE)
+			{
+				if (index != z.index)
+				{
+					return index < z.index ? -1 : 1;
+				}
+			}
+			if (add != z.add)
+			{
+				return add < z.add ? -1 : 1;
+			}
+			break;
+		case SecondaryOrder:
+			if (secOrder != z.secOrder)
+			{
+				return secOrder < z.secOrder ? -1 : 1;
+			}
+			if (secState != z.secState)
+			{
+				return secState < z.secState ? -1 : 1;
+			}
+			break;
+		}
+		return 0;
+	}
+
+	uint8_t     player = 0;
+	uint32_t    droidId = 0;
+	SubType     subType = ObjOrder;
+	// subType == ObjOrder || subType == LocOrder
+	DROID_ORDER order = DORDER_NONE;
+	uint32_t    destId = 0;     // if (subType == ObjOrder)
+	OBJECT_TYPE destType = OBJ_DROID;   // if (subType == ObjOrder)
+	Vector2i    pos = Vector2i(0, 0);            // if (subType == LocOrder)
+	uint32_t    y = 0;          // if (subType == LocOrder)
+	uint32_t    structRef = 0;  // if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
+	uint16_t    direction = 0;  // if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
+	uint32_t    index = 0;      // if (order == DORDER_BUILDMODULE)
+	Vector2i    pos2 = Vector2i(0, 0);           // if (order == DORDER_LINEBUILD)
+	bool        add = false;
+	// subType == SecondaryOrder
+	SECONDARY_ORDER secOrder = DSO_UNUSED;
+	SECONDARY_STATE secState = DSS_NONE;
+};
+
+/// Droid IDs firstId, firstId + 2, firstId + 4, ..., since synchronised object IDs are all odd.
+struct DroidIdRun
+{
+	uint32_t firstId;
+	uint32_t count;  ///< Number of droids in the run, at least 1.
+};
+
+/// An order, and the droids it is given to.
+struct DroidInfoOrder
+{
+	QueuedDroidInfo info;  ///< The order, info.droidId is not used.
+	std::vector<DroidIdRun> runs;
+};
+
+/** Writes the orders as the contents of a GAME_DROIDINFO message, between NETbeginEncode and NETend.
+ *
+ *  The orders must be sorted. Orders to the same droids are grouped, and refer to the recent orders in templates where
+ *  possible. The templates are updated the same way as by NETdecodeDroidInfo for the same message.
+ */
+void NETencodeDroidInfo(std::vector<QueuedDroidInfo> const &orders, std::vector<QueuedDroidInfo> &templates);
+
+/** Reads the contents of a GAME_DROIDINFO message, between NETbeginDecode and NETend.
+ *
+ *  @return false if the message is not valid, in which case none of the orders should be given, and templates is unchanged.
+ */
+bool NETdecodeDroidInfo(std::vector<DroidInfoOrder> &orders, std::vector<QueuedDroidInfo> &templates);
+
+#endif // __INCLUDED_SRC_DROIDINFO_H__
@@ -99,6 +99,7 @@ void	adjustTileHeight(MAPTILE *psTile, SDWORD adjust)
 	if (newHeight >= MIN_TILE_HEIGHT * ELEVATION_SCALE && newHeight <= MAX_TILE_HEIGHT * ELEVATION_SCALE)
 	{
 		psTile->height = newHeight;
+		++mapHeightVersion;
 	}
 }
 
@@ -32,6 +32,7 @@
 #include "lib/ivis_opengl/ivisdef.h"
 
 #include "feature.h"
+#include "fpath.h"
 #include "map.h"
 #include "hci.h"
 #include "power.h"
@@ -47,6 +48,7 @@
 #include "multiplay.h"
 
 #include "mapgrid.h"
+#include "objectpool.h"
 #include "display3d.h"
 #include "random.h"
 
@@ -190,9 +192,6 @@ FEATURE *buildFeature(FEATURE_STATS *psStats, UDWORD x, UDWORD y, bool FromSave)
 		debug(LOG_WARNING, "Feature couldn't be built.");
 		return nullptr;
 	}
-	//add the feature to the list - this enables it to be drawn whilst being built
-	addFeature(psFeature);
-
 	// snap the coords to a tile
 	if (!FromSave)
 	{
@@ -211,6 +210,9 @@ FEATURE *buildFeature(FEATURE_STATS *psStats, UDWORD x, UDWORD y, bool FromSave)
 	psFeature->pos.x = x;
 	psFeature->pos.y = y;
 
+	//add the feature to the list - this enables it to be drawn whilst being built
+	addFeature(psFeature);
+
 	StructureBounds b = getStructureBounds(psFeature);
 
 	// get the terrain average height
@@ -291,9 +293,11 @@ FEATURE *buildFeature(FEATURE_STATS *psStats, UDWORD x, UDWORD y, bool FromSave)
 			if ((!psStats->tileDraw) && (FromSave == false))
 			{
 				psTile->height = height;
+				++mapHeightVersion;
 			}
 		}
 	}
+	fpathMarkBlockingChanged(b);
 	psFeature->pos.z = map_TileHeight(b.map.x, b.map.y);//jps 18july97
 
 	return psFeature;
@@ -312,6 +316,18 @@ FEATURE::~FEATURE()
 	audio_RemoveObj(this);
 }
 
+static ObjectPool featurePool("features", sizeof(FEATURE));
+
+void *FEATURE::operator new(size_t size)
+{
+	return featurePool.allocate(size);
+}
+
+void FEATURE::operator delete(void *ptr)
+{
+	featurePool.release(ptr);
+}
+
 void _syncDebugFeature(const char *function, FEATURE const *psFeature, char ch)
 {
 	if (psFeature->type != OBJ_FEATURE) {
@@ -378,6 +394,7 @@ bool removeFeature(FEATURE *psDel)
 			}
 		}
 	}
+	fpathMarkBlockingChanged(b);
 
 	if (psDel->psStats->subType == FEAT_GEN_ARTE || psDel->psStats->subType == FEAT_OIL_DRUM)
 	{
@@ -25,10 +25,14 @@
  */
 
 #include <future>
+#include <map>
+#include <thread>
+#include <tuple>
 #include <unordered_map>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/crc.h"
+#include "lib/framework/math_ext.h"
 #include "lib/netplay/netplay.h"
 
 #include "lib/framework/wzapp.h"
@@ -37,6 +41,8 @@
 #include "map.h"
 #include "multiplay.h"
 #include "astar.h"
+#include "benchmark.h"
+#include "warzoneconfig.h"
 
 #include "fpath.h"
 
@@ -56,52 +62,110 @@ struct PATHRESULT
 
 
 // threading stuff
-static WZ_THREAD        *fpathThread = nullptr;
+static std::vector<WZ_THREAD *> fpathThreads;
 static WZ_MUTEX         *fpathMutex = nullptr;
 static WZ_SEMAPHORE     *fpathSemaphore = nullptr;
 using packagedPathJob = wz::packaged_task<PATHRESULT()>;
-static std::list<packagedPathJob>    pathJobs;
+
+struct PathLaneJob
+{
+	uint64_t        seq;    ///< Order in which the job was queued.
+	packagedPathJob task;
+};
+
+/// Jobs waiting for a path thread. Each lane is processed by at most one thread at a time, in order.
+struct PathLaneQueue
+{
+	std::list<PathLaneJob> jobs;
+	bool            busy = false;  ///< A path thread is currently processing a job from this lane.
+};
+
+static PathLaneQueue    pathLanes[FPATH_LANES];
+static uint64_t         pathJobSeq = 0;
+static unsigned         fpathSleepingThreads = 0;  ///< Number of path threads waiting on fpathSemaphore.
 static std::unordered_map<uint32_t, wz::future<PATHRESULT>> pathResults;
 
-static bool             waitingForResult = false;
-static uint32_t         waitingForResultId;
-static WZ_SEMAPHORE     *waitingForResultSemaphore = nullptr;
+static PATHRESULT fpathExecute(PATHJOB psJob, unsigned lane);
+
+/// Number of droids which must be going to the same tile in the same tick, before the rest of them share a flow field.
+#define FPATH_GROUP_MOVE_MIN 4
+
+/// Number of path jobs to each destination tile in the current tick, by blocking map.
+static std::map<std::tuple<PathBlockingMap const *, int, int>, unsigned> fpathDestinationCounts;
+static uint32_t         fpathDestinationCountTime = 0;
 
-static PATHRESULT fpathExecute(PATHJOB psJob);
+/// Returns the idle lane with the oldest queued job, or FPATH_LANES if no lane has jobs to process. Call with fpathMutex locked.
+static unsigned fpathTakeLane()
+{
+	unsigned best = FPATH_LANES;
+	for (unsigned lane = 0; lane < FPATH_LANES; ++lane)
+	{
+		PathLaneQueue const &queue = pathLanes[lane];
+		if (!queue.busy && !queue.jobs.empty() && (best == FPATH_LANES || queue.jobs.front().seq < pathLanes[best].jobs.front().seq))
+		{
+			best = lane;
+		}
+	}
+	return best;
+}
 
+/// Wakes up a sleeping path thread, if any. Call with fpathMutex locked.
+static void fpathWakeThread()
+{
+	if (fpathSleepingThreads > 0)
+	{
+		--fpathSleepingThreads;
+		wzSemaphorePost(fpathSemaphore);
+	}
+}
 
-/** This runs in a separate thread */
+/** This runs in a separate thread, one per path thread. Any idle thread takes the idle lane with the oldest job. */
 static int fpathThreadFunc(void *)
 {
 	wzMutexLock(fpathMutex);
 
 	while (!fpathQuit)
 	{
-		if (pathJobs.empty())
+		unsigned lane = fpathTakeLane();
+		if (lane == FPATH_LANES)
 		{
-			ASSERT(!waitingForResult, "Waiting for a result (id %u) that doesn't exist.", waitingForResultId);
+			++fpathSleepingThreads;
 			wzMutexUnlock(fpathMutex);
 			wzSemaphoreWait(fpathSemaphore);  // Go to sleep until needed.
 			wzMutexLock(fpathMutex);
 			continue;
 		}
 
-		// Copy the first job from the queue.
-		packagedPathJob job = std::move(pathJobs.front());
-		pathJobs.pop_front();
+		// Copy the first job from the lane.
+		PathLaneQueue &queue = pathLanes[lane];
+		packagedPathJob job = std::move(queue.jobs.front().task);
+		queue.jobs.pop_front();
+		queue.busy = true;
 
 		wzMutexUnlock(fpathMutex);
 		job();
 		wzMutexLock(fpathMutex);
 
-		waitingForResult = false;
-		objTrace(waitingForResultId, "These are the droids you are looking for.");
-		wzSemaphorePost(waitingForResultSemaphore);
+		queue.busy = false;
+		if (!queue.jobs.empty())
+		{
+			fpathWakeThread();  // We might take a different lane next, so let someone else continue this one.
+		}
 	}
 	wzMutexUnlock(fpathMutex);
 	return 0;
 }
 
+/// Returns the number of path threads to start, if not set in the config file.
+static unsigned fpathDefaultThreadCount()
+{
+#if !defined(WZ_CC_MINGW)
+	unsigned cores = std::thread::hardware_concurrency();  // Returns 0, if unknown.
+	return clip(cores / 2, 1, FPATH_LANES);
+#else
+	return 2;
+#endif
+}
 
 // initialise the findpath module
 bool fpathInitialise()
@@ -109,13 +173,20 @@ bool fpathInitialise()
 	// The path system is up
 	fpathQuit = false;
 
-	if (!fpathThread)
+	if (fpathThreads.empty())
 	{
+		unsigned numThreads = war_GetPathThreads() > 0 ? war_GetPathThreads() : fpathDefaultThreadCount();
+		numThreads = clip(numThreads, 1, FPATH_LANES);  // More threads than lanes would never have anything to do.
+		debug(LOG_INFO, "Using %u path-finding threads", numThreads);
+
 		fpathMutex = wzMutexCreate();
 		fpathSemaphore = wzSemaphoreCreate(0);
-		waitingForResultSemaphore = wzSemaphoreCreate(0);
-		fpathThread = wzThreadCreate(fpathThreadFunc, nullptr);
-		wzThreadStart(fpathThread);
+		fpathSleepingThreads = 0;
+		for (unsigned i = 0; i < numThreads; ++i)
+		{
+			fpathThreads.push_back(wzThreadCreate(fpathThreadFunc, nullptr));
+			wzThreadStart(fpathThreads.back());
+		}
 	}
 
 	return true;
@@ -124,25 +195,41 @@ bool fpathInitialise()
 
 void fpathShutdown()
 {
-	if (fpathThread)
+	if (!fpathThreads.empty())
 	{
-		// Signal the path finding thread to quit
+		// Signal the path finding threads to quit
 		fpathQuit = true;
-		wzSemaphorePost(fpathSemaphore);  // Wake up thread.
+		for (size_t i = 0; i < fpathThreads.size(); ++i)
+		{
+			wzSemaphorePost(fpathSemaphore);  // Wake up threads.
+		}
 
-		wzThreadJoin(fpathThread);
-		fpathThread = nullptr;
+		for (WZ_THREAD *thread : fpathThreads)
+		{
+			wzThreadJoin(thread);
+		}
+		fpathThreads.clear();
 		wzMutexDestroy(fpathMutex);
 		fpathMutex = nullptr;
 		wzSemaphoreDestroy(fpathSemaphore);
 		fpathSemaphore = nullptr;
-		wzSemaphoreDestroy(waitingForResultSemaphore);
-		waitingForResultSemaphore = nullptr;
 	}
 	fpathHardTableReset();
 }
 
 
+/// Returns the number of path jobs queued so far this tick to the same tile as job, with the same blocking map. Call from main thread, after fpathSetBlockingMap.
+static unsigned fpathCountDestination(PATHJOB const &job)
+{
+	if (fpathDestinationCountTime != gameTime)
+	{
+		fpathDestinationCountTime = gameTime;
+		fpathDestinationCounts.clear();
+	}
+	return ++fpathDestinationCounts[std::make_tuple(job.blockingMap.get(), map_coord(job.destX), map_coord(job.destY))];
+}
+
+
 /**
  *	Updates the pathfinding system.
  *	@ingroup pathfinding
@@ -340,7 +427,11 @@ static FPATH_RETVAL fpathRoute(MOVE_CONTROL *psMove, unsigned id, int startX, in
 
 		auto const &I = pathResults.find(id);
 		ASSERT(I != pathResults.end(), "Missing path result promise");
-		PATHRESULT result = I->second.get();
+		PATHRESULT result;
+		{
+			BenchmarkTimer timer(BENCHMARK_PATHFINDING_WAIT);
+			result = I->second.get();
+		}
 		ASSERT(result.retval != FPR_OK || result.sMove.asPath.size() > 0, "Ok result but no path in list");
 
 		// Copy over select fields - preserve others
@@ -382,27 +473,29 @@ queuePathfinding:
 	job.acceptNearest = acceptNearest;
 	job.deleted = false;
 	fpathSetBlockingMap(&job);
+	job.groupMove = fpathCountDestination(job) >= FPATH_GROUP_MOVE_MIN;
 
 	debug(LOG_NEVER, "starting new job for droid %d 0x%x", id, id);
 	// Clear any results or jobs waiting already. It is a vital assumption that there is only one
 	// job or result for each droid in the system at any time.
 	fpathRemoveDroidData(id);
 
-	packagedPathJob task([job]() { return fpathExecute(job); });
+	unsigned lane = fpathJobLane(&job);
+	packagedPathJob task([job, lane]() { return fpathExecute(job, lane); });
 	pathResults[id] = task.get_future();
 
-	// Add to end of list
+	// Add to end of the lane
 	wzMutexLock(fpathMutex);
-	bool isFirstJob = pathJobs.empty();
-	pathJobs.push_back(std::move(task));
-	wzMutexUnlock(fpathMutex);
-
-	if (isFirstJob)
+	PathLaneQueue &queue = pathLanes[lane];
+	bool isFirstJob = queue.jobs.empty();
+	queue.jobs.push_back(PathLaneJob{pathJobSeq++, std::move(task)});
+	if (!queue.busy)
 	{
-		wzSemaphorePost(fpathSemaphore);  // Wake up processing thread.
+		fpathWakeThread();  // Wake up a processing thread.
 	}
+	wzMutexUnlock(fpathMutex);
 
-	objTrace(id, "Queued up a path-finding request to (%d, %d), at least %d items earlier in queue", tX, tY, isFirstJob);
+	objTrace(id, "Queued up a path-finding request to (%d, %d) in lane %u, at least %d items earlier in lane", tX, tY, lane, !isFirstJob);
 	syncDebug("fpathRoute(..., %d, %d, %d, %d, %d, %d, %d, %d, %d) = FPR_WAIT", id, startX, startY, tX, tY, propulsionType, droidType, moveType, owner);
 	return FPR_WAIT;	// wait while polling result queue
 }
@@ -452,15 +545,15 @@ FPATH_RETVAL fpathDroidRoute(DROID *psDroid, SDWORD tX, SDWORD tY, FPATH_MOVETYP
 	                  psDroid->droidType, moveType, psDroid->player, acceptNearest, dstStructure);
 }
 
-// Run only from path thread
-PATHRESULT fpathExecute(PATHJOB job)
+// Run only from path thread, which must own the lane
+PATHRESULT fpathExecute(PATHJOB job, unsigned lane)
 {
 	PATHRESULT result;
 	result.droidID = job.droidID;
 	result.retval = FPR_FAILED;
 	result.originalDest = Vector2i(job.destX, job.destY);
 
-	ASR_RETVAL retval = fpathAStarRoute(&result.sMove, &job);
+	ASR_RETVAL retval = fpathAStarRoute(&result.sMove, &job, lane);
 
 	ASSERT(retval != ASR_OK || result.sMove.asPath.size() > 0, "Ok result but no path in result");
 	switch (retval)
@@ -499,13 +592,16 @@ PATHRESULT fpathExecute(PATHJOB job)
 	return result;
 }
 
-/** Find the length of the job queue. Function is thread-safe. */
+/** Find the total number of jobs waiting in the queues of all FPATH_LANES path lanes. Function is thread-safe. */
 static int fpathJobQueueLength()
 {
 	int count = 0;
 
 	wzMutexLock(fpathMutex);
-	count = pathJobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	for (auto const &lane : pathLanes)
+	{
+		count += lane.jobs.size();  // O(N) function call for std::list. .empty() is faster, but this function isn't used except in tests.
+	}
 	wzMutexUnlock(fpathMutex);
 	return count;
 }
@@ -539,10 +635,10 @@ void fpathTest(int x, int y, int x2, int y2)
 	(void)fpathJobQueueLength();
 
 	/* Check initial state */
-	assert(fpathThread != nullptr);
+	assert(!fpathThreads.empty());
 	assert(fpathMutex != nullptr);
 	assert(fpathSemaphore != nullptr);
-	assert(pathJobs.empty());
+	assert(fpathJobQueueLength() == 0);
 	assert(pathResults.empty());
 	fpathRemoveDroidData(0);	// should not crash
 
@@ -56,6 +56,7 @@ struct PATHJOB
 	int		owner;		///< Player owner
 	std::shared_ptr<PathBlockingMap> blockingMap;   ///< Map of blocking tiles.
 	bool		acceptNearest;
+	bool            groupMove;      ///< Several droids are going to the same destination this tick, so share a flow field instead of searching separately.
 	bool            deleted;        ///< Droid was deleted, so throw away result when complete. Must still process this PATHJOB, since processing order can affect resulting paths (but can't affect the path length).
 };
 
@@ -105,6 +106,11 @@ static inline bool fpathBlockingTile(Vector2i tile, PROPULSION_TYPE propulsion)
 	return fpathBlockingTile(tile.x, tile.y, propulsion);
 }
 
+/** Marks the tiles in area as possibly having changed whether they block droids, so that the cached
+ *  blocking maps get updated before the next path job. Call from main thread.
+ */
+void fpathMarkBlockingChanged(StructureBounds const &area);
+
 /** Set a direct path to position.
  *
  *  Plan a path from @c psDroid's current position to given position without
@@ -4242,7 +4242,7 @@ bool loadSaveDroidInit(char *pFileData, UDWORD filesize)
 			{
 				Vector2i startpos = getPlayerStartPosition(psDroid->player);
 
-				psDroid->id = pDroidInit->id > 0 ? pDroidInit->id : 0xFEDBCA98;	// hack to remove droid id zero
+				objSetId(psDroid, pDroidInit->id > 0 ? pDroidInit->id : 0xFEDBCA98);	// hack to remove droid id zero
 				psDroid->rot.direction = DEG(pDroidInit->direction);
 				addDroid(psDroid, apsDroidLists);
 				if (psDroid->droidType == DROID_CONSTRUCT && startpos.x == 0 && startpos.y == 0)
@@ -4618,7 +4618,7 @@ static bool loadSaveDroid(const char *pFileName, DROID **ppsCurrentDroidLists)
 		// Copy the values across
 		if (id > 0)
 		{
-			psDroid->id = id; // force correct ID, unless ID is set to eg -1, in which case we should keep new ID (useful for starting units in campaign)
+			objSetId(psDroid, id); // force correct ID, unless ID is set to eg -1, in which case we should keep new ID (useful for starting units in campaign)
 		}
 		ASSERT(id != 0, "Droid ID should never be zero here");
 		psDroid->body = healthValue(ini, psDroid->originalBody);
@@ -5020,7 +5020,7 @@ bool loadSaveStructure(char *pFileData, UDWORD filesize)
 		}
 		// The original code here didn't work and so the scriptwriters worked round it by using the module ID - so making it work now will screw up
 		// the scripts -so in ALL CASES overwrite the ID!
-		psStructure->id = psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98; // hack to remove struct id zero
+		objSetId(psStructure, psSaveStructure->id > 0 ? psSaveStructure->id : 0xFEDBCA98); // hack to remove struct id zero
 		psStructure->periodicalDamage = psSaveStructure->periodicalDamage;
 		periodicalDamageTime = psSaveStructure->periodicalDamageStart;
 		psStructure->periodicalDamageStart = periodicalDamageTime;
@@ -5142,7 +5142,7 @@ static bool loadSaveStructure2(const char *pFileName, STRUCTURE **ppList)
 		}
 		if (id > 0)
 		{
-			psStructure->id = id;	// force correct ID
+			objSetId(psStructure, id);	// force correct ID
 		}
 
 		// common BASE_OBJECT info
@@ -5682,7 +5682,7 @@ bool loadSaveFeature(char *pFileData, UDWORD filesize)
 			scriptSetDerrickPos(pFeature->pos.x, pFeature->pos.y);
 		}
 		//restore values
-		pFeature->id = psSaveFeature->id;
+		objSetId(pFeature, psSaveFeature->id);
 		pFeature->rot.direction = DEG(psSaveFeature->direction);
 		pFeature->periodicalDamage = psSaveFeature->periodicalDamage;
 		if (psHeader->version >= VERSION_14)
@@ -5751,11 +5751,11 @@ bool loadSaveFeature2(const char *pFileName)
 		int id = ini.value("id", -1).toInt();
 		if (id > 0)
 		{
-			pFeature->id = id;
+			objSetId(pFeature, id);
 		}
 		else
 		{
-			pFeature->id = generateSynchronisedObjectId();
+			objSetId(pFeature, generateSynchronisedObjectId());
 		}
 		pFeature->rot = ini.vector3i("rotation");
 
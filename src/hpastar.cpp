@@ -0,0 +1,414 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Hierarchical path finding (HPA*), see "Near Optimal Hierarchical Path-Finding" by Botea, Müller and Schaeffer.
+ *  How this works:
+ *  * The map is split into clusters of PATH_CLUSTER_SIZE² tiles. Where a run of passable tiles crosses the border between
+ *    two clusters, portal nodes are placed on both sides of the border, and linked to each other.
+ *  * Within each cluster, the distances between all pairs of portal nodes are found by searching the tiles of that cluster.
+ *  * A long route is planned by searching the (much smaller) graph of portal nodes, and the tile A* is then restricted to
+ *    the corridor of clusters that the abstract route passes through.
+ *  Graphs are immutable once built, and are rebuilt from the main thread, so all clients see the same graph for a given
+ *  path job. When rebuilding, clusters whose tiles and portals didn't change are copied from the previous graph.
+ */
+
+#include "lib/framework/frame.h"
+
+#include "hpastar.h"
+
+#include <algorithm>
+#include <climits>
+#include <queue>
+
+struct PathCluster
+{
+	std::vector<Vector2i> nodes;  ///< Portal tiles in this cluster, sorted by y, then x.
+	std::vector<unsigned> dist;   ///< nodes.size()² matrix of distances between the portal tiles, moving within this cluster only.
+	unsigned firstNode = 0;       ///< Graph node index of nodes[0].
+};
+
+struct PathClusterGraph
+{
+	int width = 0, height = 0;                  ///< Map size, in tiles.
+	int clustersX = 0, clustersY = 0;           ///< Number of clusters in each direction.
+	PathBitMap blocking;                        ///< The blocking map that this graph was built from.
+	std::vector<PathCluster> clusters;
+	std::vector<unsigned> nodeCluster;          ///< Cluster index of each node.
+	std::vector<Vector2i> nodeTile;             ///< Tile of each node.
+	std::vector<std::vector<unsigned>> links;   ///< Nodes in neighbouring clusters which are one straight step from each node.
+};
+
+#define PATH_COST_STRAIGHT 140
+#define PATH_COST_DIAGONAL 198
+
+static const Vector2i clusterDirOffset[] =
+{
+	Vector2i(0, 1), Vector2i(-1, 1), Vector2i(-1, 0), Vector2i(-1, -1), Vector2i(0, -1), Vector2i(1, -1), Vector2i(1, 0), Vector2i(1, 1),
+};
+
+static inline bool isTileBlocked(PathClusterGraph const &graph, int x, int y)
+{
+	return x < 0 || y < 0 || x >= graph.width || y >= graph.height || graph.blocking.get(x, y);
+}
+
+/// Same as fpathEstimate in astar.cpp, never overestimates the distance.
+static inline unsigned clusterEstimate(Vector2i s, Vector2i f)
+{
+	unsigned xDelta = abs(s.x - f.x), yDelta = abs(s.y - f.y);
+	return std::min(xDelta, yDelta) * (PATH_COST_DIAGONAL - PATH_COST_STRAIGHT) + std::max(xDelta, yDelta) * PATH_COST_STRAIGHT;
+}
+
+/// Finds the distance from source to each tile of the cluster, moving within the cluster only, and using the same rules for cutting corners as the tile A*.
+/// dist is indexed by tile position relative to the top left corner of the cluster.
+static void clusterDistances(PathClusterGraph const &graph, int cluster, Vector2i source, std::vector<unsigned> &dist)
+{
+	int x0 = cluster % graph.clustersX * PATH_CLUSTER_SIZE;
+	int y0 = cluster / graph.clustersX * PATH_CLUSTER_SIZE;
+	int x1 = std::min(x0 + PATH_CLUSTER_SIZE, graph.width);
+	int y1 = std::min(y0 + PATH_CLUSTER_SIZE, graph.height);
+	auto isPassable = [&](int x, int y) {
+		return x >= x0 && y >= y0 && x < x1 && y < y1 && !graph.blocking.get(x, y);
+	};
+
+	dist.assign(PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE, UINT_MAX);
+	if (!isPassable(source.x, source.y))
+	{
+		return;
+	}
+
+	typedef std::pair<unsigned, int> Entry;  // Distance, local tile index.
+	std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> open;
+	int sourceIndex = source.x - x0 + (source.y - y0) * PATH_CLUSTER_SIZE;
+	dist[sourceIndex] = 0;
+	open.push(Entry(0, sourceIndex));
+	while (!open.empty())
+	{
+		Entry entry = open.top();
+		open.pop();
+		if (entry.first != dist[entry.second])
+		{
+			continue;  // Already found a shorter way here.
+		}
+		int x = x0 + entry.second % PATH_CLUSTER_SIZE;
+		int y = y0 + entry.second / PATH_CLUSTER_SIZE;
+		for (unsigned dir = 0; dir < ARRAY_SIZE(clusterDirOffset); ++dir)
+		{
+			int nx = x + clusterDirOffset[dir].x;
+			int ny = y + clusterDirOffset[dir].y;
+			if (!isPassable(nx, ny))
+			{
+				continue;
+			}
+			bool isDiagonal = dir % 2 != 0;
+			if (isDiagonal && (!isPassable(x + clusterDirOffset[(dir + 1) % 8].x, y + clusterDirOffset[(dir + 1) % 8].y) ||
+			                   !isPassable(x + clusterDirOffset[(dir + 7) % 8].x, y + clusterDirOffset[(dir + 7) % 8].y)))
+			{
+				continue;  // We cannot cut corners.
+			}
+			unsigned newDist = entry.first + (isDiagonal ? PATH_COST_DIAGONAL : PATH_COST_STRAIGHT);
+			int index = nx - x0 + (ny - y0) * PATH_CLUSTER_SIZE;
+			if (newDist < dist[index])
+			{
+				dist[index] = newDist;
+				open.push(Entry(newDist, index));
+			}
+		}
+	}
+}
+
+/// Adds portals for a run of tiles which are passable on both sides of a cluster border. Long runs get a portal at each end, short runs only one in the middle.
+static void addPortals(std::vector<std::pair<Vector2i, Vector2i>> &portals, Vector2i runStart, int runLength, Vector2i along, Vector2i across)
+{
+	if (runLength >= 6)
+	{
+		portals.emplace_back(runStart, runStart + across);
+		Vector2i runEnd = runStart + along * (runLength - 1);
+		portals.emplace_back(runEnd, runEnd + across);
+	}
+	else
+	{
+		Vector2i runMiddle = runStart + along * ((runLength - 1) / 2);
+		portals.emplace_back(runMiddle, runMiddle + across);
+	}
+}
+
+/// Finds all runs of passable tile pairs along a border, starting from the tile pair (start, start + across).
+static void findBorderPortals(PathClusterGraph const &graph, std::vector<std::pair<Vector2i, Vector2i>> &portals, Vector2i start, int length, Vector2i along, Vector2i across)
+{
+	int runLength = 0;
+	Vector2i runStart = start;
+	for (int i = 0; i <= length; ++i)
+	{
+		Vector2i a = start + along * i;
+		Vector2i b = a + across;
+		if (i < length && !isTileBlocked(graph, a.x, a.y) && !isTileBlocked(graph, b.x, b.y))
+		{
+			if (runLength == 0)
+			{
+				runStart = a;
+			}
+			++runLength;
+		}
+		else if (runLength > 0)
+		{
+			addPortals(portals, runStart, runLength, along, across);
+			runLength = 0;
+		}
+	}
+}
+
+static bool lessTile(Vector2i const &a, Vector2i const &b)
+{
+	return a.y < b.y || (a.y == b.y && a.x < b.x);
+}
+
+static unsigned clusterNodeIndex(PathClusterGraph const &graph, int cluster, Vector2i tile)
+{
+	PathCluster const &c = graph.clusters[cluster];
+	return c.firstNode + (std::lower_bound(c.nodes.begin(), c.nodes.end(), tile, lessTile) - c.nodes.begin());
+}
+
+std::shared_ptr<PathClusterGraph const> fpathUpdateClusterGraph(std::shared_ptr<PathClusterGraph const> const &oldGraph, PathBitMap const &blockingMap, int width, int height)
+{
+	std::shared_ptr<PathClusterGraph> graph = std::make_shared<PathClusterGraph>();
+	graph->width = width;
+	graph->height = height;
+	graph->clustersX = (width + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+	graph->clustersY = (height + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE;
+	graph->blocking = blockingMap;
+	graph->clusters.resize(graph->clustersX * graph->clustersY);
+
+	// Find out which clusters contain changed tiles.
+	bool canReuse = oldGraph != nullptr && oldGraph->width == width && oldGraph->height == height;
+	std::vector<bool> changed(graph->clusters.size(), !canReuse);
+	if (canReuse)
+	{
+		// Compare 64 tiles at a time, only looking at the individual tiles of words which differ.
+		for (int y = 0; y < height; ++y)
+			for (int w = 0; w < blockingMap.wordsPerRow; ++w)
+			{
+				int i = w + y * blockingMap.wordsPerRow;
+				uint64_t diff = blockingMap.words[i] ^ oldGraph->blocking.words[i];
+				for (int bit = 0; diff != 0; ++bit, diff >>= 1)
+				{
+					if ((diff & 1) != 0)
+					{
+						changed[fpathClusterIndex(w * 64 + bit, y, width)] = true;
+					}
+				}
+			}
+	}
+
+	if (std::find(changed.begin(), changed.end(), true) == changed.end())
+	{
+		return oldGraph;  // Nothing changed at all.
+	}
+
+	// Find the portals along all cluster borders. This is cheap, so always done for all borders.
+	std::vector<std::pair<Vector2i, Vector2i>> portals;
+	for (int cy = 0; cy < graph->clustersY; ++cy)
+		for (int cx = 0; cx < graph->clustersX; ++cx)
+		{
+			int x0 = cx * PATH_CLUSTER_SIZE, y0 = cy * PATH_CLUSTER_SIZE;
+			int w = std::min(PATH_CLUSTER_SIZE, width - x0), h = std::min(PATH_CLUSTER_SIZE, height - y0);
+			if (cx + 1 < graph->clustersX)
+			{
+				findBorderPortals(*graph, portals, Vector2i(x0 + w - 1, y0), h, Vector2i(0, 1), Vector2i(1, 0));  // Right border.
+			}
+			if (cy + 1 < graph->clustersY)
+			{
+				findBorderPortals(*graph, portals, Vector2i(x0, y0 + h - 1), w, Vector2i(1, 0), Vector2i(0, 1));  // Bottom border.
+			}
+		}
+
+	for (auto const &portal : portals)
+	{
+		graph->clusters[fpathClusterIndex(portal.first.x, portal.first.y, width)].nodes.push_back(portal.first);
+		graph->clusters[fpathClusterIndex(portal.second.x, portal.second.y, width)].nodes.push_back(portal.second);
+	}
+
+	// Find the distances between portals within each cluster.
+	unsigned numNodes = 0;
+	std::vector<unsigned> dist;
+	for (unsigned cluster = 0; cluster < graph->clusters.size(); ++cluster)
+	{
+		PathCluster &c = graph->clusters[cluster];
+		std::sort(c.nodes.begin(), c.nodes.end(), lessTile);
+		c.nodes.erase(std::unique(c.nodes.begin(), c.nodes.end()), c.nodes.end());
+		c.firstNode = numNodes;
+		numNodes += c.nodes.size();
+		graph->nodeCluster.resize(numNodes, cluster);
+		graph->nodeTile.insert(graph->nodeTile.end(), c.nodes.begin(), c.nodes.end());
+
+		if (!changed[cluster] && oldGraph->clusters[cluster].nodes == c.nodes)
+		{
+			c.dist = oldGraph->clusters[cluster].dist;  // Nothing changed here.
+			continue;
+		}
+
+		int x0 = cluster % graph->clustersX * PATH_CLUSTER_SIZE;
+		int y0 = cluster / graph->clustersX * PATH_CLUSTER_SIZE;
+		unsigned n = c.nodes.size();
+		c.dist.resize(n * n);
+		for (unsigned i = 0; i < n; ++i)
+		{
+			clusterDistances(*graph, cluster, c.nodes[i], dist);
+			for (unsigned j = 0; j < n; ++j)
+			{
+				c.dist[i * n + j] = dist[c.nodes[j].x - x0 + (c.nodes[j].y - y0) * PATH_CLUSTER_SIZE];
+			}
+		}
+	}
+
+	// Link the nodes on each side of each portal.
+	graph->links.resize(numNodes);
+	for (auto const &portal : portals)
+	{
+		unsigned a = clusterNodeIndex(*graph, fpathClusterIndex(portal.first.x, portal.first.y, width), portal.first);
+		unsigned b = clusterNodeIndex(*graph, fpathClusterIndex(portal.second.x, portal.second.y, width), portal.second);
+		graph->links[a].push_back(b);
+		graph->links[b].push_back(a);
+	}
+
+	return graph;
+}
+
+struct ClusterNode
+{
+	bool operator <(ClusterNode const &z) const
+	{
+		// Same ordering as PathNode in astar.cpp, so the priority queue takes the lowest estimate first.
+		if (est != z.est)
+		{
+			return est > z.est;
+		}
+		if (dist != z.dist)
+		{
+			return dist < z.dist;
+		}
+		return node > z.node;
+	}
+
+	unsigned node;
+	unsigned dist, est;
+};
+
+bool fpathClusterCorridor(PathClusterGraph const &graph, Vector2i tileS, Vector2i tileF, std::vector<bool> &corridor)
+{
+	if (isTileBlocked(graph, tileS.x, tileS.y) || isTileBlocked(graph, tileF.x, tileF.y))
+	{
+		return false;  // Let the tile A* deal with starting or ending on a blocking tile.
+	}
+	int clusterS = fpathClusterIndex(tileS.x, tileS.y, graph.width);
+	int clusterF = fpathClusterIndex(tileF.x, tileF.y, graph.width);
+	if (clusterS == clusterF)
+	{
+		return false;
+	}
+
+	// The destination is a virtual node, linked to the reachable portals of its cluster.
+	unsigned numNodes = graph.links.size();
+	unsigned goal = numNodes;
+	std::vector<unsigned> startDist, goalDist;
+	clusterDistances(graph, clusterS, tileS, startDist);
+	clusterDistances(graph, clusterF, tileF, goalDist);
+
+	std::vector<unsigned> bestDist(numNodes + 1, UINT_MAX);
+	std::vector<unsigned> prevNode(numNodes + 1, UINT_MAX);
+	std::vector<bool> visited(numNodes + 1, false);
+	std::priority_queue<ClusterNode> open;
+
+	auto localIndex = [](Vector2i tile) {
+		return tile.x % PATH_CLUSTER_SIZE + tile.y % PATH_CLUSTER_SIZE * PATH_CLUSTER_SIZE;
+	};
+	auto reach = [&](unsigned node, unsigned dist, unsigned prev) {
+		if (dist < bestDist[node])
+		{
+			bestDist[node] = dist;
+			prevNode[node] = prev;
+			unsigned est = dist + (node == goal ? 0 : clusterEstimate(graph.nodeTile[node], tileF));
+			open.push(ClusterNode{node, dist, est});
+		}
+	};
+
+	PathCluster const &cS = graph.clusters[clusterS];
+	for (unsigned i = 0; i < cS.nodes.size(); ++i)
+	{
+		unsigned dist = startDist[localIndex(cS.nodes[i])];
+		if (dist != UINT_MAX)
+		{
+			reach(cS.firstNode + i, dist, UINT_MAX);
+		}
+	}
+
+	bool foundIt = false;
+	while (!open.empty())
+	{
+		ClusterNode current = open.top();
+		open.pop();
+		if (visited[current.node])
+		{
+			continue;  // Already been here.
+		}
+		visited[current.node] = true;
+		if (current.node == goal)
+		{
+			foundIt = true;
+			break;
+		}
+
+		int cluster = graph.nodeCluster[current.node];
+		PathCluster const &c = graph.clusters[cluster];
+		unsigned n = c.nodes.size();
+		unsigned i = current.node - c.firstNode;
+		for (unsigned j = 0; j < n; ++j)
+		{
+			if (j != i && c.dist[i * n + j] != UINT_MAX)
+			{
+				reach(c.firstNode + j, current.dist + c.dist[i * n + j], current.node);
+			}
+		}
+		for (unsigned next : graph.links[current.node])
+		{
+			reach(next, current.dist + PATH_COST_STRAIGHT, current.node);
+		}
+		if (cluster == clusterF)
+		{
+			unsigned dist = goalDist[localIndex(c.nodes[i])];
+			if (dist != UINT_MAX)
+			{
+				reach(goal, current.dist + dist, current.node);
+			}
+		}
+	}
+
+	if (!foundIt)
+	{
+		return false;  // The destination may still be reachable using diagonal steps between clusters, or not at all. Either way, the tile A* will find out.
+	}
+
+	corridor.assign(graph.clusters.size(), false);
+	corridor[clusterS] = true;
+	corridor[clusterF] = true;
+	for (unsigned node = prevNode[goal]; node != UINT_MAX; node = prevNode[node])
+	{
+		corridor[graph.nodeCluster[node]] = true;
+	}
+	return true;
+}
@@ -0,0 +1,76 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Hierarchical path finding (HPA*) abstraction over the tile blocking maps.
+ */
+
+#ifndef __INCLUDED_SRC_HPASTAR_H__
+#define __INCLUDED_SRC_HPASTAR_H__
+
+#include "lib/framework/vector.h"
+#include "astar.h"
+
+#include <memory>
+#include <vector>
+
+/** Width and height of a cluster, in tiles.
+ *
+ *  @ingroup pathfinding
+ */
+#define PATH_CLUSTER_SIZE 16
+
+/** Routes shorter than this (in A* distance units, 140 per tile) are searched directly on the tiles.
+ *
+ *  @ingroup pathfinding
+ */
+#define PATH_CLUSTER_MIN_ROUTE (4 * PATH_CLUSTER_SIZE * 140)
+
+/** Graph of portals between clusters of tiles, and of the distances between the portals within each cluster.
+ *
+ *  A graph is never modified once built, so that path threads can use it while the main thread builds the next one.
+ *
+ *  @ingroup pathfinding
+ */
+struct PathClusterGraph;
+
+/// Returns the index of the cluster containing the given tile.
+static inline int fpathClusterIndex(int x, int y, int mapWidth)
+{
+	return x / PATH_CLUSTER_SIZE + y / PATH_CLUSTER_SIZE * ((mapWidth + PATH_CLUSTER_SIZE - 1) / PATH_CLUSTER_SIZE);
+}
+
+/** Builds the cluster graph for the given blocking map.
+ *
+ *  Clusters whose tiles did not change since oldGraph was built (and whose portals did not move) are copied from oldGraph
+ *  instead of being recalculated, so rebuilding after a structure was built or destroyed is cheap. Call from main thread.
+ *
+ *  @ingroup pathfinding
+ */
+std::shared_ptr<PathClusterGraph const> fpathUpdateClusterGraph(std::shared_ptr<PathClusterGraph const> const &oldGraph, PathBitMap const &blockingMap, int width, int height);
+
+/** Plans a route from tileS to tileF on the cluster graph, and marks the clusters the route passes through in corridor.
+ *
+ *  @return false if there is no route on the cluster graph, in which case the tile search should not be restricted to a corridor.
+ *  Thread-safe.
+ *
+ *  @ingroup pathfinding
+ */
+bool fpathClusterCorridor(PathClusterGraph const &graph, Vector2i tileS, Vector2i tileF, std::vector<bool> &corridor);
+
+#endif // __INCLUDED_SRC_HPASTAR_H__
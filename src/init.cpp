@@ -75,6 +75,7 @@
 #include "multiint.h"
 #include "multigifts.h"
 #include "multiplay.h"
+#include "parallel.h"
 #include "projectile.h"
 #include "order.h"
 #include "radar.h"
@@ -764,6 +765,7 @@ void systemShutdown()
 	levShutDown();
 	widgShutDown();
 	fpathShutdown();
+	parallelShutdown();
 	mapShutdown();
 	debug(LOG_MAIN, "shutting down everything else");
 	pal_ShutDown();		// currently unused stub
@@ -1105,6 +1107,7 @@ bool stageTwoInitialise()
 	// Don't ask why this doesn't go in stage three. In fact, don't even ask me what stage one/two/three is supposed to mean, it seems about as descriptive as stage doStuff, stage doMoreStuff and stage doEvenMoreStuff...
 	debug(LOG_MAIN, "Init game queues, I am %d.", selectedPlayer);
 	sendQueuedDroidInfo();  // Discard any pending orders which could later get flushed into the game queue.
+	resetQueuedDroidInfo();
 	for (i = 0; i < MAX_PLAYERS; ++i)
 	{
 		NETinitQueue(NETgameQueue(i));
@@ -48,6 +48,8 @@
 #include "geometry.h"
 #include "radar.h"
 #include "structure.h"
+#include "astar.h"
+#include "objectpool.h"
 // FIXME Direct iVis implementation include!
 #include "lib/ivis_opengl/screen.h"
 
@@ -197,6 +199,21 @@ void	kf_PowerInfo()
 	}
 }
 
+void kf_PathInfo()
+{
+	unsigned hits, misses;
+	fpathCacheStatistics(&hits, &misses);
+	console("Path cache: %u hits, %u misses", hits, misses);
+}
+
+void kf_PoolInfo()
+{
+	for (ObjectPoolStatistics const &stats : objectPoolStatistics())
+	{
+		console("%s: %u allocated, %u freed, %u live, %u slots", stats.name, (unsigned)stats.allocations, (unsigned)stats.frees, (unsigned)stats.live, (unsigned)stats.slots);
+	}
+}
+
 void kf_DamageMe()
 {
 #ifndef DEBUG
@@ -769,7 +786,7 @@ void	kf_TileInfo()
 
 	debug(LOG_ERROR, "Tile position=(%d, %d) Terrain=%d Texture=%u Height=%d Illumination=%u",
 	      mouseTileX, mouseTileY, (int)terrainType(psTile), TileNumber_tile(psTile->texture), psTile->height,
-	      psTile->illumination);
+	      mapTileLight(psTile)->illumination);
 	addConsoleMessage("Tile info dumped into log", DEFAULT_JUSTIFY, SYSTEM_MESSAGE);
 }
 
@@ -263,6 +263,8 @@ bool runningMultiplayer();
 
 void kf_ForceDesync();
 void kf_PowerInfo();
+void kf_PathInfo();
+void kf_PoolInfo();
 void kf_BuildNextPage();
 void kf_BuildPrevPage();
 void kf_DamageMe();
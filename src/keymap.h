@@ -23,6 +23,8 @@
 
 #include "lib/framework/input.h"
 
+#include <list>
+
 
 enum KEY_ACTION
 {
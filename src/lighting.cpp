@@ -102,7 +102,7 @@ void initLighting(UDWORD x1, UDWORD y1, UDWORD x2, UDWORD y2)
 			// always make the edge tiles dark
 			if (i == 0 || j == 0 || i >= mapWidth - 1 || j >= mapHeight - 1)
 			{
-				psTile->illumination = 16;
+				mapTileLight(psTile)->illumination = 16;
 
 				// give water tiles at edge of map a border
 				if (terrainType(psTile) == TER_WATER)
@@ -119,7 +119,7 @@ void initLighting(UDWORD x1, UDWORD y1, UDWORD x2, UDWORD y2)
 			if ((SDWORD)i < scrollMinX + 4 || (SDWORD)i > scrollMaxX - 4
 			    || (SDWORD)j < scrollMinY + 4 || (SDWORD)j > scrollMaxY - 4)
 			{
-				psTile->illumination /= 3;
+				mapTileLight(psTile)->illumination /= 3;
 			}
 		}
 	}
@@ -232,7 +232,7 @@ static void calcTileIllum(UDWORD tileX, UDWORD tileY)
 	{
 		val = 254;
 	}
-	mapTile(tileX, tileY)->illumination = val;
+	mapTileLight(tileX, tileY)->illumination = val;
 }
 
 static void colourTile(SDWORD xIndex, SDWORD yIndex, PIELIGHT light_colour, double fraction)
@@ -329,16 +329,16 @@ void calcDroidIllumination(DROID *psDroid)
 	}
 	else if (tileX <= 1 || tileX >= mapWidth - 2 || tileY <= 1 || tileY >= mapHeight - 2)
 	{
-		lightVal = mapTile(tileX, tileY)->illumination;
+		lightVal = mapTileLight(tileX, tileY)->illumination;
 		lightVal += MIN_DROID_LIGHT_LEVEL;
 	}
 	else
 	{
-		lightVal = mapTile(tileX, tileY)->illumination +		 //
-		           mapTile(tileX - 1, tileY)->illumination +	 //		 *
-		           mapTile(tileX, tileY - 1)->illumination +	 //		***		pattern
-		           mapTile(tileX + 1, tileY)->illumination +	 //		 *
-		           mapTile(tileX + 1, tileY + 1)->illumination;	 //
+		lightVal = mapTileLight(tileX, tileY)->illumination +		 //
+		           mapTileLight(tileX - 1, tileY)->illumination +	 //		 *
+		           mapTileLight(tileX, tileY - 1)->illumination +	 //		***		pattern
+		           mapTileLight(tileX + 1, tileY)->illumination +	 //		 *
+		           mapTileLight(tileX + 1, tileY + 1)->illumination;	 //
 		lightVal /= 5;
 		lightVal += MIN_DROID_LIGHT_LEVEL;
 	}
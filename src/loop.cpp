@@ -85,6 +85,7 @@
 #include "random.h"
 #include "qtscript.h"
 #include "version.h"
+#include "benchmark.h"
 
 #include "warzoneconfig.h"
 
@@ -544,6 +545,8 @@ static void gameStateUpdate()
 
 	if (!paused && !scriptPaused())
 	{
+		BenchmarkTimer timer(BENCHMARK_SCRIPTS);
+
 		/* Update the event system */
 		if (!bInTutorial)
 		{
@@ -560,13 +563,22 @@ static void gameStateUpdate()
 	handleAbandonedStructures();
 
 	// Update the visibility change stuff
-	visUpdateLevel();
+	{
+		BenchmarkTimer timer(BENCHMARK_VISIBILITY);
+		visUpdateLevel();
+	}
 
 	// Put all droids/structures/features into the grid.
-	gridReset();
+	{
+		BenchmarkTimer timer(BENCHMARK_GRID);
+		gridReset();
+	}
 
 	// Check which objects are visible.
-	processVisibility();
+	{
+		BenchmarkTimer timer(BENCHMARK_VISIBILITY);
+		processVisibility();
+	}
 
 	// Update the map.
 	mapUpdate();
@@ -584,41 +596,50 @@ static void gameStateUpdate()
 		//update the current power available for a player
 		updatePlayerPower(i);
 
-		DROID *psNext;
-		for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
 		{
-			// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
-			psNext = psCurr->psNext;
-			droidUpdate(psCurr);
-		}
+			BenchmarkTimer timer(BENCHMARK_DROIDS);
+			DROID *psNext;
+			for (DROID *psCurr = apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				// Copy the next pointer - not 100% sure if the droid could get destroyed but this covers us anyway
+				psNext = psCurr->psNext;
+				droidUpdate(psCurr);
+			}
 
-		for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
-		{
-			/* Copy the next pointer - not 100% sure if the droid could
-			get destroyed but this covers us anyway */
-			psNext = psCurr->psNext;
-			missionDroidUpdate(psCurr);
+			for (DROID *psCurr = mission.apsDroidLists[i]; psCurr != nullptr; psCurr = psNext)
+			{
+				/* Copy the next pointer - not 100% sure if the droid could
+				get destroyed but this covers us anyway */
+				psNext = psCurr->psNext;
+				missionDroidUpdate(psCurr);
+			}
 		}
 
 		// FIXME: These for-loops are code duplicationo
-		STRUCTURE *psNBuilding;
-		for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
-		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, false);
-		}
-		for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
 		{
-			/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
-			psNBuilding = psCBuilding->psNext;
-			structureUpdate(psCBuilding, true); // update for mission
+			BenchmarkTimer timer(BENCHMARK_STRUCTURES);
+			STRUCTURE *psNBuilding;
+			for (STRUCTURE *psCBuilding = apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway */
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, false);
+			}
+			for (STRUCTURE *psCBuilding = mission.apsStructLists[i]; psCBuilding != nullptr; psCBuilding = psNBuilding)
+			{
+				/* Copy the next pointer - not 100% sure if the structure could get destroyed but this covers us anyway. It shouldn't do since its not even on the map!*/
+				psNBuilding = psCBuilding->psNext;
+				structureUpdate(psCBuilding, true); // update for mission
+			}
 		}
 	}
 
 	missionTimerUpdate();
 
-	proj_UpdateAll();
+	{
+		BenchmarkTimer timer(BENCHMARK_PROJECTILES);
+		proj_UpdateAll();
+	}
 
 	FEATURE *psNFeat;
 	for (FEATURE *psCFeat = apsFeatureLists[0]; psCFeat; psCFeat = psNFeat)
@@ -631,7 +652,10 @@ static void gameStateUpdate()
 	hciUpdate();
 
 	// Free dead droid memory.
-	objmemUpdate();
+	{
+		BenchmarkTimer timer(BENCHMARK_OBJMEM);
+		objmemUpdate();
+	}
 
 	// Must end update, since we may or may not have ticked, and some message queue processing code may vary depending on whether it's in an update.
 	gameTimeUpdateEnd();
@@ -646,9 +670,46 @@ static void gameStateUpdate()
 	}
 }
 
+/* Run the game for the number of ticks given with --benchmark, as fast as possible and without rendering, then print the timings.
+ * Returns to the main event loop whenever no tick is due yet, so that events still get processed. */
+static GAMECODE benchmarkLoop()
+{
+	if (!benchmarkRunning())
+	{
+		countUpdate(false);
+		gameTimeSetMod(Rational(BENCHMARK_GAME_SPEED));
+		benchmarkStart();
+	}
+
+	while (true)
+	{
+		recvMessage();
+		gameTimeUpdate(true);
+		if (deltaGameTime == 0)
+		{
+			// Waiting for the next tick to be due, or for our own GAME_GAME_TIME message.
+			return benchmarkTickWaiting() ? GAMECODE_CONTINUE : GAMECODE_QUITGAME;
+		}
+
+		syncDebug("Begin game state update, gameTime = %d", gameTime);
+		gameStateUpdate();
+		syncDebug("End game state update, gameTime = %d", gameTime);
+		if (!benchmarkTickDone())
+		{
+			benchmarkReport();
+			return GAMECODE_QUITGAME;
+		}
+	}
+}
+
 /* The main game loop */
 GAMECODE gameLoop()
 {
+	if (benchmarkEnabled())
+	{
+		return benchmarkLoop();
+	}
+
 	static uint32_t lastFlushTime = 0;
 
 	static int renderBudget = 0;  // Scaled time spent rendering minus scaled time spent updating.
@@ -58,6 +58,7 @@
 #include "lib/sound/audio.h"
 #include "lib/sound/cdaudio.h"
 
+#include "benchmark.h"
 #include "clparse.h"
 #include "challenge.h"
 #include "configuration.h"
@@ -950,6 +951,11 @@ static void runGameLoop()
 	case GAMECODE_QUITGAME:
 		debug(LOG_MAIN, "GAMECODE_QUITGAME");
 		stopGameLoop();
+		if (benchmarkEnabled())
+		{
+			wzQuit(); // Benchmark finished, shut down normally
+			break;
+		}
 		startTitleLoop(); // Restart into titleloop
 		break;
 	case GAMECODE_LOADGAME:
@@ -1038,7 +1044,7 @@ void mainLoop()
 		inputLoseFocus();		// remove it from input stream
 	}
 
-	if (NetPlay.bComms || focusState == FOCUS_IN || !war_GetPauseOnFocusLoss())
+	if (NetPlay.bComms || focusState == FOCUS_IN || !war_GetPauseOnFocusLoss() || benchmarkEnabled())
 	{
 		if (loop_GetVideoStatus())
 		{
@@ -1402,7 +1408,7 @@ int realmain(int argc, char *argv[])
 #endif
 	wzShutdown();
 	debug(LOG_MAIN, "Completed shutting down Warzone 2100");
-	return EXIT_SUCCESS;
+	return benchmarkFailed() ? EXIT_FAILURE : EXIT_SUCCESS;
 }
 
 /*!
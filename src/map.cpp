@@ -27,6 +27,7 @@
 
 #include "lib/framework/frame.h"
 #include "lib/framework/endian_hack.h"
+#include "lib/framework/math_ext.h"
 #include "lib/framework/file.h"
 #include "lib/framework/physfs_ext.h"
 #include "lib/ivis_opengl/tex.h"
@@ -64,7 +65,49 @@ struct floodtile
 static struct floodtile *floodbucket = nullptr;
 static int bucketcounter;
 static UDWORD lastDangerUpdate = 0;
-static int lastDangerPlayer = -1;
+
+/// Object which may shoot at some tiles, copied from the object lists for the danger thread.
+struct DangerThreat
+{
+	unsigned firstTile, numTiles;  ///< Tiles the object can see, in dangerThreatTiles.
+	uint32_t seenBy;               ///< Bit mask of the players who know about the object.
+	uint8_t player;
+	uint8_t bits;                  ///< AUXBITS_THREAT and/or AUXBITS_AATHREAT.
+};
+
+// Snapshot taken on the main thread, and only read by the danger thread. The blocking map is in psBlockMap[AUX_DANGERMAP].
+static int dangerPlayers = 0;      ///< Number of players to calculate danger maps for, or 0 to stop the danger thread.
+static std::vector<DangerThreat> dangerThreats;
+static std::vector<TILEPOS> dangerThreatTiles;
+static bool dangerAlliances[MAX_PLAYERS][MAX_PLAYERS];
+static Vector2i dangerStartPositions[MAX_PLAYERS];
+/// Copy of each player's aux map, in which the danger thread calculates the danger and threat bits.
+static std::vector<uint8_t> dangerMaps[MAX_PLAYERS];
+
+/// A burning tile, to be extinguished at the given (gameTime / GAME_TICKS_PER_UPDATE).
+struct BurningTile
+{
+	/// Orders the heap so that the earliest fire is on top, and fires ending at the same time are in tile order.
+	bool operator <(BurningTile const &b) const
+	{
+		return endTime != b.endTime ? endTime > b.endTime : y != b.y ? y > b.y : x > b.x;
+	}
+
+	uint32_t endTime;
+	int x, y;
+	MAPTILE *map;  ///< psMapTiles when the tile was set on fire, since the mission map may be swapped in.
+};
+static std::vector<BurningTile> burningTiles;  ///< Heap of burning tiles, may contain fires which have since been extended.
+
+/// Max surface height of the tile corners in each 2^level × 2^level block of tiles, level 0 being single tiles, so that rays can skip terrain they are above.
+struct HeightPyramidLevel
+{
+	int width, height;
+	std::vector<int32_t> maxHeight;
+};
+static std::vector<HeightPyramidLevel> heightPyramid;
+static MAPTILE *heightPyramidMap = nullptr;   ///< psMapTiles when heightPyramid was built, since the mission map may be swapped in.
+static uint32_t heightPyramidVersion = 0;     ///< mapHeightVersion when heightPyramid was built.
 
 //scroll min and max values
 SDWORD		scrollMinX, scrollMaxX, scrollMinY, scrollMaxY;
@@ -105,8 +148,10 @@ struct GATEWAY_SAVE
 /* The size and contents of the map */
 SDWORD	mapWidth = 0, mapHeight = 0;
 MAPTILE	*psMapTiles = nullptr;
+uint32_t mapHeightVersion = 0;
 uint8_t *psBlockMap[AUX_MAX];
-uint8_t *psAuxMap[MAX_PLAYERS + AUX_MAX];        // yes, we waste one element... eyes wide open... makes API nicer
+uint8_t *psAuxMap[MAX_PLAYERS];
+uint32_t auxMapVersion = 0;
 
 #define WATER_MIN_DEPTH 500
 #define WATER_MAX_DEPTH (WATER_MIN_DEPTH + 400)
@@ -783,12 +828,13 @@ bool mapLoad(char *filename, bool preview)
 	/* See if this is the first time a map has been loaded */
 	ASSERT(psMapTiles == nullptr, "Map has not been cleared before calling mapLoad()!");
 
-	/* Allocate the memory for the map */
-	psMapTiles = (MAPTILE *)calloc(width * height, sizeof(MAPTILE));
+	/* Allocate the memory for the map, followed by the light and vision planes */
+	psMapTiles = (MAPTILE *)calloc(width * height, sizeof(MAPTILE) + sizeof(MAPTILE_LIGHT) + sizeof(MAPTILE_VISION));
 	ASSERT(psMapTiles != nullptr, "Out of memory");
 
 	mapWidth = width;
 	mapHeight = height;
+	++mapHeightVersion;
 
 	// FIXME: the map preview code loads the map without setting the tileset
 	if (!tilesetDir)
@@ -820,9 +866,7 @@ bool mapLoad(char *filename, bool preview)
 		psMapTiles[i].height = height * ELEVATION_SCALE;
 
 		// Visibility stuff
-		memset(psMapTiles[i].watchers, 0, sizeof(psMapTiles[i].watchers));
-		memset(psMapTiles[i].sensors, 0, sizeof(psMapTiles[i].sensors));
-		memset(psMapTiles[i].jammers, 0, sizeof(psMapTiles[i].jammers));
+		memset(mapTileVision(&psMapTiles[i]), 0, sizeof(MAPTILE_VISION));
 		psMapTiles[i].sensorBits = 0;
 		psMapTiles[i].jammerBits = 0;
 		psMapTiles[i].tileExploredBits = 0;
@@ -879,10 +923,11 @@ bool mapLoad(char *filename, bool preview)
 	psBlockMap[AUX_MAP] = (uint8_t *)malloc(mapWidth * mapHeight * sizeof(*psBlockMap[0]));
 	psBlockMap[AUX_ASTARMAP] = (uint8_t *)malloc(mapWidth * mapHeight * sizeof(*psBlockMap[0]));
 	psBlockMap[AUX_DANGERMAP] = (uint8_t *)malloc(mapWidth * mapHeight * sizeof(*psBlockMap[0]));
-	for (x = 0; x < MAX_PLAYERS + AUX_MAX; x++)
+	for (x = 0; x < MAX_PLAYERS; x++)
 	{
 		psAuxMap[x] = (uint8_t *)malloc(mapWidth * mapHeight * sizeof(*psAuxMap[0]));
 	}
+	++auxMapVersion;
 
 	// Set our blocking bits
 	for (y = 0; y < mapHeight; y++)
@@ -913,6 +958,7 @@ bool mapLoad(char *filename, bool preview)
 			}
 		}
 	}
+	fpathMarkBlockingChanged(StructureBounds(Vector2i(0, 0), Vector2i(mapWidth, mapHeight)));
 
 	/* Set continents. This should ideally be done in advance by the map editor. */
 	mapFloodFillContinents();
@@ -1021,7 +1067,7 @@ bool mapShutdown()
 	if (dangerThread)
 	{
 		wzSemaphoreWait(dangerDoneSemaphore);
-		lastDangerPlayer = -1;
+		dangerPlayers = 0;
 		wzSemaphorePost(dangerSemaphore);
 		wzThreadJoin(dangerThread);
 		wzSemaphoreDestroy(dangerSemaphore);
@@ -1031,7 +1077,13 @@ bool mapShutdown()
 		dangerDoneSemaphore = nullptr;
 	}
 
+	// Only the fires on the mission map, if it is kept, outlive this map. Any other map they were on has been freed or dropped.
+	burningTiles.erase(std::remove_if(burningTiles.begin(), burningTiles.end(), [](BurningTile const &fire) { return fire.map == psMapTiles || fire.map != mission.psMapTiles; }), burningTiles.end());
+	std::make_heap(burningTiles.begin(), burningTiles.end());
+
 	free(psMapTiles);
+	heightPyramid.clear();
+	heightPyramidMap = nullptr;
 	delete[] mapDecals;
 	free(psGroundTypes);
 	free(map);
@@ -1043,11 +1095,12 @@ bool mapShutdown()
 	free(psBlockMap[AUX_DANGERMAP]);
 	free(floodbucket);
 	psBlockMap[AUX_DANGERMAP] = nullptr;
-	for (x = 0; x < MAX_PLAYERS + AUX_MAX; x++)
+	for (x = 0; x < MAX_PLAYERS; x++)
 	{
 		free(psAuxMap[x]);
 		psAuxMap[x] = nullptr;
 	}
+	++auxMapVersion;
 
 	map = nullptr;
 	floodbucket = nullptr;
@@ -1281,6 +1334,14 @@ static inline bool fracTest(int numerA, int denomA, int numerB, int denomB)
 
 unsigned map_LineIntersect(Vector3i src, Vector3i dst, unsigned tMax)
 {
+	// A segment which stays on the map and is everywhere above the highest tile corner around it can't intersect.
+	Vector2i const segmentMin = map_coord(Vector2i(std::min(src.x, dst.x), std::min(src.y, dst.y)));
+	Vector2i const segmentMax = map_coord(Vector2i(std::max(src.x, dst.x), std::max(src.y, dst.y)));
+	if (worldOnMap(src.xy()) && worldOnMap(dst.xy()) && std::min(src.z, dst.z) > map_AreaMaxHeight(segmentMin.x, segmentMin.y, segmentMax.x, segmentMax.y))
+	{
+		return UINT32_MAX;
+	}
+
 	// Transform src and dst to a coordinate system such that the tile quadrant containing src has
 	// corners at (0, 0), (TILE_UNITS, 0), (TILE_UNITS/2, TILE_UNITS/2).
 	Vector2i tile = map_coord(src.xy());
@@ -1370,6 +1431,83 @@ unsigned map_LineIntersect(Vector3i src, Vector3i dst, unsigned tMax)
 	}
 }
 
+static void heightPyramidUpdate()
+{
+	if (heightPyramidMap == psMapTiles && heightPyramidVersion == mapHeightVersion && !heightPyramid.empty() && heightPyramid[0].width == mapWidth && heightPyramid[0].height == mapHeight)
+	{
+		return;
+	}
+	heightPyramidMap = psMapTiles;
+	heightPyramidVersion = mapHeightVersion;
+
+	heightPyramid.resize(1);
+	HeightPyramidLevel &tiles = heightPyramid[0];
+	tiles.width = mapWidth;
+	tiles.height = mapHeight;
+	tiles.maxHeight.resize(mapWidth * mapHeight);
+	for (int y = 0; y < mapHeight; ++y)
+	{
+		for (int x = 0; x < mapWidth; ++x)
+		{
+			// Corners off the map have height 0, same as in map_Height and map_LineIntersect.
+			tiles.maxHeight[x + y * mapWidth] = std::max(std::max(map_TileHeightSurface(x, y), map_TileHeightSurface(x + 1, y)),
+			                                             std::max(map_TileHeightSurface(x, y + 1), map_TileHeightSurface(x + 1, y + 1)));
+		}
+	}
+
+	while (heightPyramid.back().width > 1 || heightPyramid.back().height > 1)
+	{
+		heightPyramid.emplace_back();
+		HeightPyramidLevel const &fine = heightPyramid[heightPyramid.size() - 2];
+		HeightPyramidLevel &coarse = heightPyramid.back();
+		coarse.width = (fine.width + 1) / 2;
+		coarse.height = (fine.height + 1) / 2;
+		coarse.maxHeight.assign(coarse.width * coarse.height, 0);
+		for (int y = 0; y < fine.height; ++y)
+		{
+			for (int x = 0; x < fine.width; ++x)
+			{
+				int32_t &height = coarse.maxHeight[x / 2 + y / 2 * coarse.width];
+				height = std::max(height, fine.maxHeight[x + y * fine.width]);
+			}
+		}
+	}
+}
+
+int32_t map_TileMaxHeight(int x, int y)
+{
+	heightPyramidUpdate();
+	x = clip(x, 0, mapWidth - 1);
+	y = clip(y, 0, mapHeight - 1);
+	return heightPyramid[0].maxHeight[x + y * mapWidth];
+}
+
+int32_t map_AreaMaxHeight(int x1, int y1, int x2, int y2)
+{
+	heightPyramidUpdate();
+	x1 = clip(x1, 0, mapWidth - 1);
+	y1 = clip(y1, 0, mapHeight - 1);
+	x2 = clip(x2, 0, mapWidth - 1);
+	y2 = clip(y2, 0, mapHeight - 1);
+
+	// Use the finest level where the area is within 2×2 blocks.
+	unsigned level = 0;
+	while ((x2 >> level) - (x1 >> level) > 1 || (y2 >> level) - (y1 >> level) > 1)
+	{
+		++level;
+	}
+	HeightPyramidLevel const &blocks = heightPyramid[level];
+	int32_t height = 0;
+	for (int y = y1 >> level; y <= y2 >> level; ++y)
+	{
+		for (int x = x1 >> level; x <= x2 >> level; ++x)
+		{
+			height = std::max(height, blocks.maxHeight[x + y * blocks.width]);
+		}
+	}
+	return height;
+}
+
 /// The max height of the terrain and water at the specified world coordinates
 extern int32_t map_Height(int x, int y)
 {
@@ -1761,6 +1899,8 @@ void tileSetFire(int32_t x, int32_t y, uint32_t duration)
 	// Burn, tile, burn!
 	tile->tileInfoBits |= BITS_ON_FIRE;
 	tile->fireEndTime = fireEndTime;
+	burningTiles.push_back(BurningTile{(gameTime + duration) / GAME_TICKS_PER_UPDATE, posX, posY, psMapTiles});
+	std::push_heap(burningTiles.begin(), burningTiles.end());
 
 	syncDebug("Fire tile{%d, %d} dur%u end%d", posX, posY, duration, fireEndTime);
 }
@@ -1777,22 +1917,22 @@ bool fireOnLocation(unsigned int x, unsigned int y)
 }
 
 // This function runs in a separate thread!
-static int dangerFloodFill(int player)
+static void dangerFloodFill(int player)
 {
 	int i;
-	Vector2i pos = getPlayerStartPosition(player);
+	Vector2i pos = dangerStartPositions[player];
 	Vector2i npos(0, 0);
 	uint8_t aux, block;
 	int x, y;
 	bool start = true;	// hack to disregard the blocking status of any building exactly on the starting position
+	uint8_t *auxMap = dangerMaps[player].data();
 
 	// Set our danger bits
 	for (y = 0; y < mapHeight; y++)
 	{
 		for (x = 0; x < mapWidth; x++)
 		{
-			auxSet(x, y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_DANGER);
-			auxClear(x, y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_TEMPORARY);
+			auxMap[x + y * mapWidth] = (auxMap[x + y * mapWidth] | AUXBITS_DANGER) & ~AUXBITS_TEMPORARY;
 		}
 	}
 
@@ -1811,7 +1951,7 @@ static int dangerFloodFill(int player)
 			{
 				continue;
 			}
-			aux = auxTile(npos.x, npos.y, MAX_PLAYERS + AUX_DANGERMAP);
+			aux = auxMap[npos.x + npos.y * mapWidth];
 			block = blockTile(pos.x, pos.y, AUX_DANGERMAP);
 			if (!(aux & AUXBITS_TEMPORARY) && !(aux & AUXBITS_THREAT) && (aux & AUXBITS_DANGER))
 			{
@@ -1828,14 +1968,14 @@ static int dangerFloodFill(int player)
 				}
 				else
 				{
-					auxClear(npos.x, npos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_DANGER);
+					auxMap[npos.x + npos.y * mapWidth] &= ~AUXBITS_DANGER;
 				}
-				auxSet(npos.x, npos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_TEMPORARY); // make sure we do not process it more than once
+				auxMap[npos.x + npos.y * mapWidth] |= AUXBITS_TEMPORARY; // make sure we do not process it more than once
 			}
 		}
 
 		// Clear danger
-		auxClear(pos.x, pos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_DANGER);
+		auxMap[pos.x + pos.y * mapWidth] &= ~AUXBITS_DANGER;
 
 		// Pop the last open node off the bucket list for the next iteration
 		if (bucketcounter)
@@ -1846,68 +1986,101 @@ static int dangerFloodFill(int player)
 		}
 	}
 	while (bucketcounter);
-	return 0;
+}
+
+// This function runs in a separate thread!
+static void threatUpdate(int player)
+{
+	uint8_t *auxMap = dangerMaps[player].data();
+
+	// Step 1: Clear our threat bits
+	for (int i = 0; i < mapWidth * mapHeight; i++)
+	{
+		auxMap[i] &= ~(AUXBITS_THREAT | AUXBITS_AATHREAT);
+	}
+
+	// Step 2: Set threat bits
+	for (DangerThreat const &threat : dangerThreats)
+	{
+		if (dangerAlliances[player][threat.player] || !(threat.seenBy & (1 << player)))
+		{
+			// No need to iterate friendly objects, and we don't know about objects we haven't seen
+			continue;
+		}
+		for (unsigned i = threat.firstTile; i < threat.firstTile + threat.numTiles; i++)
+		{
+			const TILEPOS pos = dangerThreatTiles[i];
+
+			auxMap[pos.x + pos.y * mapWidth] |= threat.bits;	// set ground and/or air threat for this tile
+		}
+	}
+}
+
+// This function runs in a separate thread!
+static void dangerUpdate()
+{
+	for (int player = 0; player < dangerPlayers; player++)
+	{
+		threatUpdate(player);
+		dangerFloodFill(player);
+	}
 }
 
 // This function runs in a separate thread!
 static int dangerThreadFunc(WZ_DECL_UNUSED void *data)
 {
-	while (lastDangerPlayer != -1)
+	while (dangerPlayers != 0)
 	{
-		dangerFloodFill(lastDangerPlayer);	// Do the actual work
+		dangerUpdate();	// Do the actual work
 		wzSemaphorePost(dangerDoneSemaphore);   // Signal that we are done
 		wzSemaphoreWait(dangerSemaphore);	// Go to sleep until needed.
 	}
 	return 0;
 }
 
-static inline void threatUpdateTarget(int player, BASE_OBJECT *psObj, bool ground, bool air)
+static void dangerAddThreat(BASE_OBJECT *psObj, UBYTE mode)
 {
-	int i;
-
-	if (psObj->visible[player] || psObj->born == 2)
+	DangerThreat threat;
+	threat.firstTile = dangerThreatTiles.size();
+	threat.numTiles = psObj->numWatchedTiles;
+	threat.player = psObj->player;
+	threat.bits = (mode & SHOOT_ON_GROUND ? AUXBITS_THREAT : 0) | (mode & SHOOT_IN_AIR ? AUXBITS_AATHREAT : 0);
+	threat.seenBy = 0;
+	for (int player = 0; player < MAX_PLAYERS; player++)
 	{
-		for (i = 0; i < psObj->numWatchedTiles; i++)
+		if (psObj->visible[player] || psObj->born == 2)
 		{
-			const TILEPOS pos = psObj->watchedTiles[i];
-
-			if (ground)
-			{
-				auxSet(pos.x, pos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_THREAT);	// set ground threat for this tile
-			}
-			if (air)
-			{
-				auxSet(pos.x, pos.y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_AATHREAT);	// set air threat for this tile
-			}
+			threat.seenBy |= 1 << player;
 		}
 	}
+	dangerThreatTiles.insert(dangerThreatTiles.end(), psObj->watchedTiles, psObj->watchedTiles + psObj->numWatchedTiles);
+	dangerThreats.push_back(threat);
 }
 
-static void threatUpdate(int player)
+/// Copies everything the danger thread reads for the first numPlayers players, so it never touches the live map or objects.
+static void dangerSnapshot(int numPlayers)
 {
-	int i, weapon, x, y;
+	int i, weapon;
 
-	// Step 1: Clear our threat bits
-	for (y = 0; y < mapHeight; y++)
+	dangerPlayers = numPlayers;
+	memcpy(psBlockMap[AUX_DANGERMAP], psBlockMap[AUX_MAP], sizeof(*psBlockMap[AUX_MAP]) * mapWidth * mapHeight);
+	for (int player = 0; player < numPlayers; player++)
 	{
-		for (x = 0; x < mapWidth; x++)
+		dangerMaps[player].assign(psAuxMap[player], psAuxMap[player] + mapWidth * mapHeight);
+		dangerStartPositions[player] = getPlayerStartPosition(player);
+		for (i = 0; i < MAX_PLAYERS; i++)
 		{
-			auxClear(x, y, MAX_PLAYERS + AUX_DANGERMAP, AUXBITS_THREAT | AUXBITS_AATHREAT);
+			dangerAlliances[player][i] = aiCheckAlliances(player, i);
 		}
 	}
 
-	// Step 2: Set threat bits
+	dangerThreats.clear();
+	dangerThreatTiles.clear();
 	for (i = 0; i < MAX_PLAYERS; i++)
 	{
 		DROID *psDroid;
 		STRUCTURE *psStruct;
 
-		if (aiCheckAlliances(player, i))
-		{
-			// No need to iterate friendly objects
-			continue;
-		}
-
 		for (psDroid = apsDroidLists[i]; psDroid; psDroid = psDroid->psNext)
 		{
 			UBYTE mode = 0;
@@ -1927,7 +2100,7 @@ static void threatUpdate(int player)
 			}
 			if (mode > 0)
 			{
-				threatUpdateTarget(player, (BASE_OBJECT *)psDroid, mode & SHOOT_ON_GROUND, mode & SHOOT_IN_AIR);
+				dangerAddThreat(psDroid, mode);
 			}
 		}
 
@@ -1945,34 +2118,44 @@ static void threatUpdate(int player)
 			}
 			if (mode > 0)
 			{
-				threatUpdateTarget(player, (BASE_OBJECT *)psStruct, mode & SHOOT_ON_GROUND, mode & SHOOT_IN_AIR);
+				dangerAddThreat(psStruct, mode);
 			}
 		}
 	}
 }
 
-void mapInit()
+/// Swaps in the danger and threat bits calculated by the danger thread. Call only when the danger thread is idle.
+static void dangerApply()
 {
-	int player;
+	const uint8_t mask = AUXBITS_DANGER | AUXBITS_THREAT | AUXBITS_AATHREAT;
+
+	for (int player = 0; player < dangerPlayers; player++)
+	{
+		uint8_t *auxMap = psAuxMap[player];
+		uint8_t const *cached = dangerMaps[player].data();
+		for (int i = 0; i < mapWidth * mapHeight; i++)
+		{
+			auxMap[i] ^= (auxMap[i] ^ cached[i]) & mask;
+		}
+	}
+}
 
+void mapInit()
+{
 	free(floodbucket);
 	floodbucket = (struct floodtile *)malloc(mapWidth * mapHeight * sizeof(*floodbucket));
 
 	lastDangerUpdate = 0;
-	lastDangerPlayer = -1;
+	dangerPlayers = 0;
 
 	// Start danger thread (not used for campaign for now - mission map swaps too icky)
 	ASSERT(dangerSemaphore == nullptr && dangerThread == nullptr, "Map data not cleaned up before starting!");
 	if (game.type == SKIRMISH)
 	{
-		for (player = 0; player < MAX_PLAYERS; player++)
-		{
-			auxMapStore(player, AUX_DANGERMAP);
-			threatUpdate(player);
-			dangerFloodFill(player);
-			auxMapRestore(player, AUX_DANGERMAP, AUXBITS_DANGER | AUXBITS_THREAT | AUXBITS_AATHREAT);
-		}
-		lastDangerPlayer = 0;
+		dangerSnapshot(MAX_PLAYERS);
+		dangerUpdate();
+		dangerApply();
+		dangerSnapshot(game.maxPlayers);
 		dangerSemaphore = wzSemaphoreCreate(0);
 		dangerDoneSemaphore = wzSemaphoreCreate(0);
 		dangerThread = wzThreadCreate(dangerThreadFunc, nullptr);
@@ -1982,35 +2165,50 @@ void mapInit()
 
 void mapUpdate()
 {
-	const uint16_t currentTime = gameTime / GAME_TICKS_PER_UPDATE;
-	int posX, posY;
+	const uint32_t currentTime = gameTime / GAME_TICKS_PER_UPDATE;
+	std::vector<BurningTile> offWorldFires;
 
-	for (posY = 0; posY < mapHeight; ++posY)
-		for (posX = 0; posX < mapWidth; ++posX)
+	// Only look at the tiles which are due, in tile order, instead of checking every tile on the map.
+	while (!burningTiles.empty() && burningTiles.front().endTime <= currentTime)
+	{
+		std::pop_heap(burningTiles.begin(), burningTiles.end());
+		BurningTile fire = burningTiles.back();
+		burningTiles.pop_back();
+
+		if (fire.map != psMapTiles)
 		{
-			MAPTILE *const tile = mapTile(posX, posY);
+			// Map swapped out, so the tile doesn't get checked until the 16-bit fireEndTime comes around again.
+			fire.endTime += 0x10000;
+			offWorldFires.push_back(fire);
+			continue;
+		}
 
-			if ((tile->tileInfoBits & BITS_ON_FIRE) != 0 && tile->fireEndTime == currentTime)
-			{
-				// Extinguish, tile, extinguish!
-				tile->tileInfoBits &= ~BITS_ON_FIRE;
+		MAPTILE *const tile = mapTile(fire.x, fire.y);
+		if ((tile->tileInfoBits & BITS_ON_FIRE) != 0 && tile->fireEndTime == (uint16_t)currentTime)
+		{
+			// Extinguish, tile, extinguish!
+			tile->tileInfoBits &= ~BITS_ON_FIRE;
 
-				syncDebug("Extinguished tile{%d, %d}", posX, posY);
-			}
+			syncDebug("Extinguished tile{%d, %d}", fire.x, fire.y);
 		}
+	}
+	for (BurningTile const &fire : offWorldFires)
+	{
+		burningTiles.push_back(fire);
+		std::push_heap(burningTiles.begin(), burningTiles.end());
+	}
 
 	if (gameTime > lastDangerUpdate + GAME_TICKS_FOR_DANGER && game.type == SKIRMISH)
 	{
 		syncDebug("Do danger maps.");
 		lastDangerUpdate = gameTime;
 
-		// Lock if previous job not done yet
+		// Lock if previous job not done yet, which it normally is, since it had GAME_TICKS_FOR_DANGER to finish.
 		wzSemaphoreWait(dangerDoneSemaphore);
 
-		auxMapRestore(lastDangerPlayer, AUX_DANGERMAP, AUXBITS_THREAT | AUXBITS_AATHREAT | AUXBITS_DANGER);
-		lastDangerPlayer = (lastDangerPlayer + 1) % game.maxPlayers;
-		auxMapStore(lastDangerPlayer, AUX_DANGERMAP);
-		threatUpdate(lastDangerPlayer);
+		// Swap in the maps calculated from the previous snapshot, and start calculating the next ones.
+		dangerApply();
+		dangerSnapshot(game.maxPlayers);
 		wzSemaphorePost(dangerSemaphore);
 	}
 }
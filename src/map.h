@@ -92,24 +92,35 @@ struct GROUND_TYPE
 };
 
 /* Information stored with each tile */
+/* Only what the game logic reads often is kept here; lighting and vision counters are in separate planes, see mapTileLight and mapTileVision. */
 struct MAPTILE
 {
-	uint8_t			tileInfoBits;
-	PlayerMask              tileExploredBits;
-	PlayerMask              sensorBits;             ///< bit per player, who can see tile with sensor
-	uint8_t			illumination;	// How bright is this tile?
-	uint8_t			watchers[MAX_PLAYERS];		// player sees through fog of war here with this many objects
-	uint16_t		texture;		// Which graphics texture is on this tile
 	int32_t                 height;                 ///< The height at the top left of the tile
-	float                   level;                  ///< The visibility level of the top left of the tile, for this client.
+	int32_t                 waterLevel;             ///< At what height is the water for this tile
 	BASE_OBJECT		*psObject;		// Any object sitting on the location (e.g. building)
-	PIELIGHT		colour;
+	uint8_t			tileInfoBits;
+	uint8_t			ground;			///< The ground type used for the terrain renderer
+	uint16_t		texture;		// Which graphics texture is on this tile
 	uint16_t		limitedContinent;	///< For land or sea limited propulsion types
 	uint16_t		hoverContinent;		///< For hover type propulsions
-	uint8_t			ground;			///< The ground type used for the terrain renderer
-	uint16_t                fireEndTime;            ///< The (uint16_t)(gameTime / GAME_TICKS_PER_UPDATE) that BITS_ON_FIRE should be cleared.
-	int32_t                 waterLevel;             ///< At what height is the water for this tile
+	PlayerMask              tileExploredBits;
+	PlayerMask              sensorBits;             ///< bit per player, who can see tile with sensor
 	PlayerMask		jammerBits;             ///< bit per player, who is jamming tile
+	uint16_t                fireEndTime;            ///< The (uint16_t)(gameTime / GAME_TICKS_PER_UPDATE) that BITS_ON_FIRE should be cleared.
+};
+
+/* Lighting of each tile, only used for drawing */
+struct MAPTILE_LIGHT
+{
+	float                   level;                  ///< The visibility level of the top left of the tile, for this client.
+	PIELIGHT		colour;
+	uint8_t			illumination;	// How bright is this tile?
+};
+
+/* How many objects of each player see each tile, only used when objects start or stop watching tiles */
+struct MAPTILE_VISION
+{
+	uint8_t			watchers[MAX_PLAYERS];		// player sees through fog of war here with this many objects
 	uint8_t                 sensors[MAX_PLAYERS];   ///< player sees this tile with this many radar sensors
 	uint8_t                 jammers[MAX_PLAYERS];   ///< player jams the tile with this many objects
 };
@@ -118,6 +129,7 @@ struct MAPTILE
 extern SDWORD	mapWidth, mapHeight;
 extern MAPTILE *psMapTiles;
 extern float waterLevel;
+extern uint32_t mapHeightVersion;  ///< Changed whenever a tile height changes, so cached line of sight can be invalidated.
 extern GROUND_TYPE *psGroundTypes;
 extern int numGroundTypes;
 extern char *tilesetDir;
@@ -143,7 +155,8 @@ extern char *tilesetDir;
 #define AUX_MAX		3
 
 extern uint8_t *psBlockMap[AUX_MAX];
-extern uint8_t *psAuxMap[MAX_PLAYERS + AUX_MAX];	// yes, we waste one element... eyes wide open... makes API nicer
+extern uint8_t *psAuxMap[MAX_PLAYERS];
+extern uint32_t auxMapVersion;  ///< Changed whenever psBlockMap and psAuxMap are allocated, freed or swapped with the mission maps.
 
 /// Find aux bitfield for a given tile
 WZ_DECL_ALWAYS_INLINE static inline uint8_t auxTile(int x, int y, int player)
@@ -157,27 +170,6 @@ WZ_DECL_ALWAYS_INLINE static inline uint8_t blockTile(int x, int y, int slot)
 	return psBlockMap[slot][x + y * mapWidth];
 }
 
-/// Store a shadow copy of a player's aux map for use in threaded calculations
-static inline void auxMapStore(int player, int slot)
-{
-	memcpy(psBlockMap[slot], psBlockMap[0], sizeof(*psBlockMap[player]) * mapWidth * mapHeight);
-	memcpy(psAuxMap[MAX_PLAYERS + slot], psAuxMap[player], sizeof(*psAuxMap[player]) * mapWidth * mapHeight);
-}
-
-/// Restore selected fields from the shadow copy of a player's aux map (ignoring the block map)
-static inline void auxMapRestore(int player, int slot, int mask)
-{
-	int i;
-	uint8_t original, cached;
-
-	for (i = 0; i < mapHeight * mapWidth; i++)
-	{
-		original = psAuxMap[player][i];
-		cached = psAuxMap[MAX_PLAYERS + slot][i];
-		psAuxMap[player][i] = original ^ ((original ^ cached) & mask);
-	}
-}
-
 /// Set aux bits. Always set identically for all players. States not set are retained.
 WZ_DECL_ALWAYS_INLINE static inline void auxSet(int x, int y, int player, int state)
 {
@@ -444,6 +436,35 @@ static inline WZ_DECL_PURE MAPTILE *mapTile(Vector2i const &v)
 	return mapTile(v.x, v.y);
 }
 
+/** Return the lighting of a tile of the current map. The planes are allocated after the tiles, in the same block, so
+ *  that they follow psMapTiles around when the mission map is swapped in and out. */
+static inline WZ_DECL_PURE MAPTILE_LIGHT *mapTileLight(MAPTILE const *psTile)
+{
+#ifdef DEBUG
+	ASSERT(psTile >= psMapTiles && psTile < psMapTiles + mapWidth * mapHeight, "mapTileLight: tile is not on the current map");
+#endif
+	return reinterpret_cast<MAPTILE_LIGHT *>(psMapTiles + mapWidth * mapHeight) + (psTile - psMapTiles);
+}
+
+static inline WZ_DECL_PURE MAPTILE_LIGHT *mapTileLight(int32_t x, int32_t y)
+{
+	return mapTileLight(mapTile(x, y));
+}
+
+/** Return the vision counters of a tile of the current map. */
+static inline WZ_DECL_PURE MAPTILE_VISION *mapTileVision(MAPTILE const *psTile)
+{
+#ifdef DEBUG
+	ASSERT(psTile >= psMapTiles && psTile < psMapTiles + mapWidth * mapHeight, "mapTileVision: tile is not on the current map");
+#endif
+	return reinterpret_cast<MAPTILE_VISION *>(reinterpret_cast<MAPTILE_LIGHT *>(psMapTiles + mapWidth * mapHeight) + mapWidth * mapHeight) + (psTile - psMapTiles);
+}
+
+static inline WZ_DECL_PURE MAPTILE_VISION *mapTileVision(int32_t x, int32_t y)
+{
+	return mapTileVision(mapTile(x, y));
+}
+
 /** Return a pointer to the tile structure at x,y in world coordinates */
 static inline WZ_DECL_PURE MAPTILE *worldTile(int32_t x, int32_t y)
 {
@@ -492,6 +513,7 @@ static inline void setTileHeight(int32_t x, int32_t y, int32_t height)
 	ASSERT_OR_RETURN(, y < mapHeight && x >= 0, "y coordinate %d bigger than map height %u", y, mapHeight);
 
 	psMapTiles[x + (y * mapWidth)].height = height;
+	++mapHeightVersion;
 	markTileDirty(x, y);
 }
 
@@ -532,6 +554,14 @@ bool map_Intersect(int *Cx, int *Cy, int *Vx, int *Vy, int *Sx, int *Sy);
 /// the terrain.
 unsigned map_LineIntersect(Vector3i src, Vector3i dst, unsigned tMax);
 
+/// Max of the surface heights at the corners of the tile at x, y, so map_Height is never more than one higher anywhere on
+/// the tile. Tile coordinates off the map are clamped to it, as in map_Height. Call from main thread.
+int32_t map_TileMaxHeight(int x, int y);
+
+/// Upper bound of the surface heights at the corners of the tiles from x1, y1 to x2, y2 inclusive, looked up in a pyramid of
+/// block maxima which is rebuilt when mapHeightVersion changes. May be higher than the true maximum, never lower. Call from main thread.
+int32_t map_AreaMaxHeight(int x1, int y1, int x2, int y2);
+
 /// The max height of the terrain and water at the specified world coordinates
 int32_t map_Height(int x, int y);
 
@@ -32,37 +32,165 @@
 #include "pointtree.h"
 
 
-static PointTree *gridPointTree = nullptr;  // A quad-tree-like object.
-static PointTree::Filter *gridFiltersUnseen;
-static PointTree::Filter *gridFiltersDroidsByPlayer;
+/// Objects of one layer of the grid, and filters for skipping objects in later searches in the same tick.
+struct GridLayer
+{
+	PointTree tree;                                  ///< A quad-tree-like object.
+	PointTree::Filter filtersUnseen[MAX_PLAYERS];
+	bool filtersUnseenValid[MAX_PLAYERS];            ///< Filters are only reset when first used in a tick.
+	PointTree::Filter filtersDroidsByPlayer[MAX_PLAYERS];
+	bool filtersDroidsByPlayerValid[MAX_PLAYERS];
+};
+
+/// Structure or feature added to or removed from the object lists since the last gridReset.
+struct GridStaticChange
+{
+	BASE_OBJECT *psObj;  ///< Only compared, never dereferenced, since the object may have been freed by now.
+	Vector2i pos;
+	unsigned list;       ///< Which object list the object is in, see gridObjectList.
+	bool insert;
+};
+
+/// Objects in exactly the same place are returned in the order of the object lists, droids, structures then features
+/// of player 0, then of player 1, and so on. The order of a point is the list in the high bits, and the position in
+/// the list in the low bits.
+#define GRID_LIST_DROIDS 0
+#define GRID_LIST_STRUCTURES 1
+#define GRID_LIST_FEATURES 2
+#define GRID_NUM_LISTS (MAX_PLAYERS * 4)
+#define GRID_FIRST_STATIC_RANK 0x80000000u  ///< Objects added to a list later go before this, since they are added to the start of the list.
+
+static GridLayer *gridDroids = nullptr;  ///< Rebuilt every tick, since droids move.
+static GridLayer *gridStatics = nullptr; ///< Only changed when structures or features are added or removed.
+static std::vector<GridStaticChange> gridStaticChanges;
+static uint64_t gridStaticChecksum;     ///< Checksum of the objects in gridStatics.
+static uint32_t gridStaticFirstRank[GRID_NUM_LISTS];  ///< Position in the list given to the object at the start of each list.
+static uint32_t gridGenerationCount = 0; ///< Changed whenever query results may change.
 
 // initialise the grid system
 bool gridInitialise()
 {
-	ASSERT(gridPointTree == nullptr, "gridInitialise already called, without calling gridShutDown.");
-	gridPointTree = new PointTree;
-	gridFiltersUnseen = new PointTree::Filter[MAX_PLAYERS];
-	gridFiltersDroidsByPlayer = new PointTree::Filter[MAX_PLAYERS];
+	ASSERT(gridDroids == nullptr, "gridInitialise already called, without calling gridShutDown.");
+	gridDroids = new GridLayer();
+	gridStatics = new GridLayer();
+	gridStaticChanges.clear();
+	gridStaticChecksum = 0;
 
 	return true;  // Yay, nothing failed!
 }
 
+static unsigned gridObjectList(unsigned player, unsigned type)
+{
+	return player * 4 + type;
+}
+
+static uint64_t gridPointOrder(unsigned list, uint32_t rank)
+{
+	return (uint64_t)list << 32 | rank;
+}
+
+/// The list a structure or feature is in. Features are all in the list of player 0.
+static unsigned gridStaticList(BASE_OBJECT const *psObj)
+{
+	return psObj->type == OBJ_FEATURE ? gridObjectList(0, GRID_LIST_FEATURES) : gridObjectList(psObj->player, GRID_LIST_STRUCTURES);
+}
+
+/// Checksum of a static object, for noticing if the static layer doesn't match the object lists.
+static uint64_t gridStaticHash(BASE_OBJECT const *psObj, Vector2i pos, unsigned list)
+{
+	return ((uint64_t)(uintptr_t)psObj + list) * 0x9E3779B97F4A7C15ULL ^ ((uint64_t)(uint32_t)pos.x << 32 | (uint32_t)pos.y);
+}
+
+void gridAddStaticObject(BASE_OBJECT *psObj)
+{
+	if (gridStatics != nullptr)
+	{
+		gridStaticChanges.push_back(GridStaticChange{psObj, psObj->pos.xy(), gridStaticList(psObj), true});
+	}
+}
+
+void gridRemoveStaticObject(BASE_OBJECT *psObj)
+{
+	if (gridStatics != nullptr)
+	{
+		gridStaticChanges.push_back(GridStaticChange{psObj, psObj->pos.xy(), gridStaticList(psObj), false});
+	}
+}
+
+static void gridInvalidateFilters(GridLayer *layer)
+{
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		layer->filtersUnseenValid[player] = false;
+		layer->filtersDroidsByPlayerValid[player] = false;
+	}
+}
+
 // reset the grid system
 void gridReset()
 {
-	gridPointTree->clear();
+	++gridGenerationCount;
+
+	// Put all existing droids into the droid layer.
+	gridDroids->tree.clear();
+	for (unsigned player = 0; player < MAX_PLAYERS; player++)
+	{
+		uint32_t rank = 0;
+		for (DROID *psDroid = apsDroidLists[player]; psDroid != nullptr; psDroid = psDroid->psNext)
+		{
+			if (!psDroid->died)
+			{
+				gridDroids->tree.insert(psDroid, psDroid->pos.x, psDroid->pos.y, gridPointOrder(gridObjectList(player, GRID_LIST_DROIDS), rank++));
+				for (unsigned char &viewer : psDroid->seenThisTick)
+				{
+					viewer = 0;
+				}
+			}
+		}
+	}
+	gridDroids->tree.sort();
+	gridInvalidateFilters(gridDroids);
+
+	// Apply the structures and features added and removed since the last tick to the static layer, unless there are so
+	// many that rebuilding is quicker. Objects are added to the start of their list, so they go before the rest of it.
+	bool rebuildStatics = gridStaticChanges.size() > 64 + gridStatics->tree.size() / 8;
+	if (!rebuildStatics)
+	{
+		for (GridStaticChange const &change : gridStaticChanges)
+		{
+			bool found = gridStatics->tree.eraseSorted(change.psObj, change.pos.x, change.pos.y);
+			if (change.insert)
+			{
+				uint32_t &rank = gridStaticFirstRank[change.list];
+				rebuildStatics |= rank == 0;
+				gridStatics->tree.insertSorted(change.psObj, change.pos.x, change.pos.y, gridPointOrder(change.list, --rank));
+			}
+			if (found != change.insert)
+			{
+				uint64_t hash = gridStaticHash(change.psObj, change.pos, change.list);
+				gridStaticChecksum += change.insert ? hash : -hash;
+			}
+		}
+	}
+	gridStaticChanges.clear();
 
-	// Put all existing objects into the point tree.
+	// Objects erased from the filters this tick may need to be found again next tick, even if the static layer didn't change.
+	gridInvalidateFilters(gridStatics);
+
+	// Check that the static layer matches the object lists, in case of lists being swapped or loaded without telling us.
+	uint64_t checksum = 0;
+	size_t count = 0;
 	for (unsigned player = 0; player < MAX_PLAYERS; player++)
 	{
-		BASE_OBJECT *start[3] = {(BASE_OBJECT *)apsDroidLists[player], (BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
+		BASE_OBJECT *start[2] = {(BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
 		for (unsigned type = 0; type != sizeof(start) / sizeof(*start); ++type)
 		{
 			for (BASE_OBJECT *psObj = start[type]; psObj != nullptr; psObj = psObj->psNext)
 			{
 				if (!psObj->died)
 				{
-					gridPointTree->insert(psObj, psObj->pos.x, psObj->pos.y);
+					checksum += gridStaticHash(psObj, psObj->pos.xy(), gridObjectList(player, GRID_LIST_STRUCTURES + type));
+					++count;
 					for (unsigned char &viewer : psObj->seenThisTick)
 					{
 						viewer = 0;
@@ -71,25 +199,45 @@ void gridReset()
 			}
 		}
 	}
-
-	gridPointTree->sort();
-
-	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	if (rebuildStatics || count != gridStatics->tree.size() || checksum != gridStaticChecksum)
 	{
-		gridFiltersUnseen[player].reset(*gridPointTree);
-		gridFiltersDroidsByPlayer[player].reset(*gridPointTree);
+		gridStatics->tree.clear();
+		for (unsigned player = 0; player < MAX_PLAYERS; player++)
+		{
+			BASE_OBJECT *start[2] = {(BASE_OBJECT *)apsStructLists[player], (BASE_OBJECT *)apsFeatureLists[player]};
+			for (unsigned type = 0; type != sizeof(start) / sizeof(*start); ++type)
+			{
+				unsigned list = gridObjectList(player, GRID_LIST_STRUCTURES + type);
+				uint32_t rank = GRID_FIRST_STATIC_RANK;
+				gridStaticFirstRank[list] = rank;
+				for (BASE_OBJECT *psObj = start[type]; psObj != nullptr; psObj = psObj->psNext)
+				{
+					if (!psObj->died)
+					{
+						gridStatics->tree.insert(psObj, psObj->pos.x, psObj->pos.y, gridPointOrder(list, rank++));
+					}
+				}
+			}
+		}
+		gridStatics->tree.sort();
+		gridStaticChecksum = checksum;
 	}
 }
 
 // shutdown the grid system
 void gridShutDown()
 {
-	delete gridPointTree;
-	gridPointTree = nullptr;
-	delete[] gridFiltersUnseen;
-	gridFiltersUnseen = nullptr;
-	delete[] gridFiltersDroidsByPlayer;
-	gridFiltersDroidsByPlayer = nullptr;
+	delete gridDroids;
+	gridDroids = nullptr;
+	delete gridStatics;
+	gridStatics = nullptr;
+	gridStaticChanges.clear();
+	++gridGenerationCount;
+}
+
+uint32_t gridGeneration()
+{
+	return gridGenerationCount;
 }
 
 static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
@@ -97,58 +245,129 @@ static bool isInRadius(int32_t x, int32_t y, uint32_t radius)
 	return (uint32_t)(x * x + y * y) <= radius * radius;
 }
 
-// initialise the grid system to start iterating through units that
-// could affect a location (x,y in world coords)
+/// Object found in one layer, and its index in the layer.
+struct GridLayerResult
+{
+	BASE_OBJECT *psObj;
+	unsigned index;
+};
+typedef std::vector<GridLayerResult> GridLayerResults;
+
+/// Buffers for the results of a query, so that queries using different buffers can run on different threads.
+struct GridQuery
+{
+	PointTree::ResultVector results;
+	PointTree::IndexVector indices;
+	GridLayerResults droids, statics;
+	GridList list;
+};
+
+static GridQuery gridQueryMain;                  ///< For queries from the main thread.
+static GridQuery gridQueryUnseen[MAX_PLAYERS];   ///< For gridStartIterateUnseen, which may be called on several threads for different players.
+
+// Finds the objects in one layer that could affect a location (x,y in world coords).
 template<class Condition>
-static GridList const &gridStartIterateFiltered(int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition)
+static void gridIterateLayerFiltered(GridQuery &query, GridLayer *layer, int32_t x, int32_t y, uint32_t radius, PointTree::Filter *filter, Condition const &condition, GridLayerResults &found)
 {
+	PointTree &tree = layer->tree;
+	PointTree::ResultVector const *results;
+	PointTree::IndexVector const *indices;
 	if (filter == nullptr)
 	{
-		gridPointTree->query(x, y, radius);
+		results = &tree.query(x, y, radius);
+		indices = &tree.lastFilteredQueryIndices;
 	}
 	else
 	{
-		gridPointTree->query(*filter, x, y, radius);
+		tree.query(*filter, x, y, radius, query.results, query.indices);
+		results = &query.results;
+		indices = &query.indices;
 	}
-	PointTree::ResultVector::iterator w = gridPointTree->lastQueryResults.begin(), i;
-	for (i = w; i != gridPointTree->lastQueryResults.end(); ++i)
+	found.clear();
+	for (size_t i = 0; i != results->size(); ++i)
 	{
-		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>(*i);
+		BASE_OBJECT *obj = static_cast<BASE_OBJECT *>((*results)[i]);
 		if (!condition.test(obj))  // Check if we should skip this object.
 		{
-			filter->erase(gridPointTree->lastFilteredQueryIndices[i - gridPointTree->lastQueryResults.begin()]);  // Stop the object from appearing in future searches.
+			filter->erase((*indices)[i]);  // Stop the object from appearing in future searches.
 		}
 		else if (isInRadius(obj->pos.x - x, obj->pos.y - y, radius))  // Check that search result is less than radius (since they can be up to a factor of sqrt(2) more).
 		{
-			*w = *i;
-			++w;
+			found.push_back(GridLayerResult{obj, (*indices)[i]});
 		}
 	}
-	gridPointTree->lastQueryResults.erase(w, i);  // Erase all points that were a bit too far.
-	/*
-	// In case you are curious.
-	debug(LOG_WARNING, "gridStartIterateFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)gridPointTree->lastQueryResults.size());
-	*/
-	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
+}
+
+// Merges the objects found in the droid and static layers, in the order they would be in if all objects were in the same layer.
+// If gridPositions isn't null, also gets the position each object has in the grid.
+static void gridMergeLayers(GridLayerResults const &droids, GridLayerResults const &statics, GridList &list, std::vector<Vector2i> *gridPositions = nullptr)
+{
+	list.clear();
+	if (gridPositions != nullptr)
 	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
+		gridPositions->clear();
 	}
-	return gridList;
+	GridLayerResults::const_iterator d = droids.begin(), s = statics.begin();
+	while (d != droids.end() || s != statics.end())
+	{
+		bool isDroid = s == statics.end() || (d != droids.end() && gridDroids->tree.pointBefore(d->index, gridStatics->tree, s->index));
+		GridLayerResult const &result = isDroid ? *d++ : *s++;
+		list.push_back(result.psObj);
+		if (gridPositions != nullptr)
+		{
+			Vector2i pos;
+			(isDroid ? gridDroids : gridStatics)->tree.pointPosition(result.index, &pos.x, &pos.y);
+			gridPositions->push_back(pos);
+		}
+	}
+}
+
+// Returns the filter for the given layer and player, resetting it if not yet used this tick.
+static PointTree::Filter *gridLayerFilter(GridLayer *layer, PointTree::Filter *filters, bool *filtersValid, int player)
+{
+	if (!filtersValid[player])
+	{
+		filters[player].reset(layer->tree);
+		filtersValid[player] = true;
+	}
+	return &filters[player];
 }
 
+// initialise the grid system to start iterating through units that
+// could affect a location (x,y in world coords)
 template<class Condition>
-static GridList const &gridStartIterateFilteredArea(int32_t x, int32_t y, int32_t x2, int32_t y2, Condition const &condition)
+static GridList const &gridStartIterateFiltered(GridQuery &query, int32_t x, int32_t y, uint32_t radius, PointTree::Filter *droidFilter, PointTree::Filter *staticFilter, bool droidsOnly, Condition const &condition)
 {
-	gridPointTree->query(x, y, x2, y2);
+	gridIterateLayerFiltered(query, gridDroids, x, y, radius, droidFilter, condition, query.droids);
+	query.statics.clear();
+	if (!droidsOnly)
+	{
+		gridIterateLayerFiltered(query, gridStatics, x, y, radius, staticFilter, condition, query.statics);
+	}
+	gridMergeLayers(query.droids, query.statics, query.list);
+	/*
+	// In case you are curious.
+	debug(LOG_WARNING, "gridStartIterateFiltered(%d, %d, %u) found %u objects", x, y, radius, (unsigned)query.list.size());
+	*/
+	return query.list;
+}
 
+template<class Condition>
+static GridList const &gridStartIterateFilteredArea(int32_t x, int32_t y, int32_t x2, int32_t y2, Condition const &condition, std::vector<Vector2i> *gridPositions)
+{
 	static GridList gridList;
-	gridList.resize(gridPointTree->lastQueryResults.size());
-	for (unsigned n = 0; n < gridList.size(); ++n)
+	static GridLayerResults droids, statics;
+	for (GridLayer *layer : {gridDroids, gridStatics})
 	{
-		gridList[n] = (BASE_OBJECT *)gridPointTree->lastQueryResults[n];
+		GridLayerResults &found = layer == gridDroids ? droids : statics;
+		found.clear();
+		layer->tree.query(x, y, x2, y2);
+		for (size_t i = 0; i != layer->tree.lastQueryResults.size(); ++i)
+		{
+			found.push_back(GridLayerResult{(BASE_OBJECT *)layer->tree.lastQueryResults[i], layer->tree.lastFilteredQueryIndices[i]});
+		}
 	}
+	gridMergeLayers(droids, statics, gridList, gridPositions);
 	return gridList;
 }
 
@@ -162,12 +381,17 @@ struct ConditionTrue
 
 GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius)
 {
-	return gridStartIterateFiltered(x, y, radius, nullptr, ConditionTrue());
+	return gridStartIterateFiltered(gridQueryMain, x, y, radius, nullptr, nullptr, false, ConditionTrue());
 }
 
 GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
-	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue());
+	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue(), nullptr);
+}
+
+GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2, std::vector<Vector2i> &gridPositions)
+{
+	return gridStartIterateFilteredArea(x, y, x2, y2, ConditionTrue(), &gridPositions);
 }
 
 struct ConditionDroidsByPlayer
@@ -182,7 +406,9 @@ struct ConditionDroidsByPlayer
 
 GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersDroidsByPlayer[player], ConditionDroidsByPlayer(player));
+	// Structures and features are never droids, so only the droid layer is searched.
+	PointTree::Filter *droidFilter = gridLayerFilter(gridDroids, gridDroids->filtersDroidsByPlayer, gridDroids->filtersDroidsByPlayerValid, player);
+	return gridStartIterateFiltered(gridQueryMain, x, y, radius, droidFilter, nullptr, true, ConditionDroidsByPlayer(player));
 }
 
 struct ConditionUnseen
@@ -197,13 +423,7 @@ struct ConditionUnseen
 
 GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player)
 {
-	return gridStartIterateFiltered(x, y, radius, &gridFiltersUnseen[player], ConditionUnseen(player));
-}
-
-BASE_OBJECT **gridIterateDup()
-{
-	size_t bytes = gridPointTree->lastQueryResults.size() * sizeof(void *);
-	BASE_OBJECT **ret = (BASE_OBJECT **)malloc(bytes);
-	memcpy(ret, &gridPointTree->lastQueryResults[0], bytes);
-	return ret;
+	PointTree::Filter *droidFilter = gridLayerFilter(gridDroids, gridDroids->filtersUnseen, gridDroids->filtersUnseenValid, player);
+	PointTree::Filter *staticFilter = gridLayerFilter(gridStatics, gridStatics->filtersUnseen, gridStatics->filtersUnseenValid, player);
+	return gridStartIterateFiltered(gridQueryUnseen[player], x, y, radius, droidFilter, staticFilter, false, ConditionUnseen(player));
 }
@@ -37,17 +37,31 @@ void gridShutDown();
 // Resets seenThisTick[] to false.
 void gridReset();
 
+/// Returns a number which changes whenever the grid is reset or shut down, for telling if cached query results are out of date.
+uint32_t gridGeneration();
+
+/// Call when a structure or feature is added to the object lists. Takes effect on the next gridReset.
+void gridAddStaticObject(BASE_OBJECT *psObj);
+
+/// Call when a structure or feature is removed from the object lists. Takes effect on the next gridReset.
+void gridRemoveStaticObject(BASE_OBJECT *psObj);
+
 /// Find all objects within radius.
 GridList const &gridStartIterate(int32_t x, int32_t y, uint32_t radius);
 
 /// Find all objects within radius.
 GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
 
+/// Find all objects within the area, and where each object was at the last gridReset.
+/// The other queries pick objects by that position, before checking the radius using the current position.
+GridList const &gridStartIterateArea(int32_t x, int32_t y, uint32_t x2, uint32_t y2, std::vector<Vector2i> &gridPositions);
+
 /// Find all objects within radius where object->type == OBJ_DROID && object->player == player.
 GridList const &gridStartIterateDroidsByPlayer(int32_t x, int32_t y, uint32_t radius, int player);
 
 // Used for visibility.
 /// Find all objects within radius where object->seenThisTick[player] != 255.
+/// May be called from several threads at once, with a different player on each thread, as long as the grid isn't modified.
 GridList const &gridStartIterateUnseen(int32_t x, int32_t y, uint32_t radius, int player);
 
 #endif // __INCLUDED_SRC_MAPGRID_H__
@@ -350,6 +350,7 @@ bool missionShutDown()
 			psAuxMap[i] = mission.psAuxMap[i];
 			mission.psAuxMap[i] = nullptr;
 		}
+		++auxMapVersion;
 		std::swap(mission.psGateways, gwGetGateways());
 	}
 
@@ -647,9 +648,7 @@ void missionFlyTransportersIn(SDWORD iPlayer, bool bTrackTransporter)
 			if (psTransporter->psGroup && psTransporter->psGroup->refCount > 1)
 			{
 				// Remove map information from previous map
-				free(psTransporter->watchedTiles);
-				psTransporter->watchedTiles = nullptr;
-				psTransporter->numWatchedTiles = 0;
+				visRemoveVisibilityOffWorld(psTransporter);
 
 				// Remove out of stored list and add to current Droid list
 				if (droidRemove(psTransporter, mission.apsDroidLists))
@@ -883,6 +882,7 @@ void restoreMissionData()
 		psAuxMap[i] = mission.psAuxMap[i];
 		mission.psAuxMap[i] = nullptr;
 	}
+	++auxMapVersion;
 	scrollMinX = mission.scrollMinX;
 	scrollMinY = mission.scrollMinY;
 	scrollMaxX = mission.scrollMaxX;
@@ -1382,6 +1382,7 @@ void swapMissionPointers()
 	{
 		std::swap(psAuxMap[i],   mission.psAuxMap[i]);
 	}
+	++auxMapVersion;
 	//swap gateway zones
 	std::swap(mission.psGateways, gwGetGateways());
 	std::swap(scrollMinX, mission.scrollMinX);
@@ -44,137 +44,15 @@
 #include "mapgrid.h"
 #include "multirecv.h"
 #include "transporter.h"
+#include "droidinfo.h"
 
 #include <vector>
 #include <algorithm>
 
 
-enum SubType
-{
-	ObjOrder, LocOrder, SecondaryOrder
-};
-
-struct QueuedDroidInfo
-{
-	/// Sorts by order, then finally by droid id, to group multiple droids with the same order.
-	bool operator <(QueuedDroidInfo const &z) const
-	{
-		int orComp = orderCompare(z);
-		if (orComp != 0)
-		{
-			return orComp < 0;
-		}
-		return droidId < z.droidId;
-	}
-	/// Returns 0 if order is the same, non-zero otherwise.
-	int orderCompare(QueuedDroidInfo const &z) const
-	{
-		if (player != z.player)
-		{
-			return player < z.player ? -1 : 1;
-		}
-		if (subType != z.subType)
-		{
-			return subType < z.subType ? -1 : 1;
-		}
-		switch (subType)
-		{
-		case ObjOrder:
-		case LocOrder:
-			if (order != z.order)
-			{
-				return order < z.order ? -1 : 1;
-			}
-			if (subType == ObjOrder)
-			{
-				if (destId != z.destId)
-				{
-					return destId < z.destId ? -1 : 1;
-				}
-				if (destType != z.destType)
-				{
-					return destType < z.destType ? -1 : 1;
-				}
-			}
-			else
-			{
-				if (pos.x != z.pos.x)
-				{
-					return pos.x < z.pos.x ? -1 : 1;
-				}
-				if (pos.y != z.pos.y)
-				{
-					return pos.y < z.pos.y ? -1 : 1;
-				}
-			}
-			if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
-			{
-				if (structRef != z.structRef)
-				{
-					return structRef < z.structRef ? -1 : 1;
-				}
-				if (direction != z.direction)
-				{
-					return direction < z.direction ? -1 : 1;
-				}
-			}
-			if (order == DORDER_LINEBUILD)
-			{
-				if (pos2.x != z.pos2.x)
-				{
-					return pos2.x < z.pos2.x ? -1 : 1;
-				}
-				if (pos2.y != z.pos2.y)
-				{
-					return pos2.y < z.pos2.y ? -1 : 1;
-				}
-			}
-			if (order == DORDER_BUILDMODULE)
-			{
-				if (index != z.index)
-				{
-					return index < z.index ? -1 : 1;
-				}
-			}
-			if (add != z.add)
-			{
-				return add < z.add ? -1 : 1;
-			}
-			break;
-		case SecondaryOrder:
-			if (secOrder != z.secOrder)
-			{
-				return secOrder < z.secOrder ? -1 : 1;
-			}
-			if (secState != z.secState)
-			{
-				return secState < z.secState ? -1 : 1;
-			}
-			break;
-		}
-		return 0;
-	}
-
-	uint8_t     player = 0;
-	uint32_t    droidId = 0;
-	SubType     subType = ObjOrder;
-	// subType == ObjOrder || subType == LocOrder
-	DROID_ORDER order = DORDER_NONE;
-	uint32_t    destId = 0;     // if (subType == ObjOrder)
-	OBJECT_TYPE destType = OBJ_DROID;   // if (subType == ObjOrder)
-	Vector2i    pos = Vector2i(0, 0);            // if (subType == LocOrder)
-	uint32_t    y = 0;          // if (subType == LocOrder)
-	uint32_t    structRef = 0;  // if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
-	uint16_t    direction = 0;  // if (order == DORDER_BUILD || order == DORDER_LINEBUILD)
-	uint32_t    index = 0;      // if (order == DORDER_BUILDMODULE)
-	Vector2i    pos2 = Vector2i(0, 0);           // if (order == DORDER_LINEBUILD)
-	bool        add = false;
-	// subType == SecondaryOrder
-	SECONDARY_ORDER secOrder = DSO_UNUSED;
-	SECONDARY_STATE secState = DSS_NONE;
-};
-
 static std::vector<QueuedDroidInfo> queuedOrders;
+static std::vector<QueuedDroidInfo> sentOrderTemplates[MAX_PLAYERS];      ///< Recent orders sent to each game queue, most recent first.
+static std::vector<QueuedDroidInfo> receivedOrderTemplates[MAX_PLAYERS];  ///< Recent orders received from each game queue, most recent first.
 
 
 // ////////////////////////////////////////////////////////////////////////////
@@ -436,7 +314,7 @@ bool recvDroid(NETQUEUE queue)
 	// If we were able to build the droid set it up
 	if (psDroid)
 	{
-		psDroid->id = id;
+		objSetId(psDroid, id);
 		addDroid(psDroid, apsDroidLists);
 
 		if (haveInitialOrders)
@@ -463,84 +341,35 @@ bool recvDroid(NETQUEUE queue)
 }
 
 
-/// Does not read/write info->droidId!
-static void NETQueuedDroidInfo(QueuedDroidInfo *info)
+// Actually send the droid info.
+void sendQueuedDroidInfo()
 {
-	NETuint8_t(&info->player);
-	NETenum(&info->subType);
-	switch (info->subType)
+	if (queuedOrders.empty())
 	{
-	case ObjOrder:
-	case LocOrder:
-		NETenum(&info->order);
-		if (info->subType == ObjOrder)
-		{
-			NETuint32_t(&info->destId);
-			NETenum(&info->destType);
-		}
-		else
-		{
-			NETauto(&info->pos);
-		}
-		if (info->order == DORDER_BUILD || info->order == DORDER_LINEBUILD)
-		{
-			NETuint32_t(&info->structRef);
-			NETuint16_t(&info->direction);
-		}
-		if (info->order == DORDER_LINEBUILD)
-		{
-			NETauto(&info->pos2);
-		}
-		if (info->order == DORDER_BUILDMODULE)
-		{
-			NETauto(&info->index);
-		}
-		NETbool(&info->add);
-		break;
-	case SecondaryOrder:
-		NETenum(&info->secOrder);
-		NETenum(&info->secState);
-		break;
+		return;  // Nothing to send.
 	}
-}
 
-// Actually send the droid info.
-void sendQueuedDroidInfo()
-{
 	// Sort queued orders, to group the same order to multiple droids.
 	std::sort(queuedOrders.begin(), queuedOrders.end());
 
-	std::vector<QueuedDroidInfo>::iterator eqBegin, eqEnd;
-	for (eqBegin = queuedOrders.begin(); eqBegin != queuedOrders.end(); eqBegin = eqEnd)
-	{
-		// Find end of range of orders which differ only by the droid ID.
-		for (eqEnd = eqBegin + 1; eqEnd != queuedOrders.end() && eqEnd->orderCompare(*eqBegin) == 0; ++eqEnd)
-		{}
-
-		NETbeginEncode(NETgameQueue(selectedPlayer), GAME_DROIDINFO);
-		NETQueuedDroidInfo(&*eqBegin);
-
-		uint32_t num = eqEnd - eqBegin;
-		NETuint32_t(&num);
-
-		uint32_t prevDroidId = 0;
-		for (unsigned n = 0; n < num; ++n)
-		{
-			uint32_t droidId = (eqBegin + n)->droidId;
-
-			// Encode deltas between droid IDs, since the deltas are smaller than the actual droid IDs, and will encode to less bytes on average.
-			uint32_t deltaDroidId = droidId - prevDroidId;
-			NETuint32_t(&deltaDroidId);
-
-			prevDroidId = droidId;
-		}
-		NETend();
-	}
+	NETbeginEncode(NETgameQueue(selectedPlayer), GAME_DROIDINFO);
+	NETencodeDroidInfo(queuedOrders, sentOrderTemplates[selectedPlayer]);
+	NETend();
 
 	// Sent the orders. Don't send them again.
 	queuedOrders.clear();
 }
 
+void resetQueuedDroidInfo()
+{
+	queuedOrders.clear();
+	for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+	{
+		sentOrderTemplates[player].clear();
+		receivedOrderTemplates[player].clear();
+	}
+}
+
 DROID_ORDER_DATA infoToOrderData(QueuedDroidInfo const &info, STRUCTURE_STATS const *psStats)
 {
 	DROID_ORDER_DATA sOrder;
@@ -611,14 +440,83 @@ void sendDroidInfo(DROID *psDroid, DroidOrder const &order, bool add)
 	orderDroidAddPending(psDroid, &sOrder);
 }
 
+/// Gives the order received from queue to one droid.
+static void recvDroidInfoDroid(NETQUEUE queue, QueuedDroidInfo const &info, DROID_ORDER_DATA *sOrder)
+{
+	DROID *psDroid = IdToDroid(info.droidId, info.player);
+	if (!psDroid)
+	{
+		debug(LOG_NEVER, "Packet from %d refers to non-existent droid %u, [%s : p%d]",
+		      queue.index, info.droidId, isHumanPlayer(info.player) ? "Human" : "AI", info.player);
+		syncDebug("Droid %d missing", info.droidId);
+		return;  // Can't find the droid, so skip this droid.
+	}
+	if (!canGiveOrdersFor(queue.index, psDroid->player))
+	{
+		debug(LOG_WARNING, "Droid order (by %d) for wrong player (%d).", queue.index, psDroid->player);
+		syncDebug("Wrong player.");
+		return;
+	}
+
+	CHECK_DROID(psDroid);
+
+	syncDebugDroid(psDroid, '<');
+
+	switch (info.subType)
+	{
+	case ObjOrder:
+	case LocOrder:
+		/*
+		* If the current order not is a command order and we are not a
+		* commander yet are in the commander group remove us from it.
+		*/
+		if (hasCommander(psDroid))
+		{
+			psDroid->psGroup->remove(psDroid);
+		}
+
+		if (sOrder->psObj != TargetMissing)  // Only do order if the target didn't die.
+		{
+			if (!info.add)
+			{
+				orderDroidListEraseRange(psDroid, 0, psDroid->listSize + 1);  // Clear all non-pending orders, plus the first pending order (which is probably the order we just received).
+				orderDroidBase(psDroid, sOrder);  // Execute the order immediately (even if in the middle of another order.
+			}
+			else
+			{
+				orderDroidAdd(psDroid, sOrder);   // Add the order to the (non-pending) list. Will probably overwrite the corresponding pending order, assuming all pending orders were written to the list.
+			}
+		}
+		break;
+	case SecondaryOrder:
+		// Set the droids secondary order
+		turnOffMultiMsg(true);
+		secondarySetState(psDroid, info.secOrder, info.secState);
+		turnOffMultiMsg(false);
+		break;
+	}
+
+	syncDebugDroid(psDroid, '>');
+
+	CHECK_DROID(psDroid);
+}
+
 // ////////////////////////////////////////////////////////////////////////////
 // receive droid information form other players.
 bool recvDroidInfo(NETQUEUE queue)
 {
+	std::vector<DroidInfoOrder> orders;
 	NETbeginDecode(queue, GAME_DROIDINFO);
+	bool valid = NETdecodeDroidInfo(orders, receivedOrderTemplates[queue.index]);
+	if (!NETend() || !valid)
 	{
-		QueuedDroidInfo info;
-		NETQueuedDroidInfo(&info);
+		debug(LOG_ERROR, "Bad droid orders from %d.", queue.index);
+		return false;
+	}
+
+	for (DroidInfoOrder &order : orders)
+	{
+		QueuedDroidInfo &info = order.info;
 
 		STRUCTURE_STATS *psStats = nullptr;
 		if (info.subType == LocOrder && (info.order == DORDER_BUILD || info.order == DORDER_LINEBUILD))
@@ -643,75 +541,15 @@ bool recvDroidInfo(NETQUEUE queue)
 
 		DROID_ORDER_DATA sOrder = infoToOrderData(info, psStats);
 
-		uint32_t num = 0;
-		NETuint32_t(&num);
-
-		for (unsigned n = 0; n < num; ++n)
+		for (DroidIdRun const &run : order.runs)
 		{
-			// Get the next droid ID which is being given this order.
-			uint32_t deltaDroidId = 0;
-			NETuint32_t(&deltaDroidId);
-			info.droidId += deltaDroidId;
-
-			DROID *psDroid = IdToDroid(info.droidId, info.player);
-			if (!psDroid)
-			{
-				debug(LOG_NEVER, "Packet from %d refers to non-existent droid %u, [%s : p%d]",
-				      queue.index, info.droidId, isHumanPlayer(info.player) ? "Human" : "AI", info.player);
-				syncDebug("Droid %d missing", info.droidId);
-				continue;  // Can't find the droid, so skip this droid.
-			}
-			if (!canGiveOrdersFor(queue.index, psDroid->player))
+			for (uint32_t n = 0; n < run.count; ++n)
 			{
-				debug(LOG_WARNING, "Droid order (by %d) for wrong player (%d).", queue.index, psDroid->player);
-				syncDebug("Wrong player.");
-				continue;
-			}
-
-			CHECK_DROID(psDroid);
-
-			syncDebugDroid(psDroid, '<');
-
-			switch (info.subType)
-			{
-			case ObjOrder:
-			case LocOrder:
-				/*
-				* If the current order not is a command order and we are not a
-				* commander yet are in the commander group remove us from it.
-				*/
-				if (hasCommander(psDroid))
-				{
-					psDroid->psGroup->remove(psDroid);
-				}
-
-				if (sOrder.psObj != TargetMissing)  // Only do order if the target didn't die.
-				{
-					if (!info.add)
-					{
-						orderDroidListEraseRange(psDroid, 0, psDroid->listSize + 1);  // Clear all non-pending orders, plus the first pending order (which is probably the order we just received).
-						orderDroidBase(psDroid, &sOrder);  // Execute the order immediately (even if in the middle of another order.
-					}
-					else
-					{
-						orderDroidAdd(psDroid, &sOrder);   // Add the order to the (non-pending) list. Will probably overwrite the corresponding pending order, assuming all pending orders were written to the list.
-					}
-				}
-				break;
-			case SecondaryOrder:
-				// Set the droids secondary order
-				turnOffMultiMsg(true);
-				secondarySetState(psDroid, info.secOrder, info.secState);
-				turnOffMultiMsg(false);
-				break;
+				info.droidId = run.firstId + 2 * n;
+				recvDroidInfoDroid(queue, info, &sOrder);
 			}
-
-			syncDebugDroid(psDroid, '>');
-
-			CHECK_DROID(psDroid);
 		}
 	}
-	NETend();
 
 	return true;
 }
@@ -307,86 +307,37 @@ bool multiPlayerLoop()
 // to get droids ...
 DROID *IdToDroid(UDWORD id, UDWORD player)
 {
-	if (player == ANYPLAYER)
+	if (player != ANYPLAYER && player >= MAX_PLAYERS)
 	{
-		for (int i = 0; i < MAX_PLAYERS; i++)
-		{
-			for (DROID *d = apsDroidLists[i]; d; d = d->psNext)
-			{
-				if (d->id == id)
-				{
-					return d;
-				}
-			}
-		}
-	}
-	else if (player < MAX_PLAYERS)
-	{
-		for (DROID *d = apsDroidLists[player]; d; d = d->psNext)
-		{
-			if (d->id == id)
-			{
-				return d;
-			}
-		}
+		return nullptr;
 	}
-	return nullptr;
+	return (DROID *)objFindById(id, player, OBJ_ID_DROIDS);
 }
 
 // find off-world droids
 DROID *IdToMissionDroid(UDWORD id, UDWORD player)
 {
-	if (player == ANYPLAYER)
+	if (player != ANYPLAYER && player >= MAX_PLAYERS)
 	{
-		for (int i = 0; i < MAX_PLAYERS; i++)
-		{
-			for (DROID *d = mission.apsDroidLists[i]; d; d = d->psNext)
-			{
-				if (d->id == id)
-				{
-					return d;
-				}
-			}
-		}
-	}
-	else if (player < MAX_PLAYERS)
-	{
-		for (DROID *d = mission.apsDroidLists[player]; d; d = d->psNext)
-		{
-			if (d->id == id)
-			{
-				return d;
-			}
-		}
+		return nullptr;
 	}
-	return nullptr;
+	return (DROID *)objFindById(id, player, OBJ_ID_MISSION_DROIDS);
 }
 
 // ////////////////////////////////////////////////////////////////////////////
 // find a structure
 STRUCTURE *IdToStruct(UDWORD id, UDWORD player)
 {
-	int beginPlayer = 0, endPlayer = MAX_PLAYERS;
-	if (player != ANYPLAYER)
+	if (player != ANYPLAYER && player >= MAX_PLAYERS)
 	{
-		beginPlayer = player;
-		endPlayer = std::min<int>(player + 1, MAX_PLAYERS);
+		return nullptr;
 	}
-	STRUCTURE **lists[2] = {apsStructLists, mission.apsStructLists};
-	for (int j = 0; j < 2; ++j)
+	STRUCTURE *psStruct = (STRUCTURE *)objFindById(id, player, OBJ_ID_STRUCTURES);
+	if (psStruct == nullptr)
 	{
-		for (int i = beginPlayer; i < endPlayer; ++i)
-		{
-			for (STRUCTURE *d = lists[j][i]; d; d = d->psNext)
-			{
-				if (d->id == id)
-				{
-					return d;
-				}
-			}
-		}
+		psStruct = (STRUCTURE *)objFindById(id, player, OBJ_ID_MISSION_STRUCTS);
 	}
-	return nullptr;
+	return psStruct;
 }
 
 // ////////////////////////////////////////////////////////////////////////////
@@ -394,14 +345,7 @@ STRUCTURE *IdToStruct(UDWORD id, UDWORD player)
 FEATURE *IdToFeature(UDWORD id, UDWORD player)
 {
 	(void)player;	// unused, all features go into player 0
-	for (FEATURE *d = apsFeatureLists[0]; d; d = d->psNext)
-	{
-		if (d->id == id)
-		{
-			return d;
-		}
-	}
-	return nullptr;
+	return (FEATURE *)objFindById(id, 0, OBJ_ID_FEATURES);
 }
 
 // ////////////////////////////////////////////////////////////////////////////
@@ -178,6 +178,7 @@ void sendStructureInfo(STRUCTURE *psStruct, STRUCTURE_INFO structureInfo, DROID_
 bool SendDroid(DROID_TEMPLATE *pTemplate, uint32_t x, uint32_t y, uint8_t player, uint32_t id, const INITIAL_DROID_ORDERS *initialOrders);
 bool SendDestroyDroid(const DROID *psDroid);
 void sendQueuedDroidInfo();  ///< Actually sends the droid orders which were queued by SendDroidInfo.
+void resetQueuedDroidInfo();  ///< Forgets the queued droid orders, and the recent orders which later orders can refer to. Call when resetting the game queues.
 void sendDroidInfo(DROID *psDroid, DroidOrder const &order, bool add);
 bool SendCmdGroup(DROID_GROUP *psGroup, UWORD x, UWORD y, BASE_OBJECT *psObj);
 
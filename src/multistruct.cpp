@@ -128,7 +128,7 @@ bool recvBuildFinished(NETQUEUE queue)
 		if (asStructureStats[typeindex].type == psStruct->pStructureType->type)
 		{
 			// Correct type, correct location, just rename the id's to sync it.. (urgh)
-			psStruct->id = structId;
+			objSetId(psStruct, structId);
 			psStruct->status = SS_BUILT;
 			buildingComplete(psStruct);
 			debug(LOG_SYNC, "Created modified building %u for player %u", psStruct->id, player);
@@ -143,7 +143,7 @@ bool recvBuildFinished(NETQUEUE queue)
 
 	if (psStruct)
 	{
-		psStruct->id		= structId;
+		objSetId(psStruct, structId);
 		psStruct->status	= SS_BUILT;
 		buildingComplete(psStruct);
 		debug(LOG_SYNC, "Huge synch error, forced to create building %u for player %u", psStruct->id, player);
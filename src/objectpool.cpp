@@ -0,0 +1,126 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 1999-2004  Eidos Interactive
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file objectpool.cpp
+ *
+ * Pooled allocation of droids, structures, features and projectiles.
+ *
+ */
+
+#include <stdlib.h>
+#include <algorithm>
+#include <new>
+
+#include "lib/framework/frame.h"
+
+#include "objectpool.h"
+
+/// Slots are aligned like malloc would align them.
+#define OBJECT_POOL_ALIGNMENT 16
+
+/// All pools which exist, for objectPoolStatistics. A function, since pools are static objects in several files.
+static std::vector<ObjectPool *> &objectPools()
+{
+	static std::vector<ObjectPool *> pools;
+	return pools;
+}
+
+ObjectPool::ObjectPool(char const *name_, size_t size)
+	: name(name_)
+	, slotSize((std::max(size, sizeof(FreeSlot)) + OBJECT_POOL_ALIGNMENT - 1) / OBJECT_POOL_ALIGNMENT * OBJECT_POOL_ALIGNMENT)
+{
+	objectPools().push_back(this);
+}
+
+ObjectPool::~ObjectPool()
+{
+	std::vector<ObjectPool *> &pools = objectPools();
+	pools.erase(std::remove(pools.begin(), pools.end(), this), pools.end());
+	if (allocations != frees)
+	{
+		return;  // Objects are still using the memory, so don't free it, in case they get deleted during shutdown.
+	}
+	for (void *chunk : chunks)
+	{
+		free(chunk);
+	}
+}
+
+void *ObjectPool::allocate(size_t size)
+{
+	if (size > slotSize)
+	{
+		ASSERT(false, "%s pool: object of size %u doesn't fit in %u bytes", name, (unsigned)size, (unsigned)slotSize);
+		throw std::bad_alloc();
+	}
+	if (freeSlots == nullptr)
+	{
+		char *chunk = (char *)malloc(slotSize * OBJECT_POOL_CHUNK_SLOTS);
+		if (chunk == nullptr)
+		{
+			throw std::bad_alloc();
+		}
+		chunks.push_back(chunk);
+		// Link the slots so that they get used in order.
+		for (int i = OBJECT_POOL_CHUNK_SLOTS - 1; i >= 0; --i)
+		{
+			FreeSlot *slot = (FreeSlot *)(chunk + i * slotSize);
+			slot->next = freeSlots;
+			freeSlots = slot;
+		}
+	}
+	FreeSlot *slot = freeSlots;
+	freeSlots = slot->next;
+	++allocations;
+	return slot;
+}
+
+void ObjectPool::release(void *ptr)
+{
+	if (ptr == nullptr)
+	{
+		return;
+	}
+	FreeSlot *slot = (FreeSlot *)ptr;
+	slot->next = freeSlots;
+	freeSlots = slot;
+	++frees;
+}
+
+ObjectPoolStatistics ObjectPool::statistics() const
+{
+	ObjectPoolStatistics stats;
+	stats.name = name;
+	stats.allocations = allocations;
+	stats.frees = frees;
+	stats.live = allocations - frees;
+	stats.slots = chunks.size() * OBJECT_POOL_CHUNK_SLOTS;
+	return stats;
+}
+
+std::vector<ObjectPoolStatistics> objectPoolStatistics()
+{
+	std::vector<ObjectPoolStatistics> stats;
+	for (ObjectPool const *pool : objectPools())
+	{
+		stats.push_back(pool->statistics());
+	}
+	return stats;
+}
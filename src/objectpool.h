@@ -0,0 +1,81 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 1999-2004  Eidos Interactive
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Pools for allocating game objects which are created and destroyed all the time.
+ */
+
+#ifndef __INCLUDED_SRC_OBJECTPOOL_H__
+#define __INCLUDED_SRC_OBJECTPOOL_H__
+
+#include <stddef.h>
+#include <vector>
+
+/// Number of objects allocated at once when a pool runs out of free slots.
+#define OBJECT_POOL_CHUNK_SLOTS 256
+
+/// Allocation counters of an ObjectPool.
+struct ObjectPoolStatistics
+{
+	char const *name;      ///< What the pool allocates
+	size_t allocations;    ///< Number of objects allocated since the game started
+	size_t frees;          ///< Number of objects freed since the game started
+	size_t live;           ///< Number of objects currently allocated
+	size_t slots;          ///< Number of objects which fit in the pool without allocating more memory
+};
+
+/** Allocates objects of a single size from chunks of slots, and reuses the slots of freed objects, so that objects don't move,
+ *  and creating and destroying thousands of objects doesn't fragment the heap. Memory is never returned to the heap while
+ *  the pool is in use.
+ *
+ *  Objects are only freed once they have been on the destroyed list long enough for nothing to refer to them, so a slot is
+ *  never reused while a stale pointer might still look at the old object. Not thread-safe, use from main thread only.
+ */
+class ObjectPool
+{
+public:
+	ObjectPool(char const *name, size_t size);
+	~ObjectPool();
+
+	void *allocate(size_t size);
+	void release(void *ptr);
+
+	ObjectPoolStatistics statistics() const;
+
+private:
+	ObjectPool(ObjectPool const &) = delete;
+	ObjectPool &operator =(ObjectPool const &) = delete;
+
+	struct FreeSlot
+	{
+		FreeSlot *next;
+	};
+
+	char const *name;
+	size_t slotSize;
+	FreeSlot *freeSlots = nullptr;
+	std::vector<void *> chunks;
+	size_t allocations = 0;
+	size_t frees = 0;
+};
+
+/// Returns the counters of all object pools.
+std::vector<ObjectPoolStatistics> objectPoolStatistics();
+
+#endif // __INCLUDED_SRC_OBJECTPOOL_H__
@@ -24,6 +24,7 @@
  *
  */
 #include <string.h>
+#include <unordered_map>
 
 #include "lib/framework/frame.h"
 #include "objects.h"
@@ -74,6 +75,181 @@ BASE_OBJECT		*psDestroyedObj = nullptr;
 static void objListIntegCheck();
 #endif
 
+/// The list an object in the ID index is in, a bit from OBJ_ID_LISTS.
+struct ObjIdIndexEntry
+{
+	BASE_OBJECT *psObj;
+	uint8_t list;
+	uint8_t player;
+};
+
+#define OBJ_ID_LIST_COUNT 7
+
+/// Index of all objects in the lists in OBJ_ID_LISTS, by id.
+static std::unordered_multimap<uint32_t, ObjIdIndexEntry> objIdIndex;
+/// The list heads when objIdIndex was last updated. Since lists are sometimes moved around by assigning the heads directly, any
+/// difference means that the index must be rebuilt. Only compared, never dereferenced, since the objects may have been freed.
+static BASE_OBJECT *objIdIndexHeads[OBJ_ID_LIST_COUNT][MAX_PLAYERS];
+static bool objIdIndexValid = false;
+
+/// Returns the index of the given list into objIdIndexHeads, or -1 if the list is not indexed.
+static int objIdListIndex(void const *list)
+{
+	void const *lists[OBJ_ID_LIST_COUNT] = {apsDroidLists, apsStructLists, apsFeatureLists, mission.apsDroidLists, mission.apsStructLists, mission.apsFeatureLists, apsLimboDroids};
+	for (int i = 0; i < OBJ_ID_LIST_COUNT; ++i)
+	{
+		if (list == lists[i])
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+static BASE_OBJECT *objIdListHead(int list, unsigned player)
+{
+	switch (list)
+	{
+	case 0: return apsDroidLists[player];
+	case 1: return apsStructLists[player];
+	case 2: return apsFeatureLists[player];
+	case 3: return mission.apsDroidLists[player];
+	case 4: return mission.apsStructLists[player];
+	case 5: return mission.apsFeatureLists[player];
+	case 6: return apsLimboDroids[player];
+	}
+	return nullptr;
+}
+
+/// Rebuilds objIdIndex, if any list was changed without updating it.
+static void objIdIndexUpdate()
+{
+	for (int list = 0; list < OBJ_ID_LIST_COUNT && objIdIndexValid; ++list)
+	{
+		for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+		{
+			if (objIdIndexHeads[list][player] != objIdListHead(list, player))
+			{
+				objIdIndexValid = false;
+				break;
+			}
+		}
+	}
+	if (objIdIndexValid)
+	{
+		return;
+	}
+
+	objIdIndex.clear();
+	for (int list = 0; list < OBJ_ID_LIST_COUNT; ++list)
+	{
+		for (unsigned player = 0; player < MAX_PLAYERS; ++player)
+		{
+			objIdIndexHeads[list][player] = objIdListHead(list, player);
+			for (BASE_OBJECT *psObj = objIdIndexHeads[list][player]; psObj != nullptr; psObj = psObj->psNext)
+			{
+				objIdIndex.emplace(psObj->id, ObjIdIndexEntry{psObj, uint8_t(1 << list), uint8_t(player)});
+			}
+		}
+	}
+	objIdIndexValid = true;
+}
+
+/// Updates objIdIndex after adding or removing an object from a list, unless the list was already changed without updating the index.
+static void objIdIndexChanged(void const *listArray, unsigned player, BASE_OBJECT *oldHead, BASE_OBJECT *newHead, BASE_OBJECT *psObj, bool added)
+{
+	int list = objIdListIndex(listArray);
+	if (!objIdIndexValid || list < 0 || player >= MAX_PLAYERS)
+	{
+		return;  // Not indexed, or will be rebuilt anyway.
+	}
+	if (objIdIndexHeads[list][player] != oldHead)
+	{
+		objIdIndexValid = false;
+		return;
+	}
+	objIdIndexHeads[list][player] = newHead;
+
+	if (added)
+	{
+		objIdIndex.emplace(psObj->id, ObjIdIndexEntry{psObj, uint8_t(1 << list), uint8_t(player)});
+		return;
+	}
+	auto range = objIdIndex.equal_range(psObj->id);
+	for (auto i = range.first; i != range.second; ++i)
+	{
+		if (i->second.psObj == psObj && i->second.list == 1 << list)
+		{
+			objIdIndex.erase(i);
+			return;
+		}
+	}
+	objIdIndexValid = false;  // Not found, id must have changed.
+}
+
+void objSetId(BASE_OBJECT *psObj, uint32_t id)
+{
+	auto range = objIdIndex.equal_range(psObj->id);
+	for (auto i = range.first; i != range.second; ++i)
+	{
+		if (i->second.psObj == psObj)
+		{
+			ObjIdIndexEntry entry = i->second;
+			objIdIndex.erase(i);
+			objIdIndex.emplace(id, entry);
+			break;
+		}
+	}
+	psObj->id = id;
+}
+
+/// Returns true if a comes before b when searching the lists in order, then the players in order, then each list from its head.
+/// Objects sharing an id are rare, but the order of the entries in objIdIndex may differ between clients, so it must not decide which one is found.
+static bool objIdIndexBefore(ObjIdIndexEntry const &a, ObjIdIndexEntry const &b)
+{
+	if (a.list != b.list)
+	{
+		return a.list < b.list;
+	}
+	if (a.player != b.player)
+	{
+		return a.player < b.player;
+	}
+	int list = 0;
+	while ((1 << list) != a.list)
+	{
+		++list;
+	}
+	for (BASE_OBJECT *psObj = objIdListHead(list, a.player); psObj != nullptr; psObj = psObj->psNext)
+	{
+		if (psObj == a.psObj || psObj == b.psObj)
+		{
+			return psObj == a.psObj;
+		}
+	}
+	return false;
+}
+
+BASE_OBJECT *objFindById(uint32_t id, unsigned player, unsigned lists)
+{
+	objIdIndexUpdate();
+	ObjIdIndexEntry const *found = nullptr;
+	auto range = objIdIndex.equal_range(id);
+	for (auto i = range.first; i != range.second; ++i)
+	{
+		if ((i->second.list & lists) != 0 && (player >= MAX_PLAYERS || i->second.player == player) && (found == nullptr || objIdIndexBefore(i->second, *found)))
+		{
+			found = &i->second;
+		}
+	}
+	if (found == nullptr)
+	{
+		return nullptr;
+	}
+	ASSERT(found->psObj->id == id, "Object id changed from %u to %u without calling objSetId()", id, found->psObj->id);
+	return found->psObj;
+}
+
 
 /* Initialise the object heaps */
 bool objmemInitialise()
@@ -254,8 +430,10 @@ static inline void addObjectToList(OBJECT *list[], OBJECT *object, int player)
 	ASSERT_OR_RETURN(, object != nullptr, "Invalid pointer");
 
 	// Prepend the object to the top of the list
+	BASE_OBJECT *oldHead = list[player];
 	object->psNext = list[player];
 	list[player] = object;
+	objIdIndexChanged(list, player, oldHead, list[player], object, true);
 }
 
 /* Add the object to its list
@@ -286,6 +464,7 @@ static inline void destroyObject(OBJECT *list[], OBJECT *object)
 	if (list[object->player] == object)
 	{
 		list[object->player] = list[object->player]->psNext;
+		objIdIndexChanged(list, object->player, object, list[object->player], object, false);
 		object->psNext = psDestroyedObj;
 		psDestroyedObj = (BASE_OBJECT *)object;
 		object->died = gameTime;
@@ -307,6 +486,7 @@ static inline void destroyObject(OBJECT *list[], OBJECT *object)
 		// Modify the "next" pointer of the previous item to
 		// point to the "next" item of the item to delete.
 		psPrev->psNext = psCurr->psNext;
+		objIdIndexChanged(list, object->player, list[object->player], list[object->player], object, false);
 
 		// Prepend the object to the destruction list
 		object->psNext = psDestroyedObj;
@@ -332,6 +512,7 @@ static inline void removeObjectFromList(OBJECT *list[], OBJECT *object, int play
 	if (list[player] == object)
 	{
 		list[player] = list[player]->psNext;
+		objIdIndexChanged(list, player, object, list[player], object, false);
 		return;
 	}
 
@@ -347,6 +528,7 @@ static inline void removeObjectFromList(OBJECT *list[], OBJECT *object, int play
 	// Modify the "next" pointer of the previous item to
 	// point to the "next" item of the item to delete.
 	psPrev->psNext = psCurr->psNext;
+	objIdIndexChanged(list, player, list[player], list[player], object, false);
 }
 
 /* Remove an object from the relevant function list. An object can only be in one function list at a time!
@@ -520,6 +702,7 @@ void freeAllLimboDroids()
 void addStructure(STRUCTURE *psStructToAdd)
 {
 	addObjectToList(apsStructLists, psStructToAdd, psStructToAdd->player);
+	gridAddStaticObject(psStructToAdd);
 	if (psStructToAdd->pStructureType->pSensor
 	    && psStructToAdd->pStructureType->pSensor->location == LOC_TURRET)
 	{
@@ -588,6 +771,7 @@ void killStruct(STRUCTURE *psBuilding)
 		}
 	}
 
+	gridRemoveStaticObject(psBuilding);
 	destroyObject(apsStructLists, psBuilding);
 }
 
@@ -605,6 +789,10 @@ void removeStructureFromList(STRUCTURE *psStructToRemove, STRUCTURE *pList[MAX_P
 	ASSERT(psStructToRemove->player < MAX_PLAYERS,
 	       "removeStructureFromList: invalid player for structure");
 	removeObjectFromList(pList, psStructToRemove, psStructToRemove->player);
+	if (pList == apsStructLists)
+	{
+		gridRemoveStaticObject(psStructToRemove);
+	}
 	if (psStructToRemove->pStructureType->pSensor
 	    && psStructToRemove->pStructureType->pSensor->location == LOC_TURRET)
 	{
@@ -622,6 +810,7 @@ void removeStructureFromList(STRUCTURE *psStructToRemove, STRUCTURE *pList[MAX_P
 void addFeature(FEATURE *psFeatureToAdd)
 {
 	addObjectToList(apsFeatureLists, psFeatureToAdd, 0);
+	gridAddStaticObject(psFeatureToAdd);
 	if (psFeatureToAdd->psStats->subType == FEAT_OIL_RESOURCE)
 	{
 		addObjectToFuncList(apsOilList, psFeatureToAdd, 0);
@@ -636,6 +825,7 @@ void killFeature(FEATURE *psDel)
 	ASSERT(psDel->type == OBJ_FEATURE,
 	       "killFeature: pointer is not a feature");
 	psDel->player = 0;
+	gridRemoveStaticObject(psDel);
 	destroyObject(apsFeatureLists, psDel);
 
 	if (psDel->psStats->subType == FEAT_OIL_RESOURCE)
@@ -768,153 +958,82 @@ void checkFactoryFlags()
 
 /**************************  OBJECT ACCESS FUNCTIONALITY ********************************/
 
-// Find a base object from it's id
-BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+/// Finds a droid with the given id inside a transporter in the given list.
+static DROID *findTransportedDroidById(DROID *psList, unsigned id)
 {
-	BASE_OBJECT		*psObj;
-	DROID			*psTrans;
-
-	for (int i = 0; i < 3; ++i)
+	for (DROID *psDroid = psList; psDroid != nullptr; psDroid = psDroid->psNext)
 	{
-		psObj = nullptr;
-		switch (i)
+		// if transporter check any droids in the grp
+		if (isTransporter(psDroid))
 		{
-		case 0:
-			switch (type)
+			for (DROID *psTrans = psDroid->psGroup->psList; psTrans != nullptr; psTrans = psTrans->psGrpNext)
 			{
-			case OBJ_DROID: psObj = apsDroidLists[player]; break;
-			case OBJ_STRUCTURE: psObj = apsStructLists[player]; break;
-			case OBJ_FEATURE: psObj = apsFeatureLists[0];
-			default: break;
-			}
-			break;
-		case 1:
-			switch (type)
-			{
-			case OBJ_DROID: psObj = mission.apsDroidLists[player]; break;
-			case OBJ_STRUCTURE: psObj = mission.apsStructLists[player]; break;
-			case OBJ_FEATURE: psObj = mission.apsFeatureLists[0]; break;
-			default: break;
-			}
-			break;
-		case 2:
-			if (player == 0 && type == OBJ_DROID)
-			{
-				psObj = apsLimboDroids[0];
+				if (psTrans->id == id)
+				{
+					return psTrans;
+				}
 			}
-			break;
 		}
+	}
+	return nullptr;
+}
 
-		while (psObj)
+// Find a base object from it's id
+BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type)
+{
+	BASE_OBJECT *psObj = nullptr;
+	switch (type)
+	{
+	case OBJ_DROID:
+		psObj = objFindById(id, player, OBJ_ID_DROIDS | OBJ_ID_MISSION_DROIDS | (player == 0 ? OBJ_ID_LIMBO_DROIDS : 0));
+		if (psObj == nullptr && player < MAX_PLAYERS)
 		{
-			if (psObj->id == id)
-			{
-				return psObj;
-			}
-			// if transporter check any droids in the grp
-			if ((psObj->type == OBJ_DROID) && isTransporter((DROID *)psObj))
-			{
-				for (psTrans = ((DROID *)psObj)->psGroup->psList; psTrans != nullptr; psTrans = psTrans->psGrpNext)
-				{
-					if (psTrans->id == id)
-					{
-						return (BASE_OBJECT *)psTrans;
-					}
-				}
-			}
-			psObj = psObj->psNext;
+			psObj = findTransportedDroidById(apsDroidLists[player], id);
+		}
+		if (psObj == nullptr && player < MAX_PLAYERS)
+		{
+			psObj = findTransportedDroidById(mission.apsDroidLists[player], id);
+		}
+		if (psObj == nullptr && player == 0)
+		{
+			psObj = findTransportedDroidById(apsLimboDroids[0], id);
 		}
+		break;
+	case OBJ_STRUCTURE:
+		psObj = objFindById(id, player, OBJ_ID_STRUCTURES | OBJ_ID_MISSION_STRUCTS);
+		break;
+	case OBJ_FEATURE:
+		psObj = objFindById(id, 0, OBJ_ID_FEATURES | OBJ_ID_MISSION_FEATURES);
+		break;
+	default:
+		break;
 	}
-	ASSERT(false, "failed to find id %d for player %d", id, player);
+	ASSERT(psObj != nullptr, "failed to find id %d for player %d", id, player);
 
-	return nullptr;
+	return psObj;
 }
 
 // Find a base object from it's id
 BASE_OBJECT *getBaseObjFromId(UDWORD id)
 {
-	unsigned int i;
-	UDWORD			player;
-	BASE_OBJECT		*psObj;
-	DROID			*psTrans;
+	BASE_OBJECT *psObj = objFindById(id, MAX_PLAYERS, OBJ_ID_ALL);
 
-	for (i = 0; i < 7; ++i)
+	// Not in any list, so might be inside a transporter.
+	for (unsigned player = 0; player < MAX_PLAYERS && psObj == nullptr; ++player)
 	{
-		for (player = 0; player < MAX_PLAYERS; ++player)
+		psObj = findTransportedDroidById(apsDroidLists[player], id);
+		if (psObj == nullptr)
 		{
-			switch (i)
-			{
-			case 0:
-				psObj = (BASE_OBJECT *)apsDroidLists[player];
-				break;
-			case 1:
-				psObj = (BASE_OBJECT *)apsStructLists[player];
-				break;
-			case 2:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)apsFeatureLists[0];
-				}
-				else
-				{
-					psObj = nullptr;
-				}
-				break;
-			case 3:
-				psObj = (BASE_OBJECT *)mission.apsDroidLists[player];
-				break;
-			case 4:
-				psObj = (BASE_OBJECT *)mission.apsStructLists[player];
-				break;
-			case 5:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)mission.apsFeatureLists[0];
-				}
-				else
-				{
-					psObj = nullptr;
-				}
-				break;
-			case 6:
-				if (player == 0)
-				{
-					psObj = (BASE_OBJECT *)apsLimboDroids[0];
-				}
-				else
-				{
-					psObj = nullptr;
-				}
-				break;
-			default:
-				psObj = nullptr;
-				break;
-			}
-
-			while (psObj)
-			{
-				if (psObj->id == id)
-				{
-					return psObj;
-				}
-				// if transporter check any droids in the grp
-				if ((psObj->type == OBJ_DROID) && isTransporter((DROID *)psObj))
-				{
-					for (psTrans = ((DROID *)psObj)->psGroup->psList; psTrans != nullptr; psTrans = psTrans->psGrpNext)
-					{
-						if (psTrans->id == id)
-						{
-							return (BASE_OBJECT *)psTrans;
-						}
-					}
-				}
-				psObj = psObj->psNext;
-			}
+			psObj = findTransportedDroidById(mission.apsDroidLists[player], id);
 		}
 	}
-	ASSERT(!"couldn't find a BASE_OBJ with ID", "getBaseObjFromId() failed for id %d", id);
+	if (psObj == nullptr)
+	{
+		psObj = findTransportedDroidById(apsLimboDroids[0], id);
+	}
+	ASSERT(psObj != nullptr, "getBaseObjFromId() failed for id %d", id);
 
-	return nullptr;
+	return psObj;
 }
 
 UDWORD getRepairIdFromFlag(FLAG_POSITION *psFlag)
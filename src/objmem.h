@@ -101,6 +101,26 @@ void removeFlagPosition(FLAG_POSITION *psDel);
 void freeAllFlagPositions();
 void freeAllAssemblyPoints();
 
+/// Object lists which can be searched by ID with objFindById.
+enum OBJ_ID_LISTS
+{
+	OBJ_ID_DROIDS           = 0x01,  ///< apsDroidLists
+	OBJ_ID_STRUCTURES       = 0x02,  ///< apsStructLists
+	OBJ_ID_FEATURES         = 0x04,  ///< apsFeatureLists
+	OBJ_ID_MISSION_DROIDS   = 0x08,  ///< mission.apsDroidLists
+	OBJ_ID_MISSION_STRUCTS  = 0x10,  ///< mission.apsStructLists
+	OBJ_ID_MISSION_FEATURES = 0x20,  ///< mission.apsFeatureLists
+	OBJ_ID_LIMBO_DROIDS     = 0x40,  ///< apsLimboDroids
+	OBJ_ID_ALL              = 0x7F,
+};
+
+/// Finds the object with the given id in the given OBJ_ID_LISTS, in the list of the given player, or of any player if player >= MAX_PLAYERS.
+/// Doesn't look inside transporters. Uses an index, so doesn't need to walk the lists, but if several objects have the id, returns
+/// the same one as walking the lists in OBJ_ID_LISTS order, then each player's list in order, would.
+BASE_OBJECT *objFindById(uint32_t id, unsigned player, unsigned lists);
+/// Changes the id of an object, which may already be in a list.
+void objSetId(BASE_OBJECT *psObj, uint32_t id);
+
 // Find a base object from it's id
 BASE_OBJECT *getBaseObjFromData(unsigned id, unsigned player, OBJECT_TYPE type);
 BASE_OBJECT *getBaseObjFromId(UDWORD id);
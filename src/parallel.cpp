@@ -0,0 +1,158 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 1999-2004  Eidos Interactive
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file parallel.cpp
+ *
+ * Pool of worker threads, for splitting up work within a game tick.
+ *
+ */
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "lib/framework/frame.h"
+#include "lib/framework/math_ext.h"
+#include "lib/framework/wzapp.h"
+
+#include "parallel.h"
+
+/// Maximum number of worker threads, in addition to the main thread.
+#define PARALLEL_MAX_THREADS 7
+
+static std::vector<WZ_THREAD *> parallelThreads;
+static bool parallelStarted = false;
+static volatile bool parallelQuit = false;
+static WZ_SEMAPHORE *parallelStartSemaphore = nullptr;  ///< Posted once for each worker thread which should help.
+static WZ_SEMAPHORE *parallelDoneSemaphore = nullptr;   ///< Posted once by each worker thread when it runs out of tasks.
+
+static std::function<void (unsigned)> const *parallelTask = nullptr;
+static unsigned parallelCount = 0;
+static std::atomic<unsigned> parallelNext(0);
+
+/// Runs tasks until there are none left.
+static void parallelRunTasks()
+{
+	for (unsigned i = parallelNext++; i < parallelCount; i = parallelNext++)
+	{
+		(*parallelTask)(i);
+	}
+}
+
+static int parallelThreadFunc(void *)
+{
+	while (true)
+	{
+		wzSemaphoreWait(parallelStartSemaphore);  // Go to sleep until needed.
+		if (parallelQuit)
+		{
+			break;
+		}
+		parallelRunTasks();
+		wzSemaphorePost(parallelDoneSemaphore);
+	}
+	return 0;
+}
+
+/// Returns the number of worker threads to start, in addition to the main thread.
+static unsigned parallelDefaultThreadCount()
+{
+#if !defined(WZ_CC_MINGW)
+	unsigned cores = std::thread::hardware_concurrency();  // Returns 0, if unknown.
+	return clip((int)cores - 1, 0, PARALLEL_MAX_THREADS);
+#else
+	return 1;
+#endif
+}
+
+static void parallelStart()
+{
+	parallelStarted = true;
+	parallelQuit = false;
+	unsigned numThreads = parallelDefaultThreadCount();
+	debug(LOG_INFO, "Using %u worker threads", numThreads);
+	if (numThreads == 0)
+	{
+		return;
+	}
+	parallelStartSemaphore = wzSemaphoreCreate(0);
+	parallelDoneSemaphore = wzSemaphoreCreate(0);
+	for (unsigned i = 0; i < numThreads; ++i)
+	{
+		parallelThreads.push_back(wzThreadCreate(parallelThreadFunc, nullptr));
+		wzThreadStart(parallelThreads.back());
+	}
+}
+
+void parallelFor(unsigned count, std::function<void (unsigned)> const &task)
+{
+	if (!parallelStarted)
+	{
+		parallelStart();
+	}
+
+	unsigned helpers = std::min<unsigned>(parallelThreads.size(), count > 0 ? count - 1 : 0);
+	if (helpers == 0)
+	{
+		for (unsigned i = 0; i < count; ++i)
+		{
+			task(i);
+		}
+		return;
+	}
+
+	parallelTask = &task;
+	parallelCount = count;
+	parallelNext = 0;
+	for (unsigned i = 0; i < helpers; ++i)
+	{
+		wzSemaphorePost(parallelStartSemaphore);
+	}
+	parallelRunTasks();
+	for (unsigned i = 0; i < helpers; ++i)
+	{
+		wzSemaphoreWait(parallelDoneSemaphore);
+	}
+	parallelTask = nullptr;
+}
+
+void parallelShutdown()
+{
+	if (!parallelThreads.empty())
+	{
+		// Signal the worker threads to quit
+		parallelQuit = true;
+		for (size_t i = 0; i < parallelThreads.size(); ++i)
+		{
+			wzSemaphorePost(parallelStartSemaphore);  // Wake up threads.
+		}
+
+		for (WZ_THREAD *thread : parallelThreads)
+		{
+			wzThreadJoin(thread);
+		}
+		parallelThreads.clear();
+		wzSemaphoreDestroy(parallelStartSemaphore);
+		parallelStartSemaphore = nullptr;
+		wzSemaphoreDestroy(parallelDoneSemaphore);
+		parallelDoneSemaphore = nullptr;
+	}
+	parallelStarted = false;
+}
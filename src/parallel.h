@@ -0,0 +1,38 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 1999-2004  Eidos Interactive
+	Copyright (C) 2005-2019  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Runs independent pieces of per-tick work on a pool of worker threads.
+ */
+
+#ifndef __INCLUDED_SRC_PARALLEL_H__
+#define __INCLUDED_SRC_PARALLEL_H__
+
+#include <functional>
+
+/** Calls task(0), task(1), ..., task(count - 1), in no particular order and possibly on several threads at once,
+ *  returning when all calls are done. The tasks must not depend on each other, and must not call parallelFor.
+ *  Call from main thread.
+ */
+void parallelFor(unsigned count, std::function<void (unsigned)> const &task);
+
+/// Stops the worker threads. Call from main thread, on shutdown.
+void parallelShutdown();
+
+#endif // __INCLUDED_SRC_PARALLEL_H__
@@ -50,6 +50,18 @@ static uint64_t expand(uint32_t x)
 	return r;
 }
 
+// Inverse of expand, compacts bit pattern 0a0b 0c0d 0e0f 0g0h to abcd efgh, ignoring the other bits.
+static uint32_t compact(uint64_t r)
+{
+	r &= 0x5555555555555555ULL;
+	r = (r | r >> 1)  & 0x3333333333333333ULL;
+	r = (r | r >> 2)  & 0x0F0F0F0F0F0F0F0FULL;
+	r = (r | r >> 4)  & 0x00FF00FF00FF00FFULL;
+	r = (r | r >> 8)  & 0x0000FFFF0000FFFFULL;
+	r = (r | r >> 16) & 0x00000000FFFFFFFFULL;
+	return r;
+}
+
 // Returns v with highest set bit and all higher bits set, and all following bits 0. Example: 0000 0110 1001 1100 -> 1111 1100 0000 0000.
 static uint32_t findSplit(uint32_t v)
 {
@@ -77,9 +89,15 @@ static uint64_t interleave(int32_t x, int32_t y)
 	return expandX(x) | expandY(y);
 }
 
-void PointTree::insert(void *pointData, int32_t x, int32_t y)
+void PointTree::insert(void *pointData, int32_t x, int32_t y, uint64_t order)
+{
+	points.push_back(Point(interleave(x, y), order, pointData));
+}
+
+void PointTree::pointPosition(unsigned index, int32_t *x, int32_t *y) const
 {
-	points.push_back(Point(interleave(x, y), pointData));
+	*x = compact(points[index].key >> 1) - 0x80000000u;
+	*y = compact(points[index].key) - 0x80000000u;
 }
 
 void PointTree::clear()
@@ -87,14 +105,47 @@ void PointTree::clear()
 	points.clear();
 }
 
-static bool pointTreeSortFunction(std::pair<uint64_t, void *> const &a, std::pair<uint64_t, void *> const &b)
+template<class Point>
+static bool pointTreeSortFunction(Point const &a, Point const &b)
+{
+	return a.key < b.key || (a.key == b.key && a.order < b.order);  // Sort only by position and order, not by pointer address, even if two units are in the same place.
+}
+
+template<class Point>
+static bool pointTreeKeyLess(Point const &a, uint64_t key)
 {
-	return a.first < b.first;  // Sort only by position, not by pointer address, even if two units are in the same place.
+	return a.key < key;
+}
+
+template<class Point>
+static bool pointTreeKeyGreater(uint64_t key, Point const &b)
+{
+	return key < b.key;
 }
 
 void PointTree::sort()
 {
-	std::stable_sort(points.begin(), points.end(), pointTreeSortFunction);  // Stable sort to avoid unspecified behaviour when two objects are in exactly the same place.
+	std::stable_sort(points.begin(), points.end(), pointTreeSortFunction<Point>);  // Stable sort to avoid unspecified behaviour when two objects are in exactly the same place.
+}
+
+void PointTree::insertSorted(void *pointData, int32_t x, int32_t y, uint64_t order)
+{
+	Point point(interleave(x, y), order, pointData);
+	points.insert(std::upper_bound(points.begin(), points.end(), point, pointTreeSortFunction<Point>), point);
+}
+
+bool PointTree::eraseSorted(void *pointData, int32_t x, int32_t y)
+{
+	uint64_t key = interleave(x, y);
+	for (Vector::iterator i = std::lower_bound(points.begin(), points.end(), key, pointTreeKeyLess<Point>); i != points.end() && i->key == key; ++i)
+	{
+		if (i->data == pointData)
+		{
+			points.erase(i);
+			return true;
+		}
+	}
+	return false;
 }
 
 //#define DUMP_IMAGE  // All x and y coordinates must be in range -500 to 499, if dumping an image.
@@ -129,7 +180,7 @@ static unsigned current(std::vector<unsigned> &filterData, unsigned i)
 }
 
 template<bool IsFiltered>
-PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo)
+void PointTree::queryMaybeFilter(Filter &filter, int32_t minXo, int32_t minYo, int32_t maxXo, int32_t maxYo, ResultVector &results, IndexVector &indices) const
 {
 	uint64_t minX = expandX(minXo);
 	uint64_t maxX = expandX(maxXo);
@@ -225,34 +276,28 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		--numRanges;
 	}
 
-	lastQueryResults.clear();
-	if (IsFiltered)
-	{
-		lastFilteredQueryIndices.clear();
-	}
+	results.clear();
+	indices.clear();
 	for (int r = 0; r != numRanges; ++r)
 	{
 		// Find range of points which may be close enough. Range is [i1 ... i2 - 1]. The pointers are ignored when searching.
-		unsigned i1 = std::lower_bound(points.begin(),      points.end(), Point(ranges[r].a, (void *)nullptr), pointTreeSortFunction) - points.begin();
-		unsigned i2 = std::upper_bound(points.begin() + i1, points.end(), Point(ranges[r].z, (void *)nullptr), pointTreeSortFunction) - points.begin();
+		unsigned i1 = std::lower_bound(points.begin(),      points.end(), ranges[r].a, pointTreeKeyLess<Point>) - points.begin();
+		unsigned i2 = std::upper_bound(points.begin() + i1, points.end(), ranges[r].z, pointTreeKeyGreater<Point>) - points.begin();
 
 		for (unsigned i = current<IsFiltered>(filter.data, i1); i < i2; i = current<IsFiltered>(filter.data, i + 1))
 		{
-			uint64_t px = points[i].first & 0xAAAAAAAAAAAAAAAAULL;
-			uint64_t py = points[i].first & 0x5555555555555555ULL;
+			uint64_t px = points[i].key & 0xAAAAAAAAAAAAAAAAULL;
+			uint64_t py = points[i].key & 0x5555555555555555ULL;
 			if (px >= minX && px <= maxX && py >= minY && py <= maxY)  // Only add point if it's at least in the desired square.
 			{
-				lastQueryResults.push_back(points[i].second);
-				if (IsFiltered)
-				{
-					lastFilteredQueryIndices.push_back(i);
-				}
+				results.push_back(points[i].data);
+				indices.push_back(i);
 #ifdef DUMP_IMAGE
 				if (doDump)
 				{
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][0] = 192;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][1] = 128;
-					ppm[((int32_t *)points[i].second)[1] + 500][((int32_t *)points[i].second)[0] + 500][2] = 0;
+					ppm[((int32_t *)points[i].data)[1] + 500][((int32_t *)points[i].data)[0] + 500][0] = 192;
+					ppm[((int32_t *)points[i].data)[1] + 500][((int32_t *)points[i].data)[0] + 500][1] = 128;
+					ppm[((int32_t *)points[i].data)[1] + 500][((int32_t *)points[i].data)[0] + 500][2] = 0;
 				}
 #endif //DUMP_IMAGE
 			}
@@ -266,14 +311,13 @@ PointTree::ResultVector &PointTree::queryMaybeFilter(Filter &filter, int32_t min
 		fclose(f);
 	}
 #endif //DUMP_IMAGE
-
-	return lastQueryResults;
 }
 
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t x2, uint32_t y2)
 {
 	Filter unused;
-	return queryMaybeFilter<false>(unused, x, y, x2, y2);
+	queryMaybeFilter<false>(unused, x, y, x2, y2, lastQueryResults, lastFilteredQueryIndices);
+	return lastQueryResults;
 }
 
 PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
@@ -283,7 +327,8 @@ PointTree::ResultVector &PointTree::query(int32_t x, int32_t y, uint32_t radius)
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo);
+	queryMaybeFilter<false>(unused, minXo, minYo, maxXo, maxYo, lastQueryResults, lastFilteredQueryIndices);
+	return lastQueryResults;
 }
 
 PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius)
@@ -292,5 +337,15 @@ PointTree::ResultVector &PointTree::query(Filter &filter, int32_t x, int32_t y,
 	int32_t maxXo = x + radius;
 	int32_t minYo = y - radius;
 	int32_t maxYo = y + radius;
-	return queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo);
+	queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo, lastQueryResults, lastFilteredQueryIndices);
+	return lastQueryResults;
+}
+
+void PointTree::query(Filter &filter, int32_t x, int32_t y, uint32_t radius, ResultVector &results, IndexVector &indices) const
+{
+	int32_t minXo = x - radius;
+	int32_t maxXo = x + radius;
+	int32_t minYo = y - radius;
+	int32_t maxYo = y + radius;
+	queryMaybeFilter<true>(filter, minXo, minYo, maxXo, maxYo, results, indices);
 }
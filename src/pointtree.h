@@ -52,9 +52,24 @@ public:
 		Data data;
 	};
 
-	void insert(void *pointData, int32_t x, int32_t y);                       ///< Inserts a point into the point tree.
+	void insert(void *pointData, int32_t x, int32_t y, uint64_t order = 0);   ///< Inserts a point into the point tree. Points in the same place are sorted by order.
 	void clear();                                                             ///< Clears the PointTree.
 	void sort();                                                              ///< Must be done between inserting and querying, to get meaningful results.
+	/// Inserts a point into an already sorted point tree, keeping it sorted. Invalidates filters.
+	void insertSorted(void *pointData, int32_t x, int32_t y, uint64_t order = 0);
+	/// Erases a point from an already sorted point tree, keeping it sorted. Returns false if the point wasn't found. Invalidates filters.
+	bool eraseSorted(void *pointData, int32_t x, int32_t y);
+	size_t size() const
+	{
+		return points.size();
+	}
+	/// Returns true if the point with index a comes before the point with index b in other, in the order they would have if both were in the same PointTree.
+	bool pointBefore(unsigned a, PointTree const &other, unsigned b) const
+	{
+		return points[a].key < other.points[b].key || (points[a].key == other.points[b].key && points[a].order < other.points[b].order);
+	}
+	/// Gets the coordinates the point with the given index was inserted at.
+	void pointPosition(unsigned index, int32_t *x, int32_t *y) const;
 	/// Returns all points less than or equal to radius from (x, y), possibly plus some extra nearby points.
 	/// (More specifically, returns all objects in a square with edge length 2*radius.)
 	/// Note: Not thread safe, because it modifies lastQueryResults.
@@ -65,16 +80,25 @@ public:
 	ResultVector &query(Filter &filter, int32_t x, int32_t y, uint32_t radius);
 	/// Returns all points which have not been filtered away within given rectangle. See function above on thread safety.
 	ResultVector &query(int32_t x, int32_t y, uint32_t x2, uint32_t y2);
+	/// Like query(filter, x, y, radius), but stores the results and their indices in the given vectors instead.
+	/// Thread safe, as long as no thread modifies the PointTree, and each thread uses its own filter and vectors.
+	void query(Filter &filter, int32_t x, int32_t y, uint32_t radius, ResultVector &results, IndexVector &indices) const;
 
 	ResultVector lastQueryResults;
-	IndexVector lastFilteredQueryIndices;
+	IndexVector lastFilteredQueryIndices;  ///< Indices of the points in lastQueryResults, for Filter::erase, pointBefore and pointPosition.
 
 private:
-	typedef std::pair<uint64_t, void *> Point;
+	struct Point
+	{
+		Point(uint64_t key_, uint64_t order_, void *data_) : key(key_), order(order_), data(data_) {}
+		uint64_t key;    ///< Interleaved coordinates.
+		uint64_t order;  ///< Order of points in exactly the same place.
+		void *data;
+	};
 	typedef std::vector<Point> Vector;
 
 	template<bool IsFiltered>
-	ResultVector &queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo);
+	void queryMaybeFilter(Filter &filter, int32_t minXo, int32_t maxXo, int32_t minYo, int32_t maxYo, ResultVector &results, IndexVector &indices) const;
 
 	Vector points;
 };
@@ -55,10 +55,12 @@
 #include "multiplay.h"
 #include "multistat.h"
 #include "mapgrid.h"
+#include "objectpool.h"
 #include "random.h"
 
 #include <algorithm>
 #include <functional>
+#include <unordered_map>
 #ifndef GLM_ENABLE_EXPERIMENTAL
 	#define GLM_ENABLE_EXPERIMENTAL
 #endif
@@ -79,6 +81,8 @@ struct INTERVAL
 // Watermelon:they are from droid.c
 /* The range for neighbouring objects */
 #define PROJ_NEIGHBOUR_RANGE (TILE_UNITS*4)
+/* log2 of the size of the cells which projectiles share collision candidates in */
+#define PROJ_COLLISION_CELL_SHIFT 8
 // used to create a specific ID for projectile objects to facilitate tracking them.
 static const UDWORD ProjectileTrackerID =	0xdead0000;
 
@@ -88,6 +92,28 @@ static std::vector<PROJECTILE *> psProjectileList;
 /* The next projectile to give out in the proj_First / proj_Next methods */
 static ProjectileIterator psProjectileNext;
 
+static ObjectPool projectilePool("projectiles", sizeof(PROJECTILE));
+
+/* Objects which could be hit by projectiles in a cell, and where they were at the last gridReset */
+struct ProjCollisionCell
+{
+	GridList objects;
+	std::vector<Vector2i> gridPositions;
+};
+
+/* Objects which could be hit by projectiles in each cell, found once per cell per tick */
+static std::unordered_map<uint64_t, ProjCollisionCell> projCollisionCells;
+
+void *PROJECTILE::operator new(size_t size)
+{
+	return projectilePool.allocate(size);
+}
+
+void PROJECTILE::operator delete(void *ptr)
+{
+	projectilePool.release(ptr);
+}
+
 /***************************************************************************/
 
 // the last unit that did damage - used by script functions
@@ -688,6 +714,29 @@ static int32_t collisionXYZ(Vector3i v1, Vector3i v2, ObjectShape shape, int32_t
 	return -1;
 }
 
+/* Returns the objects which could be hit by a projectile at pos, and some more, which must be filtered out the same way
+ * gridStartIterate does, using both their grid positions and current positions. The objects are in the same order as
+ * gridStartIterate would return them, so hits are resolved the same way. The grid does not change while the projectiles
+ * are updated, so the lists are shared by all projectiles in a cell for the tick. */
+static ProjCollisionCell const &proj_CollisionCandidates(Vector2i pos)
+{
+	const int32_t cellX = pos.x >> PROJ_COLLISION_CELL_SHIFT;
+	const int32_t cellY = pos.y >> PROJ_COLLISION_CELL_SHIFT;
+	const uint64_t key = (uint64_t)(uint32_t)cellX << 32 | (uint32_t)cellY;
+
+	auto cell = projCollisionCells.find(key);
+	if (cell == projCollisionCells.end())
+	{
+		const int32_t x1 = cellX * (1 << PROJ_COLLISION_CELL_SHIFT) - PROJ_NEIGHBOUR_RANGE;
+		const int32_t y1 = cellY * (1 << PROJ_COLLISION_CELL_SHIFT) - PROJ_NEIGHBOUR_RANGE;
+		const int32_t x2 = x1 + (1 << PROJ_COLLISION_CELL_SHIFT) - 1 + 2 * PROJ_NEIGHBOUR_RANGE;
+		const int32_t y2 = y1 + (1 << PROJ_COLLISION_CELL_SHIFT) - 1 + 2 * PROJ_NEIGHBOUR_RANGE;
+		cell = projCollisionCells.emplace(key, ProjCollisionCell()).first;
+		cell->second.objects = gridStartIterateArea(x1, y1, x2, y2, cell->second.gridPositions);
+	}
+	return cell->second;
+}
+
 static void proj_InFlightFunc(PROJECTILE *psProj)
 {
 	/* we want a delay between Las-Sats firing and actually hitting in multiPlayer
@@ -810,14 +859,25 @@ static void proj_InFlightFunc(PROJECTILE *psProj)
 	closestCollisionSpacetime.time = 0xFFFFFFFF;
 
 	/* Check nearby objects for possible collisions */
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterate(psProj->pos.x, psProj->pos.y, PROJ_NEIGHBOUR_RANGE);
-	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
+	ProjCollisionCell const &candidates = proj_CollisionCandidates(psProj->pos.xy());
+	for (size_t i = 0; i < candidates.objects.size(); ++i)
 	{
-		BASE_OBJECT *psTempObj = *gi;
+		BASE_OBJECT *psTempObj = candidates.objects[i];
 		CHECK_OBJECT(psTempObj);
 
-		if (std::find(psProj->psDamaged.begin(), psProj->psDamaged.end(), psTempObj) != psProj->psDamaged.end())
+		const Vector2i gridDiff = candidates.gridPositions[i] - psProj->pos.xy();
+		const Vector2i neighbourDiff = psTempObj->pos.xy() - psProj->pos.xy();
+		if (abs(gridDiff.x) > PROJ_NEIGHBOUR_RANGE || abs(gridDiff.y) > PROJ_NEIGHBOUR_RANGE)
+		{
+			// Not in the square which gridStartIterate searches, around where the object was at the last gridReset
+			continue;
+		}
+		else if ((uint32_t)(neighbourDiff.x * neighbourDiff.x + neighbourDiff.y * neighbourDiff.y) > PROJ_NEIGHBOUR_RANGE * PROJ_NEIGHBOUR_RANGE)
+		{
+			// Too far away, same radius test as gridStartIterate
+			continue;
+		}
+		else if (std::find(psProj->psDamaged.begin(), psProj->psDamaged.end(), psTempObj) != psProj->psDamaged.end())
 		{
 			// Dont damage one target twice
 			continue;
@@ -1345,6 +1405,7 @@ void proj_UpdateAll()
 
 	// Update all projectiles. Penetrating projectiles may add to psProjectileList.
 	std::for_each(psProjectileListOld.begin(), psProjectileListOld.end(), std::mem_fun(&PROJECTILE::update));
+	projCollisionCells.clear();  // The grid changes before the next update.
 
 	// Remove and free dead projectiles.
 	psProjectileList.erase(std::remove_if(psProjectileList.begin(), psProjectileList.end(), std::mem_fun(&PROJECTILE::deleteIfDead)), psProjectileList.end());
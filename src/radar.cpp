@@ -302,9 +302,9 @@ static PIELIGHT appliedRadarColour(RADAR_DRAW_MODE radarDrawMode, MAPTILE *WTile
 			// draw radar terrain on/off feature
 			PIELIGHT col = tileColours[TileNumber_tile(WTile->texture)];
 
-			col.byte.r = sqrtf(col.byte.r * WTile->illumination);
-			col.byte.b = sqrtf(col.byte.b * WTile->illumination);
-			col.byte.g = sqrtf(col.byte.g * WTile->illumination);
+			col.byte.r = sqrtf(col.byte.r * mapTileLight(WTile)->illumination);
+			col.byte.b = sqrtf(col.byte.b * mapTileLight(WTile)->illumination);
+			col.byte.g = sqrtf(col.byte.g * mapTileLight(WTile)->illumination);
 			if (terrainType(WTile) == TER_CLIFFFACE)
 			{
 				col.byte.r /= 2;
@@ -331,9 +331,9 @@ static PIELIGHT appliedRadarColour(RADAR_DRAW_MODE radarDrawMode, MAPTILE *WTile
 			// draw radar terrain on/off feature
 			PIELIGHT col = tileColours[TileNumber_tile(WTile->texture)];
 
-			col.byte.r = sqrtf(col.byte.r * (WTile->illumination + WTile->height / ELEVATION_SCALE) / 2);
-			col.byte.b = sqrtf(col.byte.b * (WTile->illumination + WTile->height / ELEVATION_SCALE) / 2);
-			col.byte.g = sqrtf(col.byte.g * (WTile->illumination + WTile->height / ELEVATION_SCALE) / 2);
+			col.byte.r = sqrtf(col.byte.r * (mapTileLight(WTile)->illumination + WTile->height / ELEVATION_SCALE) / 2);
+			col.byte.b = sqrtf(col.byte.b * (mapTileLight(WTile)->illumination + WTile->height / ELEVATION_SCALE) / 2);
+			col.byte.g = sqrtf(col.byte.g * (mapTileLight(WTile)->illumination + WTile->height / ELEVATION_SCALE) / 2);
 			if (terrainType(WTile) == TER_CLIFFFACE)
 			{
 				col.byte.r /= 2;
@@ -81,6 +81,7 @@
 #include "template.h"
 #include "scores.h"
 #include "gateway.h"
+#include "objectpool.h"
 
 #include "random.h"
 #include <functional>
@@ -165,6 +166,7 @@ static void auxStructureNonblocking(STRUCTURE *psStructure)
 			auxClearAll(b.map.x + i, b.map.y + j, AUXBITS_BLOCKING | AUXBITS_OUR_BUILDING | AUXBITS_NONPASSABLE);
 		}
 	}
+	fpathMarkBlockingChanged(b);
 }
 
 static void auxStructureBlocking(STRUCTURE *psStructure)
@@ -179,6 +181,7 @@ static void auxStructureBlocking(STRUCTURE *psStructure)
 			auxSetAll(b.map.x + i, b.map.y + j, AUXBITS_BLOCKING | AUXBITS_NONPASSABLE);
 		}
 	}
+	fpathMarkBlockingChanged(b);
 }
 
 static void auxStructureOpenGate(STRUCTURE *psStructure)
@@ -192,6 +195,7 @@ static void auxStructureOpenGate(STRUCTURE *psStructure)
 			auxClearAll(b.map.x + i, b.map.y + j, AUXBITS_BLOCKING);
 		}
 	}
+	fpathMarkBlockingChanged(b);
 }
 
 static void auxStructureClosedGate(STRUCTURE *psStructure)
@@ -206,6 +210,7 @@ static void auxStructureClosedGate(STRUCTURE *psStructure)
 			auxSetAll(b.map.x + i, b.map.y + j, AUXBITS_BLOCKING);
 		}
 	}
+	fpathMarkBlockingChanged(b);
 }
 
 bool IsStatExpansionModule(const STRUCTURE_STATS *psStats)
@@ -1411,6 +1416,7 @@ STRUCTURE *buildStructureDir(STRUCTURE_STATS *pStructureType, UDWORD x, UDWORD y
 				}
 			}
 		}
+		fpathMarkBlockingChanged(StructureBounds(map, size));
 
 		switch (pStructureType->type)
 		{
@@ -3756,6 +3762,18 @@ STRUCTURE::STRUCTURE(uint32_t id, unsigned player)
 	capacity = 0;
 }
 
+static ObjectPool structurePool("structures", sizeof(STRUCTURE));
+
+void *STRUCTURE::operator new(size_t size)
+{
+	return structurePool.allocate(size);
+}
+
+void STRUCTURE::operator delete(void *ptr)
+{
+	structurePool.release(ptr);
+}
+
 /* Release all resources associated with a structure */
 STRUCTURE::~STRUCTURE()
 {
@@ -4670,7 +4688,7 @@ bool destroyStruct(STRUCTURE *psDel, unsigned impactTime)
 				MAPTILE *psTile = mapTile(b.map.x + width, b.map.y + breadth);
 				if (TEST_TILE_VISIBLE(selectedPlayer, psTile))
 				{
-					psTile->illumination /= 2;
+					mapTileLight(psTile)->illumination /= 2;
 				}
 			}
 		}
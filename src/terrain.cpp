@@ -206,15 +206,13 @@ static void addDrawRangeElements(GLenum mode,
 /// Get the colour of the terrain tile at the specified position
 PIELIGHT getTileColour(int x, int y)
 {
-	return mapTile(x, y)->colour;
+	return mapTileLight(x, y)->colour;
 }
 
 /// Set the colour of the tile at the specified position
 void setTileColour(int x, int y, PIELIGHT colour)
 {
-	MAPTILE *psTile = mapTile(x, y);
-
-	psTile->colour = colour;
+	mapTileLight(x, y)->colour = colour;
 }
 
 // NOTE:  The current (max) texture size of a tile is 128x128.  We allow up to a user defined texture size
@@ -998,7 +996,7 @@ static void updateLightMap()
 		for (int i = 0; i < mapWidth; ++i)
 		{
 			MAPTILE *psTile = mapTile(i, j);
-			PIELIGHT colour = psTile->colour;
+			PIELIGHT colour = mapTileLight(psTile)->colour;
 
 			if (psTile->tileInfoBits & BITS_GATEWAY && showGateways)
 			{
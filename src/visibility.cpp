@@ -45,6 +45,8 @@
 #include "projectile.h"
 #include "display.h"
 #include "multiplay.h"
+#include "parallel.h"
+#include "pointtree.h"
 #include "qtscript.h"
 #include "wavecast.h"
 
@@ -100,12 +102,12 @@ void visUpdateLevel()
 	visLevelDec = gameTimeAdjustedAverage(VIS_LEVEL_DEC);
 }
 
-static inline void updateTileVis(MAPTILE *psTile)
+static inline void updateTileVis(MAPTILE *psTile, MAPTILE_VISION const *psVision)
 {
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
 		/// The definition of whether a player can see something on a given tile or not
-		if (psTile->watchers[i] > 0 || (psTile->sensors[i] > 0 && !(psTile->jammerBits & ~alliancebits[i])))
+		if (psVision->watchers[i] > 0 || (psVision->sensors[i] > 0 && !(psTile->jammerBits & ~alliancebits[i])))
 		{
 			psTile->sensorBits |= (1 << i);         // mark it as being seen
 		}
@@ -131,13 +133,14 @@ uint32_t addSpotter(int x, int y, int player, int radius, bool radar, uint32_t e
 			continue;
 		}
 		MAPTILE *psTile = mapTile(mapX, mapY);
+		MAPTILE_VISION *psVision = mapTileVision(psTile);
 		psTile->tileExploredBits |= alliancebits[player];
-		uint8_t *visionType = (!radar) ? psTile->watchers : psTile->sensors;
+		uint8_t *visionType = (!radar) ? psVision->watchers : psVision->sensors;
 		if (visionType[player] < UBYTE_MAX)
 		{
 			TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), uint8_t(radar)};
 			visionType[player]++;          // we observe this tile
-			updateTileVis(psTile);
+			updateTileVis(psTile, psVision);
 			psSpot->watchedTiles[psSpot->numWatchedTiles++] = tilePos;    // record having seen it
 		}
 	}
@@ -200,41 +203,82 @@ SPOTTER::~SPOTTER()
 	{
 		const TILEPOS tilePos = watchedTiles[i];
 		MAPTILE *psTile = mapTile(tilePos.x, tilePos.y);
-		uint8_t *visionType = (tilePos.type == 0) ? psTile->watchers : psTile->sensors;
+		MAPTILE_VISION *psVision = mapTileVision(psTile);
+		uint8_t *visionType = (tilePos.type == 0) ? psVision->watchers : psVision->sensors;
 		ASSERT(visionType[player] > 0, "Not watching watched tile (%d, %d)", (int)tilePos.x, (int)tilePos.y);
 		visionType[player]--;
-		updateTileVis(psTile);
+		updateTileVis(psTile, psVision);
 	}
 	free(watchedTiles);
 }
 
-/* Record all tiles that some object confers visibility to. Only record each tile
+/* Record a tile that some object confers visibility to. Only record each tile
  * once. Note that there is both a limit to how many objects can watch any given
  * tile, and a limit to how many tiles each object can watch. Strange but non fatal
- * things will happen if these limits are exceeded. This function uses icky globals. */
-static inline void visMarkTile(const BASE_OBJECT *psObj, int mapX, int mapY, MAPTILE *psTile, TILEPOS *recordTilePos, int *lastRecordTilePos)
+ * things will happen if these limits are exceeded. */
+static inline void visRecordTile(const BASE_OBJECT *psObj, int mapX, int mapY, TILEPOS *recordTilePos, int *lastRecordTilePos)
 {
-	const int rayPlayer = psObj->player;
 	const int xdiff = map_coord(psObj->pos.x) - mapX;
 	const int ydiff = map_coord(psObj->pos.y) - mapY;
 	const int distSq = xdiff * xdiff + ydiff * ydiff;
 	const bool inRange = (distSq < 16);
-	uint8_t *visionType = inRange ? psTile->watchers : psTile->sensors;
 
-	if (visionType[rayPlayer] < UBYTE_MAX && *lastRecordTilePos < MAX_SEEN_TILES)
+	if (*lastRecordTilePos < MAX_SEEN_TILES)
 	{
 		TILEPOS tilePos = {uint8_t(mapX), uint8_t(mapY), uint8_t(inRange)};
+		recordTilePos[*lastRecordTilePos] = tilePos;    // record having seen it
+		++*lastRecordTilePos;
+	}
+}
 
-		visionType[rayPlayer]++;                        // we observe this tile
-		if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))   // we are a jammer object
+/* Add the object's vision to a recorded tile. Returns false if too many objects already watch the tile. */
+static inline bool visWatchTile(const BASE_OBJECT *psObj, TILEPOS pos)
+{
+	const int rayPlayer = psObj->player;
+	MAPTILE *psTile = mapTile(pos.x, pos.y);
+	MAPTILE_VISION *psVision = mapTileVision(psTile);
+	uint8_t *visionType = (pos.type == 0) ? psVision->sensors : psVision->watchers;
+
+	if (visionType[rayPlayer] == UBYTE_MAX)
+	{
+		return false;
+	}
+	visionType[rayPlayer]++;                        // we observe this tile
+	if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))   // we are a jammer object
+	{
+		psVision->jammers[rayPlayer]++;
+		psTile->jammerBits |= (1 << rayPlayer); // mark it as being jammed
+	}
+	updateTileVis(psTile, psVision);
+	return true;
+}
+
+/* Remove the object's vision from a watched tile. */
+static inline void visUnwatchTile(const BASE_OBJECT *psObj, TILEPOS pos)
+{
+	// FIXME: the mapTile might have been swapped out, see swapMissionPointers()
+	MAPTILE *psTile = mapTile(pos.x, pos.y);
+	MAPTILE_VISION *psVision = mapTileVision(psTile);
+
+	ASSERT(pos.type < 2, "Invalid visibility type %d", (int)pos.type);
+	uint8_t *visionType = (pos.type == 0) ? psVision->sensors : psVision->watchers;
+	if (visionType[psObj->player] == 0 && game.type == CAMPAIGN)	// hack
+	{
+		return;
+	}
+	ASSERT(visionType[psObj->player] > 0, "No %s on watched tile (%d, %d)", pos.type ? "radar" : "vision", (int)pos.x, (int)pos.y);
+	visionType[psObj->player]--;
+	if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))  // we are a jammer object — we cannot check objJammerPower(psObj) > 0 directly here, we may be in the BASE_OBJECT destructor).
+	{
+		// No jammers in campaign, no need for special hack
+		ASSERT(psVision->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
+		psVision->jammers[psObj->player]--;
+		if (psVision->jammers[psObj->player] == 0)
 		{
-			psTile->jammers[rayPlayer]++;
-			psTile->jammerBits |= (1 << rayPlayer); // mark it as being jammed
+			psTile->jammerBits &= ~(1 << psObj->player);
 		}
-		updateTileVis(psTile);
-		recordTilePos[*lastRecordTilePos] = tilePos;    // record having seen it
-		++*lastRecordTilePos;
 	}
+	updateTileVis(psTile, psVision);
 }
 
 /* The terrain revealing ray callback */
@@ -314,8 +358,8 @@ static void doWaveTerrain(const BASE_OBJECT *psObj, TILEPOS *recordTilePos, int
 		if (seen)
 		{
 			// Can see this tile.
-			psTile->tileExploredBits |= alliancebits[rayPlayer];                        // Share exploration with allies too
-			visMarkTile(psObj, mapX, mapY, psTile, recordTilePos, lastRecordTilePos);   // Mark this tile as seen by our sensor
+			psTile->tileExploredBits |= alliancebits[rayPlayer];            // Share exploration with allies too
+			visRecordTile(psObj, mapX, mapY, recordTilePos, lastRecordTilePos);   // Mark this tile as seen by our sensor
 		}
 	}
 }
@@ -327,34 +371,13 @@ void visRemoveVisibility(BASE_OBJECT *psObj)
 	{
 		for (int i = 0; i < psObj->numWatchedTiles; i++)
 		{
-			const TILEPOS pos = psObj->watchedTiles[i];
-			// FIXME: the mapTile might have been swapped out, see swapMissionPointers()
-			MAPTILE *psTile = mapTile(pos.x, pos.y);
-
-			ASSERT(pos.type < 2, "Invalid visibility type %d", (int)pos.type);
-			uint8_t *visionType = (pos.type == 0) ? psTile->sensors : psTile->watchers;
-			if (visionType[psObj->player] == 0 && game.type == CAMPAIGN)	// hack
-			{
-				continue;
-			}
-			ASSERT(visionType[psObj->player] > 0, "No %s on watched tile (%d, %d)", pos.type ? "radar" : "vision", (int)pos.x, (int)pos.y);
-			visionType[psObj->player]--;
-			if (psObj->flags.test(OBJECT_FLAG_JAMMED_TILES))  // we are a jammer object — we cannot check objJammerPower(psObj) > 0 directly here, we may be in the BASE_OBJECT destructor).
-			{
-				// No jammers in campaign, no need for special hack
-				ASSERT(psTile->jammers[psObj->player] > 0, "Not jamming watched tile (%d, %d)", (int)pos.x, (int)pos.y);
-				psTile->jammers[psObj->player]--;
-				if (psTile->jammers[psObj->player] == 0)
-				{
-					psTile->jammerBits &= ~(1 << psObj->player);
-				}
-			}
-			updateTileVis(psTile);
+			visUnwatchTile(psObj, psObj->watchedTiles[i]);
 		}
 	}
 	free(psObj->watchedTiles);
 	psObj->watchedTiles = nullptr;
 	psObj->numWatchedTiles = 0;
+	psObj->watchedFrom = WATCHEDFROM();
 	psObj->flags.set(OBJECT_FLAG_JAMMED_TILES, false);
 }
 
@@ -363,19 +386,21 @@ void visRemoveVisibilityOffWorld(BASE_OBJECT *psObj)
 	free(psObj->watchedTiles);
 	psObj->watchedTiles = nullptr;
 	psObj->numWatchedTiles = 0;
+	psObj->watchedFrom = WATCHEDFROM();
 }
 
 /* Check which tiles can be seen by an object */
 void visTilesUpdate(BASE_OBJECT *psObj)
 {
+	// Per-tile marks of the previously watched tiles, valid if equal to (visTileMarkGeneration << 1 | type).
+	static std::vector<uint32_t> visTileMarks;
+	static uint32_t visTileMarkGeneration = 0;
+
 	TILEPOS recordTilePos[MAX_SEEN_TILES];
 	int lastRecordTilePos = 0;
 
 	ASSERT(psObj->type != OBJ_FEATURE, "visTilesUpdate: visibility updates are not for features!");
 
-	// Remove previous map visibility provided by object
-	visRemoveVisibility(psObj);
-
 	if (psObj->type == OBJ_STRUCTURE)
 	{
 		STRUCTURE *psStruct = (STRUCTURE *)psObj;
@@ -383,21 +408,93 @@ void visTilesUpdate(BASE_OBJECT *psObj)
 		    psStruct->pStructureType->type == REF_WALL || psStruct->pStructureType->type == REF_WALLCORNER || psStruct->pStructureType->type == REF_GATE)
 		{
 			// unbuilt structures and walls do not confer visibility.
+			visRemoveVisibility(psObj);
 			return;
 		}
 	}
 
+	WATCHEDFROM from;
+	from.map = psMapTiles;
+	from.heightVersion = mapHeightVersion;
+	from.x = map_coord(psObj->pos.x);
+	from.y = map_coord(psObj->pos.y);
+	from.z = psObj->pos.z + MAX(MIN_VIS_HEIGHT, psObj->sDisplay.imd->max.y);
+	from.radius = objSensorRange(psObj);
+	from.player = psObj->player;
+	from.allianceBits = alliancebits[psObj->player];
+	from.jammer = objJammerPower(psObj) > 0;
+	if (from == psObj->watchedFrom)
+	{
+		return;  // Still sees exactly the same tiles as last time.
+	}
+
 	// Do the whole circle in ∞ steps. No more pretty moiré patterns.
-	psObj->flags.set(OBJECT_FLAG_JAMMED_TILES, objJammerPower(psObj) > 0);
 	doWaveTerrain(psObj, recordTilePos, &lastRecordTilePos);
 
+	int numWatched = 0;
+	if (psObj->watchedFrom.map != psMapTiles || psObj->watchedFrom.player != from.player || psObj->watchedFrom.jammer != from.jammer || psObj->watchedFrom.allianceBits != from.allianceBits || !mapWidth || !mapHeight)
+	{
+		// Remove previous map visibility provided by object, and add it all again. Also needed if alliances changed, since
+		// the sensorBits of tiles which are still watched depend on alliancebits.
+		visRemoveVisibility(psObj);
+		psObj->flags.set(OBJECT_FLAG_JAMMED_TILES, from.jammer);
+		for (int i = 0; i < lastRecordTilePos; ++i)
+		{
+			if (visWatchTile(psObj, recordTilePos[i]))
+			{
+				recordTilePos[numWatched++] = recordTilePos[i];
+			}
+		}
+	}
+	else
+	{
+		// Only update the tiles which were not seen the same way before, since most tiles are still seen after moving one tile.
+		if (visTileMarks.size() != (size_t)mapWidth * mapHeight || visTileMarkGeneration >= 0x7FFFFFFF)
+		{
+			visTileMarks.assign((size_t)mapWidth * mapHeight, 0);
+			visTileMarkGeneration = 0;
+		}
+		const uint32_t mark = ++visTileMarkGeneration << 1;
+		for (int i = 0; i < psObj->numWatchedTiles; ++i)
+		{
+			const TILEPOS pos = psObj->watchedTiles[i];
+			visTileMarks[pos.x + pos.y * mapWidth] = mark | pos.type;
+		}
+		for (int i = 0; i < lastRecordTilePos; ++i)
+		{
+			const TILEPOS pos = recordTilePos[i];
+			uint32_t &tileMark = visTileMarks[pos.x + pos.y * mapWidth];
+			if (tileMark == (mark | pos.type))
+			{
+				tileMark = 0;  // Still watched, nothing to do.
+				recordTilePos[numWatched++] = pos;
+			}
+			else if (visWatchTile(psObj, pos))
+			{
+				recordTilePos[numWatched++] = pos;
+			}
+		}
+		for (int i = 0; i < psObj->numWatchedTiles; ++i)
+		{
+			const TILEPOS pos = psObj->watchedTiles[i];
+			if (visTileMarks[pos.x + pos.y * mapWidth] == (mark | pos.type))
+			{
+				visUnwatchTile(psObj, pos);  // No longer watched.
+			}
+		}
+		free(psObj->watchedTiles);
+		psObj->watchedTiles = nullptr;
+		psObj->numWatchedTiles = 0;
+	}
+
 	// Record new map visibility provided by object
-	if (lastRecordTilePos > 0)
+	if (numWatched > 0)
 	{
-		psObj->watchedTiles = (TILEPOS *)malloc(lastRecordTilePos * sizeof(*psObj->watchedTiles));
-		psObj->numWatchedTiles = lastRecordTilePos;
-		memcpy(psObj->watchedTiles, recordTilePos, lastRecordTilePos * sizeof(*psObj->watchedTiles));
+		psObj->watchedTiles = (TILEPOS *)malloc(numWatched * sizeof(*psObj->watchedTiles));
+		psObj->numWatchedTiles = numWatched;
+		memcpy(psObj->watchedTiles, recordTilePos, numWatched * sizeof(*psObj->watchedTiles));
 	}
+	psObj->watchedFrom = from;
 }
 
 /*reveals all the terrain in the map*/
@@ -501,6 +598,7 @@ int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool
 	}
 
 	const MAPTILE *psTile = mapTile(map_coord(psTarget->pos.x), map_coord(psTarget->pos.y));
+	const MAPTILE_VISION *psVision = mapTileVision(psTile);
 	const bool jammed = psTile->jammerBits & ~alliancebits[psViewer->player];
 
 	// Special rule for VTOLs, as they are not affected by ECM
@@ -511,12 +609,12 @@ int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool
 		return UBYTE_MAX;
 	}
 	// Show objects hidden by ECM jamming with radar blips
-	else if (psTile->watchers[psViewer->player] == 0 && psTile->sensors[psViewer->player] > 0 && jammed)
+	else if (psVision->watchers[psViewer->player] == 0 && psVision->sensors[psViewer->player] > 0 && jammed)
 	{
 		return UBYTE_MAX / 2;
 	}
 	// Show objects that are seen directly or with unjammed sensors
-	else if (psTile->watchers[psViewer->player] > 0 || (psTile->sensors[psViewer->player] > 0 && !jammed))
+	else if (psVision->watchers[psViewer->player] > 0 || (psVision->sensors[psViewer->player] > 0 && !jammed))
 	{
 		return UBYTE_MAX;
 	}
@@ -611,7 +709,9 @@ static void processVisibilitySelf(BASE_OBJECT *psObj)
 }
 
 // Calculate which objects we can see. Better to call after processVisibilitySelf, since that check is cheaper.
-static void processVisibilityVision(BASE_OBJECT *psViewer)
+// Only changes seenThisTick for players sharing vision with psViewer->player, so different players may be processed on different threads.
+// Since scripts aren't thread safe, the objects seen are added to seenEvents, for triggering events later.
+static void processVisibilityVision(BASE_OBJECT *psViewer, std::vector<std::pair<BASE_OBJECT *, BASE_OBJECT *>> &seenEvents)
 {
 	if (psViewer->type == OBJ_FEATURE)
 	{
@@ -620,8 +720,7 @@ static void processVisibilityVision(BASE_OBJECT *psViewer)
 
 	// get all the objects from the grid the droid is in
 	// Will give inconsistent results if hasSharedVision is not an equivalence relation.
-	static GridList gridList;  // static to avoid allocations.
-	gridList = gridStartIterateUnseen(psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player);
+	GridList const &gridList = gridStartIterateUnseen(psViewer->pos.x, psViewer->pos.y, objSensorRange(psViewer), psViewer->player);
 	for (GridIterator gi = gridList.begin(); gi != gridList.end(); ++gi)
 	{
 		BASE_OBJECT *psObj = *gi;
@@ -635,7 +734,7 @@ static void processVisibilityVision(BASE_OBJECT *psViewer)
 			setSeenBy(psObj, psViewer->player, val);
 
 			// Check if scripting system wants to trigger an event for this
-			triggerEventSeen(psViewer, psObj);
+			seenEvents.push_back(std::make_pair(psViewer, psObj));
 		}
 	}
 }
@@ -718,6 +817,50 @@ static void processVisibilityLevel(BASE_OBJECT *psObj)
 	}
 }
 
+// Radar detectors see active radars within 10 times their sensor range, as radar blips.
+static void processVisibilityRadarDetectors()
+{
+	static std::vector<BASE_OBJECT *> detectors;  // static to avoid allocations.
+	detectors.clear();
+	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != nullptr; psObj = psObj->psNextFunc)
+	{
+		if (objRadarDetector(psObj))
+		{
+			detectors.push_back(psObj);
+		}
+	}
+	if (detectors.empty())
+	{
+		return;
+	}
+
+	// Only look at the active radars near each detector, instead of at all sensors.
+	static PointTree radars;
+	radars.clear();
+	for (BASE_OBJECT *psTarget = apsSensorList[0]; psTarget != nullptr; psTarget = psTarget->psNextFunc)
+	{
+		if (objActiveRadar(psTarget))
+		{
+			radars.insert(psTarget, psTarget->pos.x, psTarget->pos.y);
+		}
+	}
+	radars.sort();
+
+	for (BASE_OBJECT *psObj : detectors)
+	{
+		int range = objSensorRange(psObj) * 10;
+		for (void *point : radars.query(psObj->pos.x, psObj->pos.y, range))
+		{
+			BASE_OBJECT *psTarget = static_cast<BASE_OBJECT *>(point);
+			if (psObj != psTarget && psTarget->visible[psObj->player] < UBYTE_MAX / 2
+			    && iHypot((psTarget->pos - psObj->pos).xy()) < range)
+			{
+				psTarget->visible[psObj->player] = UBYTE_MAX / 2;
+			}
+		}
+	}
+}
+
 void processVisibility()
 {
 	updateSpotters();
@@ -733,33 +876,68 @@ void processVisibility()
 			}
 		}
 	}
+
+	// Split the players into groups sharing vision. Only the players in a group see what the group sees, so each group can be
+	// processed on a different thread, and the results are the same as processing all players in order on a single thread.
+	int groupOf[MAX_PLAYERS];
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
-		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player]};
-		unsigned list;
-		for (list = 0; list < sizeof(lists) / sizeof(*lists); ++list)
+		groupOf[player] = player;
+	}
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (int ally = 0; ally < MAX_PLAYERS; ++ally)
 		{
-			for (BASE_OBJECT *psObj = lists[list]; psObj != nullptr; psObj = psObj->psNext)
+			if (groupOf[ally] != groupOf[player] && (hasSharedVision(player, ally) || hasSharedVision(ally, player)))
 			{
-				processVisibilityVision(psObj);
+				int oldGroup = groupOf[ally];
+				for (int &group : groupOf)
+				{
+					group = group == oldGroup ? groupOf[player] : group;
+				}
 			}
 		}
 	}
-	for (BASE_OBJECT *psObj = apsSensorList[0]; psObj != nullptr; psObj = psObj->psNextFunc)
+	std::vector<std::vector<int>> groups;
+	int groupIndex[MAX_PLAYERS];
+	std::fill(groupIndex, groupIndex + MAX_PLAYERS, -1);
+	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
-		if (objRadarDetector(psObj))
+		int &index = groupIndex[groupOf[player]];
+		if (index < 0)
 		{
-			for (BASE_OBJECT *psTarget = apsSensorList[0]; psTarget != nullptr; psTarget = psTarget->psNextFunc)
+			index = groups.size();
+			groups.emplace_back();
+		}
+		groups[index].push_back(player);
+	}
+
+	static std::vector<std::pair<BASE_OBJECT *, BASE_OBJECT *>> seenEvents[MAX_PLAYERS];  // static to avoid allocations.
+	parallelFor(groups.size(), [&](unsigned group) {
+		for (int player : groups[group])
+		{
+			seenEvents[player].clear();
+			BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player]};
+			for (unsigned list = 0; list < sizeof(lists) / sizeof(*lists); ++list)
 			{
-				if (psObj != psTarget && psTarget->visible[psObj->player] < UBYTE_MAX / 2
-				    && objActiveRadar(psTarget)
-				    && iHypot((psTarget->pos - psObj->pos).xy()) < objSensorRange(psObj) * 10)
+				for (BASE_OBJECT *psObj = lists[list]; psObj != nullptr; psObj = psObj->psNext)
 				{
-					psTarget->visible[psObj->player] = UBYTE_MAX / 2;
+					processVisibilityVision(psObj, seenEvents[player]);
 				}
 			}
 		}
+	});
+
+	// Trigger script events in the same order as if all players were processed in order on a single thread.
+	for (int player = 0; player < MAX_PLAYERS; ++player)
+	{
+		for (auto const &seen : seenEvents[player])
+		{
+			triggerEventSeen(seen.first, seen.second);
+		}
 	}
+
+	processVisibilityRadarDetectors();
 	for (int player = 0; player < MAX_PLAYERS; ++player)
 	{
 		BASE_OBJECT *lists[] = {apsDroidLists[player], apsStructLists[player], apsFeatureLists[player]};
@@ -815,36 +993,21 @@ void	setUnderTilesVis(BASE_OBJECT *psObj, UDWORD player)
 	}
 }
 
-//forward declaration
+//forward declarations
+static Vector3i fireLineMuzzle(const SIMPLE_OBJECT *psViewer, int weapon_slot);
 static int checkFireLine(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int weapon_slot, bool wallsBlock, bool direct);
+static int checkFireLineFrom(Vector3i muzzle, const BASE_OBJECT *psTarget, bool wallsBlock, bool direct);
 
-/**
- * Check whether psViewer can fire directly at psTarget.
- * psTarget can be any type of BASE_OBJECT (e.g. a tree).
- */
-bool lineOfFire(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int weapon_slot, bool wallsBlock)
+/// Does the work of lineOfFire, given the shooter's weapon and muzzle position.
+static bool lineOfFireFrom(const SIMPLE_OBJECT *psViewer, WEAPON_STATS *psStats, Vector3i muzzle, const BASE_OBJECT *psTarget, bool wallsBlock)
 {
-	WEAPON_STATS *psStats = nullptr;
-
-	ASSERT_OR_RETURN(false, psViewer != nullptr, "Invalid shooter pointer!");
-	ASSERT_OR_RETURN(false, psTarget != nullptr, "Invalid target pointer!");
-	ASSERT_OR_RETURN(false, psViewer->type == OBJ_DROID || psViewer->type == OBJ_STRUCTURE, "Bad viewer type");
-
-	if (psViewer->type == OBJ_DROID)
-	{
-		psStats = asWeaponStats + ((const DROID *)psViewer)->asWeaps[weapon_slot].nStat;
-	}
-	else if (psViewer->type == OBJ_STRUCTURE)
-	{
-		psStats = asWeaponStats + ((const STRUCTURE *)psViewer)->asWeaps[weapon_slot].nStat;
-	}
 	// 2d distance
 	int distance = iHypot((psTarget->pos - psViewer->pos).xy());
 	int range = proj_GetLongRange(psStats, psViewer->player);
 	if (proj_Direct(psStats))
 	{
 		/** direct shots could collide with ground **/
-		return range >= distance && LINE_OF_FIRE_MINIMUM <= checkFireLine(psViewer, psTarget, weapon_slot, wallsBlock, true);
+		return range >= distance && LINE_OF_FIRE_MINIMUM <= checkFireLineFrom(muzzle, psTarget, wallsBlock, true);
 	}
 	else
 	{
@@ -852,7 +1015,7 @@ bool lineOfFire(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int
 		 * indirect shots always have a line of fire, IF the forced
 		 * minimum angle doesn't move it out of range
 		 **/
-		int min_angle = checkFireLine(psViewer, psTarget, weapon_slot, wallsBlock, false);
+		int min_angle = checkFireLineFrom(muzzle, psTarget, wallsBlock, false);
 		// NOTE This code seems similar to the code in combFire in combat.cpp.
 		if (min_angle > DEG(PROJ_MAX_PITCH))
 		{
@@ -865,6 +1028,47 @@ bool lineOfFire(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int
 	}
 }
 
+static WEAPON_STATS *lineOfFireStats(const SIMPLE_OBJECT *psViewer, int weapon_slot)
+{
+	if (psViewer->type == OBJ_DROID)
+	{
+		return asWeaponStats + ((const DROID *)psViewer)->asWeaps[weapon_slot].nStat;
+	}
+	return asWeaponStats + ((const STRUCTURE *)psViewer)->asWeaps[weapon_slot].nStat;
+}
+
+/**
+ * Check whether psViewer can fire directly at psTarget.
+ * psTarget can be any type of BASE_OBJECT (e.g. a tree).
+ */
+bool lineOfFire(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int weapon_slot, bool wallsBlock)
+{
+	ASSERT_OR_RETURN(false, psViewer != nullptr, "Invalid shooter pointer!");
+	ASSERT_OR_RETURN(false, psTarget != nullptr, "Invalid target pointer!");
+	ASSERT_OR_RETURN(false, psViewer->type == OBJ_DROID || psViewer->type == OBJ_STRUCTURE, "Bad viewer type");
+
+	return lineOfFireFrom(psViewer, lineOfFireStats(psViewer, weapon_slot), fireLineMuzzle(psViewer, weapon_slot), psTarget, wallsBlock);
+}
+
+void lineOfFireBatch(const SIMPLE_OBJECT *psViewer, BASE_OBJECT *const *targets, size_t numTargets, int weapon_slot, bool wallsBlock, uint8_t *canFire)
+{
+	std::fill(canFire, canFire + numTargets, false);
+	ASSERT_OR_RETURN(, psViewer != nullptr, "Invalid shooter pointer!");
+	ASSERT_OR_RETURN(, psViewer->type == OBJ_DROID || psViewer->type == OBJ_STRUCTURE, "Bad viewer type");
+
+	if (numTargets == 0)
+	{
+		return;
+	}
+	WEAPON_STATS *psStats = lineOfFireStats(psViewer, weapon_slot);
+	Vector3i muzzle = fireLineMuzzle(psViewer, weapon_slot);
+	for (size_t i = 0; i < numTargets; ++i)
+	{
+		ASSERT_OR_RETURN(, targets[i] != nullptr, "Invalid target pointer!");
+		canFire[i] = lineOfFireFrom(psViewer, psStats, muzzle, targets[i], wallsBlock);
+	}
+}
+
 /* Check how much of psTarget is hitable from psViewer's gun position */
 int areaOfFire(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int weapon_slot, bool wallsBlock)
 {
@@ -914,24 +1118,25 @@ static inline void angle_check(int64_t *angletan, int positionSq, int height, in
 	*angletan = std::max(*angletan, current);
 }
 
-/**
- * Check fire line from psViewer to psTarget
- * psTarget can be any type of BASE_OBJECT (e.g. a tree).
- */
-static int checkFireLine(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int weapon_slot, bool wallsBlock, bool direct)
+/* helper function for checkFireLine, which only looks up the terrain height at point where it could make a difference */
+static inline void terrain_angle_check(int64_t *angletan, int positionSq, Vector2i point, int z, int distanceSq, int targetHeight, bool direct)
 {
-	Vector3i pos(0, 0, 0), dest(0, 0, 0);
-	Vector2i start(0, 0), diff(0, 0), current(0, 0), halfway(0, 0), next(0, 0), part(0, 0);
-	Vector3i muzzle(0, 0, 0);
-	int distSq, partSq, oldPartSq;
-	int64_t angletan;
-
-	ASSERT(psViewer != nullptr, "Invalid shooter pointer!");
-	ASSERT(psTarget != nullptr, "Invalid target pointer!");
-	if (!psViewer || !psTarget)
+	if (direct)
 	{
-		return -1;
+		// The terrain at point is at most one above the highest corner of its tile, and lower terrain can't give a steeper angle.
+		int64_t steepest = (65536 * (map_TileMaxHeight(map_coord(point.x), map_coord(point.y)) + 1 - z)) / iSqrt(positionSq);
+		if (steepest <= *angletan)
+		{
+			return;
+		}
 	}
+	angle_check(angletan, positionSq, map_Height(point) - z, distanceSq, targetHeight, direct);
+}
+
+/* Get the position psViewer fires weapon_slot from */
+static Vector3i fireLineMuzzle(const SIMPLE_OBJECT *psViewer, int weapon_slot)
+{
+	Vector3i muzzle(0, 0, 0);
 
 	/* CorvusCorax: get muzzle offset (code from projectile.c)*/
 	if (psViewer->type == OBJ_DROID && weapon_slot >= 0)
@@ -946,6 +1151,32 @@ static int checkFireLine(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTar
 	{
 		muzzle = psViewer->pos;
 	}
+	return muzzle;
+}
+
+/**
+ * Check fire line from psViewer to psTarget
+ * psTarget can be any type of BASE_OBJECT (e.g. a tree).
+ */
+static int checkFireLine(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int weapon_slot, bool wallsBlock, bool direct)
+{
+	ASSERT(psViewer != nullptr, "Invalid shooter pointer!");
+	ASSERT(psTarget != nullptr, "Invalid target pointer!");
+	if (!psViewer || !psTarget)
+	{
+		return -1;
+	}
+
+	return checkFireLineFrom(fireLineMuzzle(psViewer, weapon_slot), psTarget, wallsBlock, direct);
+}
+
+/* Check fire line from muzzle to psTarget */
+static int checkFireLineFrom(Vector3i muzzle, const BASE_OBJECT *psTarget, bool wallsBlock, bool direct)
+{
+	Vector3i pos(0, 0, 0), dest(0, 0, 0);
+	Vector2i start(0, 0), diff(0, 0), current(0, 0), halfway(0, 0), next(0, 0), part(0, 0);
+	int distSq, partSq, oldPartSq;
+	int64_t angletan;
 
 	pos = muzzle;
 	dest = psTarget->pos;
@@ -971,7 +1202,7 @@ static int checkFireLine(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTar
 
 		if (partSq > 0)
 		{
-			angle_check(&angletan, partSq, map_Height(current) - pos.z, distSq, dest.z - pos.z, direct);
+			terrain_angle_check(&angletan, partSq, current, pos.z, distSq, dest.z - pos.z, direct);
 		}
 
 		// intersect current tile with line of fire
@@ -991,7 +1222,7 @@ static int checkFireLine(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTar
 
 			if (partSq > 0)
 			{
-				angle_check(&angletan, partSq, map_Height(halfway) - pos.z, distSq, dest.z - pos.z, direct);
+				terrain_angle_check(&angletan, partSq, halfway, pos.z, distSq, dest.z - pos.z, direct);
 			}
 		}
 
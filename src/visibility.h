@@ -45,6 +45,10 @@ int visibleObject(const BASE_OBJECT *psViewer, const BASE_OBJECT *psTarget, bool
 /** Can shooter hit target with direct fire weapon? */
 bool lineOfFire(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int weapon_slot, bool wallsBlock);
 
+/** Does lineOfFire for each of numTargets targets, setting canFire[i] for targets[i]. Works out the weapon and where it
+ *  fires from once for all the targets, so cheaper than calling lineOfFire for each one. */
+void lineOfFireBatch(const SIMPLE_OBJECT *psViewer, BASE_OBJECT *const *targets, size_t numTargets, int weapon_slot, bool wallsBlock, uint8_t *canFire);
+
 /** How much of target can the player hit with direct fire weapon? */
 int areaOfFire(const SIMPLE_OBJECT *psViewer, const BASE_OBJECT *psTarget, int weapon_slot, bool wallsBlock);
 
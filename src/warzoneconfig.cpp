@@ -58,6 +58,7 @@ struct WARZONE_GLOBALS
 	int cameraSpeed = CAMERASPEED_DEFAULT;
 	int scrollEvent = 0; // map/radar zoom
 	bool radarJump = false;
+	int pathThreads = 0;  // 0 = choose based on number of cores
 };
 
 static WARZONE_GLOBALS warGlobs;
@@ -210,6 +211,16 @@ bool war_GetPauseOnFocusLoss()
 	return warGlobs.pauseOnFocusLoss;
 }
 
+void war_SetPathThreads(int threads)
+{
+	warGlobs.pathThreads = MAX(threads, 0);
+}
+
+int war_GetPathThreads()
+{
+	return warGlobs.pathThreads;
+}
+
 void war_SetColouredCursor(bool enabled)
 {
 	warGlobs.ColouredCursor = enabled;
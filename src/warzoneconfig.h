@@ -75,6 +75,8 @@ void war_SetHeight(UDWORD height);
 UDWORD war_GetHeight();
 void war_SetPauseOnFocusLoss(bool enabled);
 bool war_GetPauseOnFocusLoss();
+void war_SetPathThreads(int threads);  ///< Number of path-finding threads, 0 for automatic. Takes effect when the path-finding module is initialised.
+int war_GetPathThreads();
 bool war_GetMusicEnabled();
 void war_SetMusicEnabled(bool enabled);
 int war_GetMapZoom();
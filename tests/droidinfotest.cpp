@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "lib/framework/frame.h"
+#include "lib/netplay/netplay.h"
+#include "src/droidinfo.h"
+
+// --- dummy rendering library implementation ----
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+int wzGetTicks()
+{
+	return 1;
+}
+
+void inputInitialise()
+{
+}
+
+// --- dummy netplay implementation ----
+
+bool NETsend(NETQUEUE, NetMessageRef)
+{
+	return true;
+}
+
+void NETlogPacket(uint8_t, uint32_t, bool)
+{
+}
+
+const char *messageTypeToString(unsigned)
+{
+	return "";
+}
+
+// --- end linking hacks ---
+
+static uint32_t testRandom()
+{
+	static uint32_t state = 12345;
+	state = state * 1103515245 + 12345;
+	return state >> 8;
+}
+
+static QueuedDroidInfo randomOrder()
+{
+	QueuedDroidInfo info;
+	info.player = testRandom() % 2;
+	info.subType = SubType(testRandom() % 3);
+	switch (info.subType)
+	{
+	case ObjOrder:
+		info.order = DORDER_ATTACK;
+		info.destId = testRandom() % 3 * 2 + 501;
+		info.destType = OBJ_STRUCTURE;
+		break;
+	case LocOrder:
+		info.order = testRandom() % 2 ? DORDER_MOVE : DORDER_SCOUT;
+		info.pos = Vector2i(1000 + testRandom() % 3 * 128, 2000 + testRandom() % 3 * 64);
+		break;
+	case SecondaryOrder:
+		info.secOrder = DSO_ATTACK_LEVEL;
+		info.secState = testRandom() % 2 ? DSS_ALEV_ALWAYS : DSS_ALEV_NEVER;
+		break;
+	}
+	info.add = testRandom() % 4 == 0;
+	return info;
+}
+
+// Writes a secondary order the way NETencodeDroidInfo writes a new order, for building bad messages.
+static void encodeSecondaryOrder(QueuedDroidInfo *info)
+{
+	uint32_t ref = 0;
+	NETuint32_t(&ref);
+	NETuint8_t(&info->player);
+	NETenum(&info->subType);
+	NETenum(&info->secOrder);
+	NETenum(&info->secState);
+}
+
+static bool sameTemplates(std::vector<QueuedDroidInfo> const &a, std::vector<QueuedDroidInfo> const &b)
+{
+	return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), [](QueuedDroidInfo const &x, QueuedDroidInfo const &y) { return x.orderCompare(y) == 0; });
+}
+
+// Sends the orders through the queue, and returns whether they were all decoded for the same droids, with the sender's and receiver's templates still the same.
+static bool roundTrip(NETQUEUE queue, std::vector<QueuedDroidInfo> const &sent, std::vector<QueuedDroidInfo> &sentTemplates, std::vector<QueuedDroidInfo> &receivedTemplates, size_t *numBytes)
+{
+	std::vector<DroidInfoOrder> orders;
+	NETbeginEncode(queue, GAME_DROIDINFO);
+	NETencodeDroidInfo(sent, sentTemplates);
+	NETend();
+
+	*numBytes += NETgetMessage(queue).rawLen();
+	NETbeginDecode(queue, GAME_DROIDINFO);
+	bool valid = NETdecodeDroidInfo(orders, receivedTemplates);
+	NETend();
+	NETpop(queue);
+
+	std::vector<QueuedDroidInfo> received;
+	for (DroidInfoOrder const &order : orders)
+	{
+		QueuedDroidInfo info = order.info;
+		for (DroidIdRun const &run : order.runs)
+		{
+			for (uint32_t n = 0; n < run.count; ++n)
+			{
+				info.droidId = run.firstId + 2 * n;
+				received.push_back(info);
+			}
+		}
+	}
+	std::sort(received.begin(), received.end());
+
+	bool same = valid && received.size() == sent.size();
+	for (size_t n = 0; same && n < sent.size(); ++n)
+	{
+		same = sent[n].orderCompare(received[n]) == 0 && sent[n].droidId == received[n].droidId;
+	}
+	return same && sameTemplates(sentTemplates, receivedTemplates);
+}
+
+// Sends random bursts of droid orders through a game queue, and checks that every order is decoded for the same droids.
+// Droid IDs are mostly odd, like synchronised object IDs, with a few even ones.
+int main(void)
+{
+	NETinitQueue(NETgameQueue(0));
+	NETQUEUE queue = NETgameQueue(0);
+	NETsetNoSendOverNetwork(queue);
+
+	std::vector<QueuedDroidInfo> sentTemplates, receivedTemplates;
+	std::vector<DroidInfoOrder> orders;
+	size_t numDroidOrders = 0, numBytes = 0;
+	int failures = 0;
+
+	for (int tick = 0; tick < 2000; ++tick)
+	{
+		std::vector<QueuedDroidInfo> sent;
+		for (int group = testRandom() % 4; group > 0; --group)
+		{
+			QueuedDroidInfo info = randomOrder();
+			uint32_t droidId = 10001 + testRandom() % 100 * 2;
+			for (int droid = 1 + testRandom() % 150; droid > 0; --droid)
+			{
+				droidId += testRandom() % 3 == 0 ? 2 + testRandom() % 40 * 2 : 2;
+				info.droidId = droidId + (testRandom() % 50 == 0);
+				sent.push_back(info);
+			}
+		}
+		std::sort(sent.begin(), sent.end());
+		sent.erase(std::unique(sent.begin(), sent.end(), [](QueuedDroidInfo const &a, QueuedDroidInfo const &b) { return !(a < b) && !(b < a); }), sent.end());
+
+		if (!roundTrip(queue, sent, sentTemplates, receivedTemplates, &numBytes))
+		{
+			if (failures < 10)
+			{
+				fprintf(stderr, "droidinfotest: tick %d: %u droid orders not received the same\n", tick, (unsigned)sent.size());
+			}
+			++failures;
+		}
+		numDroidOrders += sent.size();
+	}
+
+	// Starting from empty templates, as after resetQueuedDroidInfo, send one move order, then repeat it and keep changing only
+	// its position, as when spamming move orders. Each message after the first must refer to the template instead of sending
+	// the order in full again.
+	sentTemplates.clear();
+	receivedTemplates.clear();
+	QueuedDroidInfo move;
+	move.player = 0;
+	move.subType = LocOrder;
+	move.order = DORDER_MOVE;
+	move.pos = Vector2i(3000, 4000);
+	move.add = false;
+	move.droidId = 20001;
+	size_t firstBytes = 0;
+	if (!roundTrip(queue, {move}, sentTemplates, receivedTemplates, &firstBytes))
+	{
+		fprintf(stderr, "droidinfotest: new order not received the same\n");
+		++failures;
+	}
+	for (int repeat = 0; repeat < 40; ++repeat)
+	{
+		if (repeat % 2 != 0)
+		{
+			move.pos += Vector2i(repeat * 16, -repeat * 8);
+		}
+		size_t bytes = 0;
+		if (!roundTrip(queue, {move}, sentTemplates, receivedTemplates, &bytes))
+		{
+			fprintf(stderr, "droidinfotest: %s order %d not received the same\n", repeat % 2 != 0 ? "moved" : "repeated", repeat);
+			++failures;
+		}
+		if (bytes >= firstBytes || sentTemplates.empty() || sentTemplates[0].pos != move.pos)
+		{
+			fprintf(stderr, "droidinfotest: %s order %d not sent as a template reference\n", repeat % 2 != 0 ? "moved" : "repeated", repeat);
+			++failures;
+		}
+	}
+
+	// A message with a run longer than DROIDINFO_MAX_DROIDS must be rejected as a whole, without changing the templates.
+	std::vector<QueuedDroidInfo> templatesBefore = receivedTemplates;
+	NETbeginEncode(queue, GAME_DROIDINFO);
+	uint8_t format = DROIDINFO_FORMAT;
+	uint32_t numOrders = 2, numRuns = 1, runDelta = 10001, runLength = DROIDINFO_MAX_DROIDS;
+	QueuedDroidInfo info = randomOrder();
+	info.subType = SecondaryOrder;
+	NETuint8_t(&format);
+	NETuint32_t(&numOrders);
+	encodeSecondaryOrder(&info);
+	NETuint32_t(&numRuns);
+	NETuint32_t(&runDelta);
+	NETuint32_t(&runLength);
+	NETend();
+	NETbeginDecode(queue, GAME_DROIDINFO);
+	bool valid = NETdecodeDroidInfo(orders, receivedTemplates);
+	NETend();
+	NETpop(queue);
+	if (valid || !sameTemplates(receivedTemplates, templatesBefore))
+	{
+		fprintf(stderr, "droidinfotest: overlong run not rejected cleanly\n");
+		++failures;
+	}
+
+	// Many runs of the most droids allowed in one run, which add up to far more than DROIDINFO_MAX_DROIDS, must be rejected too.
+	NETbeginEncode(queue, GAME_DROIDINFO);
+	numOrders = 100;
+	numRuns = 10;
+	runLength = DROIDINFO_MAX_DROIDS - 1;
+	NETuint8_t(&format);
+	NETuint32_t(&numOrders);
+	for (uint32_t order = 0; order < numOrders; ++order)
+	{
+		encodeSecondaryOrder(&info);
+		for (int parity = 0; parity < 2; ++parity)
+		{
+			NETuint32_t(&numRuns);
+			for (uint32_t run = 0; run < numRuns; ++run)
+			{
+				NETuint32_t(&runDelta);
+				NETuint32_t(&runLength);
+			}
+		}
+	}
+	NETend();
+	NETbeginDecode(queue, GAME_DROIDINFO);
+	valid = NETdecodeDroidInfo(orders, receivedTemplates);
+	NETend();
+	NETpop(queue);
+	if (valid || !sameTemplates(receivedTemplates, templatesBefore))
+	{
+		fprintf(stderr, "droidinfotest: message for %u droids not rejected cleanly\n", numOrders * 2 * numRuns * (runLength + 1));
+		++failures;
+	}
+
+	// Messages claiming more orders or runs than could fit in them must be rejected before decoding them.
+	for (int claim = 0; claim < 2; ++claim)
+	{
+		NETbeginEncode(queue, GAME_DROIDINFO);
+		numOrders = claim == 0 ? 1000000000 : 1;
+		numRuns = 1000000000;
+		NETuint8_t(&format);
+		NETuint32_t(&numOrders);
+		encodeSecondaryOrder(&info);
+		NETuint32_t(&numRuns);
+		NETend();
+		NETbeginDecode(queue, GAME_DROIDINFO);
+		valid = NETdecodeDroidInfo(orders, receivedTemplates);
+		NETend();
+		NETpop(queue);
+		if (valid || orders.size() > 1 || !sameTemplates(receivedTemplates, templatesBefore))
+		{
+			fprintf(stderr, "droidinfotest: oversized claim %d not rejected\n", claim);
+			++failures;
+		}
+	}
+
+	printf("droidinfotest: %u droid orders in %u bytes, %d failures\n", (unsigned)numDroidOrders, (unsigned)numBytes, failures);
+	return failures != 0;
+}
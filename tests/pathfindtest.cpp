@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <vector>
+#include "lib/framework/frame.h"
+#include "lib/gamelib/gtime.h"
+#include "src/astar.h"
+#include "src/map.h"
+
+// --- dummy rendering library implementation ----
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+int wzGetTicks()
+{
+	return 1;
+}
+
+void inputInitialise()
+{
+}
+
+// --- dummy map implementation ----
+
+#define TEST_MAP_WIDTH  24
+#define TEST_MAP_HEIGHT 16
+#define TEST_PLAYER     1
+
+SDWORD mapWidth = TEST_MAP_WIDTH, mapHeight = TEST_MAP_HEIGHT;
+SDWORD scrollMinX = 0, scrollMaxX = TEST_MAP_WIDTH, scrollMinY = 0, scrollMaxY = TEST_MAP_HEIGHT;
+uint8_t *psAuxMap[MAX_PLAYERS];
+uint32_t auxMapVersion = 1;
+UDWORD gameTime = 1000;
+static uint8_t testAuxMap[TEST_MAP_WIDTH * TEST_MAP_HEIGHT];
+
+bool fpathBaseBlockingTile(SDWORD x, SDWORD y, PROPULSION_TYPE, int, FPATH_MOVETYPE)
+{
+	return x < 0 || y < 0 || x >= mapWidth || y >= mapHeight;
+}
+
+bool fpathIsEquivalentBlocking(PROPULSION_TYPE propulsion1, int player1, FPATH_MOVETYPE moveType1,
+                               PROPULSION_TYPE propulsion2, int player2, FPATH_MOVETYPE moveType2)
+{
+	return propulsion1 == propulsion2 && player1 == player2 && moveType1 == moveType2;
+}
+
+bool isHumanPlayer(int)
+{
+	return false;  // Only AI players avoid danger.
+}
+
+// --- dummy netplay implementation ----
+
+void _syncDebug(const char *, const char *, ...)
+{
+}
+
+void _syncDebugNoArgs(const char *, const char *)
+{
+}
+
+void _syncDebugInts(const char *, const char *, int *, size_t)
+{
+}
+
+// --- end linking hacks ---
+
+static bool testDangerous(Vector2i tile)
+{
+	return (testAuxMap[tile.x + tile.y * TEST_MAP_WIDTH] & AUXBITS_THREAT) != 0;
+}
+
+#define TEST_DANGER_TOP    4
+#define TEST_DANGER_BOTTOM 12
+
+/// Returns the number of points along the route which are in dangerous tiles, and whether it passes above and below the danger.
+static int testCheckRoute(char const *name, std::vector<Vector2i> const &path, bool *above, bool *below)
+{
+	int dangerous = 0;
+	*above = false;
+	*below = false;
+	for (Vector2i const &p : path)
+	{
+		Vector2i tile = map_coord(p);
+		dangerous += testDangerous(tile);
+		*above |= tile.y < TEST_DANGER_TOP;
+		*below |= tile.y > TEST_DANGER_BOTTOM;
+	}
+	printf("pathfindtest: %s route has %u points, %d dangerous\n", name, (unsigned)path.size(), dangerous);
+	return dangerous;
+}
+
+// Finds a route past a dangerous area with the A* and with a flow field, and checks that both go around it on the same side.
+// The way below is shorter than the way above, and both are much cheaper than going through the danger.
+int main(void)
+{
+	for (int y = TEST_DANGER_TOP; y <= TEST_DANGER_BOTTOM; ++y)
+	{
+		for (int x = 10; x <= 13; ++x)
+		{
+			testAuxMap[x + y * TEST_MAP_WIDTH] |= AUXBITS_THREAT;
+		}
+	}
+	psAuxMap[TEST_PLAYER] = testAuxMap;
+
+	PATHJOB job;
+	job.propulsion = PROPULSION_TYPE_WHEELED;
+	job.droidType = DROID_WEAPON;
+	job.origX = world_coord(3) + TILE_UNITS / 2;
+	job.origY = world_coord(10) + TILE_UNITS / 2;
+	job.destX = world_coord(20) + TILE_UNITS / 2;
+	job.destY = world_coord(10) + TILE_UNITS / 2;
+	job.dstStructure = StructureBounds();
+	job.droidID = 1;
+	job.moveType = FMT_MOVE;
+	job.owner = TEST_PLAYER;
+	job.acceptNearest = true;
+	job.deleted = false;
+	fpathSetBlockingMap(&job);
+	unsigned lane = fpathJobLane(&job);
+
+	int failures = 0;
+
+	MOVE_CONTROL aStarMove;
+	job.groupMove = false;
+	if (fpathAStarRoute(&aStarMove, &job, lane) != ASR_OK)
+	{
+		fprintf(stderr, "pathfindtest: A* found no route\n");
+		++failures;
+	}
+
+	MOVE_CONTROL flowFieldMove;
+	job.groupMove = true;
+	if (fpathAStarRoute(&flowFieldMove, &job, lane) != ASR_OK)
+	{
+		fprintf(stderr, "pathfindtest: flow field found no route\n");
+		++failures;
+	}
+
+	bool aStarAbove, aStarBelow, flowFieldAbove, flowFieldBelow;
+	int aStarDangerous = testCheckRoute("A*", aStarMove.asPath, &aStarAbove, &aStarBelow);
+	int flowFieldDangerous = testCheckRoute("flow field", flowFieldMove.asPath, &flowFieldAbove, &flowFieldBelow);
+	if (aStarDangerous != 0 || flowFieldDangerous != 0)
+	{
+		fprintf(stderr, "pathfindtest: route goes through danger\n");
+		++failures;
+	}
+	if (aStarAbove || !aStarBelow || flowFieldAbove || !flowFieldBelow)
+	{
+		fprintf(stderr, "pathfindtest: routes don't both take the shorter way below the danger\n");
+		++failures;
+	}
+
+	fpathHardTableReset();
+	printf("pathfindtest: %d failures\n", failures);
+	return failures != 0;
+}
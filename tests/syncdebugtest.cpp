@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <limits.h>
+#include <string.h>
+#include "lib/framework/frame.h"
+#include "lib/netplay/netplay.h"
+#include "lib/netplay/syncdebug.h"
+
+// --- dummy rendering library implementation ----
+
+void wzToggleFullscreen()
+{
+}
+
+bool wzIsFullscreen()
+{
+	return false;
+}
+
+void wzFatalDialog(char const*)
+{
+}
+
+int wzGetTicks()
+{
+	return 1;
+}
+
+void inputInitialise()
+{
+}
+
+// --- dummy netplay implementation, recording which way each syncDebug call went ----
+
+enum TestSyncDebugPath
+{
+	TEST_PATH_NONE,
+	TEST_PATH_VARARGS,
+	TEST_PATH_NOARGS,
+	TEST_PATH_INTS,
+	TEST_PATH_INTLIST,
+};
+
+static TestSyncDebugPath testPath = TEST_PATH_NONE;
+static char const *testStr = nullptr;
+static int testInts[SYNC_DEBUG_MAX_INTS];
+static size_t testNumInts = 0;
+
+void _syncDebug(const char *, const char *str, ...)
+{
+	testPath = TEST_PATH_VARARGS;
+	testStr = str;
+}
+
+void _syncDebugNoArgs(const char *, const char *str)
+{
+	testPath = TEST_PATH_NOARGS;
+	testStr = str;
+}
+
+static void testRecordInts(TestSyncDebugPath path, const char *str, int *ints, size_t numInts)
+{
+	testPath = path;
+	testStr = str;
+	testNumInts = std::min<size_t>(numInts, SYNC_DEBUG_MAX_INTS);
+	std::copy(ints, ints + testNumInts, testInts);
+}
+
+void _syncDebugInts(const char *, const char *str, int *ints, size_t numInts)
+{
+	testRecordInts(TEST_PATH_INTS, str, ints, numInts);
+}
+
+void _syncDebugIntList(const char *, const char *str, int *ints, size_t numInts)
+{
+	testRecordInts(TEST_PATH_INTLIST, str, ints, numInts);
+}
+
+// --- end linking hacks ---
+
+static int failures = 0;
+
+/// Formats the same way _syncDebug does.
+static void testReference(char (&buf)[MAX_LEN_LOG_LINE], char const *str, ...) WZ_DECL_FORMAT(printf, 2, 3);
+static void testReference(char (&buf)[MAX_LEN_LOG_LINE], char const *str, ...)
+{
+	va_list ap;
+	va_start(ap, str);
+	vssprintf(buf, str, ap);
+	va_end(ap);
+}
+
+static void testCheckPath(char const *what, TestSyncDebugPath expected)
+{
+	if (testPath != expected)
+	{
+		fprintf(stderr, "syncdebugtest: %s took path %d, expected %d\n", what, testPath, expected);
+		++failures;
+	}
+	testPath = TEST_PATH_NONE;
+}
+
+// Calls syncDebug, checks that it took the int path, and that rendering the stored ints later gives the same text as formatting the call directly.
+#define TEST_RENDER(...) \
+	do { \
+		syncDebug(__VA_ARGS__); \
+		testCheckPath(#__VA_ARGS__, TEST_PATH_INTS); \
+		char expected[MAX_LEN_LOG_LINE]; \
+		char rendered[MAX_LEN_LOG_LINE]; \
+		testReference(expected, __VA_ARGS__); \
+		syncDebugSnprintInts(rendered, sizeof(rendered), testStr, testInts, testNumInts); \
+		if (strcmp(expected, rendered) != 0) \
+		{ \
+			fprintf(stderr, "syncdebugtest: %s rendered \"%s\", expected \"%s\"\n", #__VA_ARGS__, rendered, expected); \
+			++failures; \
+		} \
+	} while(0)
+
+enum TestEnum
+{
+	TEST_ENUM_A,
+	TEST_ENUM_B = 7,
+};
+
+// Checks that syncDebug calls are stored the cheap way when they can be, that they are later rendered the same as if formatted at once, and that the CRC depends on the format string.
+int main(void)
+{
+	// Which calls take the int path.
+	syncDebug("%d", 1);
+	testCheckPath("int", TEST_PATH_INTS);
+	syncDebug("%d %u %c %d", 1, 2u, 'c', TEST_ENUM_B);
+	testCheckPath("int, unsigned, char and enum", TEST_PATH_INTS);
+	syncDebug("%d %s", 1, "str");
+	testCheckPath("int and string", TEST_PATH_VARARGS);
+	syncDebug("%" PRId64, (int64_t)1);
+	testCheckPath("64-bit int", TEST_PATH_VARARGS);
+	syncDebug("%d %" PRIu64, 1, (uint64_t)1);
+	testCheckPath("int and 64-bit int", TEST_PATH_VARARGS);
+	syncDebug("%f", 1.0);
+	testCheckPath("double", TEST_PATH_VARARGS);
+	syncDebug("100%%");
+	testCheckPath("no arguments", TEST_PATH_NOARGS);
+
+	// Rendering the stored ints later.
+	TEST_RENDER("%d", -5);
+	TEST_RENDER("x = %d, y = %d", 100, -200);
+	TEST_RENDER("%u", UINT_MAX);
+	TEST_RENDER("%u", (unsigned)INT_MAX + 1);
+	TEST_RENDER("%c%c%c", 'a', 'b', 'c');
+	TEST_RENDER("%d %d", TEST_ENUM_A, TEST_ENUM_B);
+	TEST_RENDER("%d%% %x", 50, 0xBEEFu);
+
+	// Calls without arguments are stored as text, with "%%" unescaped.
+	char unescaped[MAX_LEN_LOG_LINE];
+	char expected[MAX_LEN_LOG_LINE];
+	syncDebugUnescape(unescaped, sizeof(unescaped), "100%% done, %%%% left");
+	testReference(expected, "100%% done, %%%% left");
+	if (strcmp(unescaped, expected) != 0)
+	{
+		fprintf(stderr, "syncdebugtest: unescaped \"%s\", expected \"%s\"\n", unescaped, expected);
+		++failures;
+	}
+
+	// The same values with a different format string must give a different CRC, except for _syncDebugIntList, which leaves out the strings.
+	int values[2] = {3, 4};
+	if (syncDebugCrcInts(0, "main", "a %d %d", values, 2, true) == syncDebugCrcInts(0, "main", "b %d %d", values, 2, true))
+	{
+		fprintf(stderr, "syncdebugtest: CRC doesn't depend on the format string\n");
+		++failures;
+	}
+	if (syncDebugCrcInts(0, "main", "a %d %d", values, 2, false) != syncDebugCrcInts(0, "main", "b %d %d", values, 2, false))
+	{
+		fprintf(stderr, "syncdebugtest: CRC of int list depends on the format string\n");
+		++failures;
+	}
+	int otherValues[2] = {3, 5};
+	if (syncDebugCrcInts(0, "main", "a %d %d", values, 2, true) == syncDebugCrcInts(0, "main", "a %d %d", otherValues, 2, true))
+	{
+		fprintf(stderr, "syncdebugtest: CRC doesn't depend on the values\n");
+		++failures;
+	}
+
+	printf("syncdebugtest: %d failures\n", failures);
+	return failures != 0;
+}